@@ -0,0 +1,393 @@
+/**
+ * 多传感器历史数据批量帧编解码
+ * 温度变化缓慢，相邻样本的增量多为0或±1，按行选择最小位宽紧密排列，只有跳变时才退回varint
+ */
+
+#include "batch_frame.h"
+#include <string.h>
+
+// CRC16-Modbus (多项式0xA001，初值0xFFFF)
+uint16_t BatchFrame_Crc16(const uint8_t *data, uint16_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = (crc & 0x0001) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+// 写入无符号varint，返回写入字节数，空间不足返回0
+static uint8_t batch_put_varint(uint8_t *p, uint16_t room, uint32_t value)
+{
+    uint8_t n = 0;
+
+    do {
+        if (n >= room) {
+            return 0;
+        }
+        p[n] = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if (value != 0) {
+            p[n] |= 0x80;
+        }
+        n++;
+    } while (value != 0);
+    return n;
+}
+
+// 读取无符号varint，返回读取字节数，越界或超过5字节返回0
+static uint8_t batch_get_varint(const uint8_t *p, uint16_t room, uint32_t *value)
+{
+    uint32_t v = 0;
+
+    for (uint8_t n = 0; n < 5 && n < room; n++) {
+        v |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80)) {
+            *value = v;
+            return (uint8_t)(n + 1);
+        }
+    }
+    return 0;
+}
+
+static uint32_t batch_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t batch_unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// 各宽度码对应的位宽，BATCH_WIDTH_VARINT表示逐个varint
+#define BATCH_WIDTH_VARINT  4
+static const uint8_t batch_width_bits[BATCH_WIDTH_VARINT] = { 0, 2, 4, 8 };
+
+// 开始一帧，缓冲区至少要容纳帧头和CRC
+uint8_t BatchFrame_Begin(batch_encoder_t *enc, uint8_t *buf, uint16_t cap, uint8_t positions,
+                         uint32_t base_tick, uint16_t period)
+{
+    if (positions == 0 || positions > BATCH_FRAME_MAX_POSITIONS ||
+        cap < BATCH_FRAME_HEADER_SIZE + BATCH_FRAME_CRC_SIZE) {
+        return 0;
+    }
+
+    memset(enc, 0, sizeof(*enc));
+    enc->buf = buf;
+    enc->cap = cap;
+    enc->positions = positions;
+    enc->period = period;
+    enc->last_tick = base_tick;
+    enc->last_mask = (positions < 32) ? ((1UL << positions) - 1) : 0xFFFFFFFFUL;
+
+    buf[0] = BATCH_FRAME_MAGIC;
+    buf[1] = BATCH_FRAME_VERSION;
+    buf[2] = positions;
+    buf[3] = 0;
+    buf[4] = (uint8_t)base_tick;
+    buf[5] = (uint8_t)(base_tick >> 8);
+    buf[6] = (uint8_t)(base_tick >> 16);
+    buf[7] = (uint8_t)(base_tick >> 24);
+    buf[8] = (uint8_t)period;
+    buf[9] = (uint8_t)(period >> 8);
+    enc->len = BATCH_FRAME_HEADER_SIZE;
+    return 1;
+}
+
+// 追加一行，空间不足或行数已满时返回0且不修改帧
+uint8_t BatchFrame_AddRow(batch_encoder_t *enc, uint32_t tick, uint32_t mask, const int16_t *raw)
+{
+    uint32_t zz[BATCH_FRAME_MAX_POSITIONS];
+    uint32_t zz_max = 0;
+    uint8_t bitmap_len = (uint8_t)((enc->positions + 7) / 8);
+    uint8_t mask_changed, width, count = 0;
+    uint16_t len = enc->len;
+    uint16_t limit = enc->cap - BATCH_FRAME_CRC_SIZE;
+    int32_t jitter;
+    uint8_t n;
+
+    if (enc->rows >= BATCH_FRAME_MAX_ROWS) {
+        return 0;
+    }
+    if (enc->positions < 32) {
+        mask &= (1UL << enc->positions) - 1;
+    }
+
+    // 计算增量并选择能容纳全部增量的最小宽度
+    for (uint8_t i = 0; i < enc->positions; i++) {
+        if (mask & (1UL << i)) {
+            zz[count] = batch_zigzag((int32_t)raw[i] - enc->prev[i]);
+            if (zz[count] > zz_max) {
+                zz_max = zz[count];
+            }
+            count++;
+        }
+    }
+    for (width = 0; width < BATCH_WIDTH_VARINT; width++) {
+        if (zz_max < (1UL << batch_width_bits[width])) {
+            break;
+        }
+    }
+
+    // 行头
+    jitter = (int32_t)(tick - enc->last_tick) - (enc->rows ? (int32_t)enc->period : 0);
+    mask_changed = (mask != enc->last_mask);
+    n = batch_put_varint(&enc->buf[len], (uint16_t)(limit - len),
+                         (batch_zigzag(jitter) << 4) | ((uint32_t)mask_changed << 3) | width);
+    if (n == 0) {
+        return 0;
+    }
+    len += n;
+
+    if (mask_changed) {
+        if (limit - len < bitmap_len) {
+            return 0;
+        }
+        for (uint8_t i = 0; i < bitmap_len; i++) {
+            enc->buf[len++] = (uint8_t)(mask >> (8 * i));
+        }
+    }
+
+    if (width == BATCH_WIDTH_VARINT) {
+        for (uint8_t i = 0; i < count; i++) {
+            n = batch_put_varint(&enc->buf[len], (uint16_t)(limit - len), zz[i]);
+            if (n == 0) {
+                return 0;
+            }
+            len += n;
+        }
+    } else if (width > 0) {
+        uint8_t bits = batch_width_bits[width];
+        uint16_t bytes = (uint16_t)((count * bits + 7) / 8);
+        uint32_t acc = 0;
+        uint8_t acc_bits = 0;
+
+        if (limit - len < bytes) {
+            return 0;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            acc |= zz[i] << acc_bits;
+            acc_bits += bits;
+            while (acc_bits >= 8) {
+                enc->buf[len++] = (uint8_t)acc;
+                acc >>= 8;
+                acc_bits -= 8;
+            }
+        }
+        if (acc_bits > 0) {
+            enc->buf[len++] = (uint8_t)acc;
+        }
+    }
+
+    // 整行写入成功后才更新状态
+    for (uint8_t i = 0; i < enc->positions; i++) {
+        if (mask & (1UL << i)) {
+            enc->prev[i] = raw[i];
+        }
+    }
+    enc->len = len;
+    enc->last_tick = tick;
+    enc->last_mask = mask;
+    enc->rows++;
+    return 1;
+}
+
+// 写入行数和CRC，返回帧长度
+uint16_t BatchFrame_Finish(batch_encoder_t *enc)
+{
+    uint16_t crc;
+
+    enc->buf[3] = enc->rows;
+    crc = BatchFrame_Crc16(enc->buf, enc->len);
+    enc->buf[enc->len] = (uint8_t)crc;
+    enc->buf[enc->len + 1] = (uint8_t)(crc >> 8);
+    return (uint16_t)(enc->len + BATCH_FRAME_CRC_SIZE);
+}
+
+// 解码一帧，返回行数，出错返回负的错误码 (出错前的行已回调)
+int BatchFrame_Decode(const uint8_t *frame, uint16_t len, batch_row_cb_t cb, void *ctx)
+{
+    int16_t raw[BATCH_FRAME_MAX_POSITIONS];
+    uint8_t positions, rows, bitmap_len;
+    uint32_t tick, mask;
+    uint16_t period, pos, end;
+
+    if (len < BATCH_FRAME_HEADER_SIZE + BATCH_FRAME_CRC_SIZE) {
+        return BATCH_FRAME_ERR_SHORT;
+    }
+    end = (uint16_t)(len - BATCH_FRAME_CRC_SIZE);
+    if (BatchFrame_Crc16(frame, end) != (uint16_t)(frame[end] | (frame[end + 1] << 8))) {
+        return BATCH_FRAME_ERR_CRC;
+    }
+    positions = frame[2];
+    if (frame[0] != BATCH_FRAME_MAGIC || frame[1] != BATCH_FRAME_VERSION ||
+        positions == 0 || positions > BATCH_FRAME_MAX_POSITIONS) {
+        return BATCH_FRAME_ERR_HEADER;
+    }
+
+    rows = frame[3];
+    tick = (uint32_t)frame[4] | ((uint32_t)frame[5] << 8) |
+           ((uint32_t)frame[6] << 16) | ((uint32_t)frame[7] << 24);
+    period = (uint16_t)(frame[8] | (frame[9] << 8));
+    bitmap_len = (uint8_t)((positions + 7) / 8);
+    mask = (positions < 32) ? ((1UL << positions) - 1) : 0xFFFFFFFFUL;
+    memset(raw, 0, sizeof(raw));
+    pos = BATCH_FRAME_HEADER_SIZE;
+
+    for (uint8_t r = 0; r < rows; r++) {
+        uint32_t header, value, acc = 0;
+        uint8_t n, width, acc_bits = 0;
+
+        n = batch_get_varint(&frame[pos], (uint16_t)(end - pos), &header);
+        if (n == 0) {
+            return BATCH_FRAME_ERR_TRUNCATED;
+        }
+        pos += n;
+        width = (uint8_t)(header & 0x07);
+        if (width > BATCH_WIDTH_VARINT) {
+            return BATCH_FRAME_ERR_TRUNCATED;
+        }
+        tick += (uint32_t)(batch_unzigzag(header >> 4) + (r ? period : 0));
+
+        if (header & 0x08) {
+            if (end - pos < bitmap_len) {
+                return BATCH_FRAME_ERR_TRUNCATED;
+            }
+            mask = 0;
+            for (uint8_t i = 0; i < bitmap_len; i++) {
+                mask |= (uint32_t)frame[pos++] << (8 * i);
+            }
+        }
+
+        for (uint8_t i = 0; i < positions; i++) {
+            if (!(mask & (1UL << i))) {
+                continue;
+            }
+            if (width == BATCH_WIDTH_VARINT) {
+                n = batch_get_varint(&frame[pos], (uint16_t)(end - pos), &value);
+                if (n == 0) {
+                    return BATCH_FRAME_ERR_TRUNCATED;
+                }
+                pos += n;
+            } else if (width == 0) {
+                value = 0;
+            } else {
+                uint8_t bits = batch_width_bits[width];
+                if (acc_bits < bits) {
+                    if (pos >= end) {
+                        return BATCH_FRAME_ERR_TRUNCATED;
+                    }
+                    acc |= (uint32_t)frame[pos++] << acc_bits;
+                    acc_bits += 8;
+                }
+                value = acc & ((1UL << bits) - 1);
+                acc >>= bits;
+                acc_bits -= bits;
+            }
+            raw[i] = (int16_t)(raw[i] + batch_unzigzag(value));
+        }
+
+        if (cb != NULL) {
+            cb(ctx, tick, mask, raw);
+        }
+    }
+    return rows;
+}
+
+static void batch_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t batch_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 编码上报帧: mask中的位置各占一个条目，flags/raw按位置索引，返回帧长度 (空间不足返回0)
+uint16_t BatchFrame_EncodeReport(uint8_t *buf, uint16_t cap, uint8_t positions, uint32_t seq,
+                                 uint32_t tick, uint32_t mask, const uint8_t *flags, const int16_t *raw)
+{
+    uint16_t len = BATCH_REPORT_HEADER_SIZE;
+    uint8_t count = 0;
+    uint16_t crc;
+
+    if (positions == 0 || positions > BATCH_FRAME_MAX_POSITIONS) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < positions; i++) {
+        if (mask & (1UL << i)) {
+            count++;
+        }
+    }
+    if (cap < BATCH_REPORT_HEADER_SIZE + count * BATCH_REPORT_ENTRY_SIZE + BATCH_FRAME_CRC_SIZE) {
+        return 0;
+    }
+
+    buf[0] = BATCH_REPORT_MAGIC;
+    buf[1] = BATCH_FRAME_VERSION;
+    buf[2] = positions;
+    buf[3] = count;
+    batch_put_u32(&buf[4], seq);
+    batch_put_u32(&buf[8], tick);
+    for (uint8_t i = 0; i < positions; i++) {
+        if (mask & (1UL << i)) {
+            buf[len++] = (uint8_t)(i | (flags[i] & (uint8_t)~BATCH_REPORT_POS_MASK));
+            buf[len++] = (uint8_t)raw[i];
+            buf[len++] = (uint8_t)((uint16_t)raw[i] >> 8);
+        }
+    }
+
+    crc = BatchFrame_Crc16(buf, len);
+    buf[len++] = (uint8_t)crc;
+    buf[len++] = (uint8_t)(crc >> 8);
+    return len;
+}
+
+// 解码上报帧，返回条目数，出错返回负的错误码 (出错前的条目已回调)
+int BatchFrame_DecodeReport(const uint8_t *frame, uint16_t len, batch_report_cb_t cb, void *ctx)
+{
+    uint8_t count;
+    uint16_t end;
+    uint32_t seq, tick;
+
+    if (len < BATCH_REPORT_HEADER_SIZE + BATCH_FRAME_CRC_SIZE) {
+        return BATCH_FRAME_ERR_SHORT;
+    }
+    count = frame[3];
+    end = (uint16_t)(BATCH_REPORT_HEADER_SIZE + count * BATCH_REPORT_ENTRY_SIZE);
+    if (len < end + BATCH_FRAME_CRC_SIZE) {
+        return BATCH_FRAME_ERR_TRUNCATED;
+    }
+    if (BatchFrame_Crc16(frame, end) != (uint16_t)(frame[end] | (frame[end + 1] << 8))) {
+        return BATCH_FRAME_ERR_CRC;
+    }
+    if (frame[0] != BATCH_REPORT_MAGIC || frame[1] != BATCH_FRAME_VERSION ||
+        frame[2] == 0 || frame[2] > BATCH_FRAME_MAX_POSITIONS) {
+        return BATCH_FRAME_ERR_HEADER;
+    }
+
+    seq = batch_get_u32(&frame[4]);
+    tick = batch_get_u32(&frame[8]);
+    for (uint8_t k = 0; k < count; k++) {
+        const uint8_t *e = &frame[BATCH_REPORT_HEADER_SIZE + k * BATCH_REPORT_ENTRY_SIZE];
+        uint8_t position = e[0] & BATCH_REPORT_POS_MASK;
+
+        if (position >= frame[2]) {
+            return BATCH_FRAME_ERR_HEADER;
+        }
+        if (cb != NULL) {
+            cb(ctx, seq, tick, position, (uint8_t)(e[0] & (uint8_t)~BATCH_REPORT_POS_MASK),
+               (int16_t)(e[1] | (e[2] << 8)));
+        }
+    }
+    return count;
+}
@@ -0,0 +1,88 @@
+#ifndef __BATCH_FRAME_H
+#define __BATCH_FRAME_H
+#include <stdint.h>
+
+/**
+ * 多传感器历史数据批量帧 (增量编码)
+ * 不依赖HAL，编码器用于设备端，解码器同时可在Linux主机上编译
+ *
+ * 帧格式 (多字节字段均为小端):
+ *   0   魔术字节 BATCH_FRAME_MAGIC
+ *   1   版本 BATCH_FRAME_VERSION
+ *   2   位置数量N (1~BATCH_FRAME_MAX_POSITIONS)
+ *   3   行数
+ *   4   基准时间戳 (4字节，首行的系统节拍)
+ *   8   标称行间隔 (2字节，节拍)
+ *   10  行 x 行数:
+ *         行头       无符号varint = zigzag(时间增量 - 标称间隔) << 4 | 位图变化 << 3 | 宽度码
+ *                    时间增量相对上一行 (首行相对基准时间戳，不减标称间隔)
+ *         位置位图   仅当位图变化位为1时出现，(N+7)/8字节，位i表示本行包含位置i (初始为全部位置)
+ *         温度增量   位图中每个位置一个zigzag值，原始值(1/16°C)相对该位置上一个值 (初始为0)
+ *                    宽度码0~3: 每个值占0/2/4/8位，从低位起紧密排列，行末补齐到字节
+ *                    宽度码4:   每个值一个无符号varint
+ *   末尾 CRC16-Modbus (2字节，覆盖之前的全部字节)
+ * 温度稳定时一行5个位置只占1~3字节
+ */
+
+#define BATCH_FRAME_MAGIC           0xB5
+#define BATCH_FRAME_VERSION         1
+#define BATCH_FRAME_MAX_POSITIONS   32
+#define BATCH_FRAME_HEADER_SIZE     10
+#define BATCH_FRAME_CRC_SIZE        2
+#define BATCH_FRAME_MAX_ROWS        255
+
+// 解码错误码
+#define BATCH_FRAME_ERR_SHORT       (-1)    // 长度不足
+#define BATCH_FRAME_ERR_CRC         (-2)    // CRC错误
+#define BATCH_FRAME_ERR_HEADER      (-3)    // 魔术字节/版本/位置数量错误
+#define BATCH_FRAME_ERR_TRUNCATED   (-4)    // 行数据越界
+
+/**
+ * 按变化上报帧 (只包含超出死区或超过最长静默时间的位置，见publish.h)
+ *   0   魔术字节 BATCH_REPORT_MAGIC
+ *   1   版本 BATCH_FRAME_VERSION
+ *   2   位置数量N
+ *   3   条目数
+ *   4   序号 (4字节，每次上报加1，接收方据此发现丢失的上报)
+ *   8   时间戳 (4字节，本次上报时的系统节拍)
+ *   12  条目 x 条目数: 1字节 位置(低5位) | 标志(高3位)，2字节原始温度 (1/16°C)
+ *   末尾 CRC16-Modbus
+ */
+#define BATCH_REPORT_MAGIC          0xB6
+#define BATCH_REPORT_HEADER_SIZE    12
+#define BATCH_REPORT_ENTRY_SIZE     3
+#define BATCH_REPORT_POS_MASK       0x1F
+#define BATCH_REPORT_FLAG_CHANGED   0x20    // 相对上次上报的值超出死区 (含首次上报)
+#define BATCH_REPORT_FLAG_SILENCE   0x40    // 未超出死区，但距上次上报已达最长静默时间
+
+// 编码器状态
+typedef struct {
+    uint8_t *buf;                 // 输出缓冲区
+    uint16_t cap;                 // 缓冲区容量
+    uint16_t len;                 // 已写入长度 (不含CRC)
+    uint8_t positions;            // 位置数量
+    uint8_t rows;                 // 已写入行数
+    uint16_t period;              // 标称行间隔
+    uint32_t last_tick;           // 上一行时间戳
+    uint32_t last_mask;           // 上一行位图
+    int16_t prev[BATCH_FRAME_MAX_POSITIONS]; // 各位置上一个值
+} batch_encoder_t;
+
+// 解码回调: 每行调用一次，raw中仅mask置位的位置有效
+typedef void (*batch_row_cb_t)(void *ctx, uint32_t tick, uint32_t mask, const int16_t *raw);
+
+uint8_t BatchFrame_Begin(batch_encoder_t *enc, uint8_t *buf, uint16_t cap, uint8_t positions,
+                         uint32_t base_tick, uint16_t period);
+uint8_t BatchFrame_AddRow(batch_encoder_t *enc, uint32_t tick, uint32_t mask, const int16_t *raw);
+uint16_t BatchFrame_Finish(batch_encoder_t *enc);
+int BatchFrame_Decode(const uint8_t *frame, uint16_t len, batch_row_cb_t cb, void *ctx);
+// 上报帧解码回调: 每个条目调用一次
+typedef void (*batch_report_cb_t)(void *ctx, uint32_t seq, uint32_t tick, uint8_t position,
+                                  uint8_t flags, int16_t raw);
+
+uint16_t BatchFrame_EncodeReport(uint8_t *buf, uint16_t cap, uint8_t positions, uint32_t seq,
+                                 uint32_t tick, uint32_t mask, const uint8_t *flags, const int16_t *raw);
+int BatchFrame_DecodeReport(const uint8_t *frame, uint16_t len, batch_report_cb_t cb, void *ctx);
+uint16_t BatchFrame_Crc16(const uint8_t *data, uint16_t length);
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * 配置口DMA循环接收与空闲线分帧
+ * 接收路径上只有DMA写环形缓冲区，中断只记录位置并释放信号量，解析在配置任务中进行
+ */
+
+#include "cfg_rx.h"
+#include "task.h"
+#include "stm32f10x.h"
+#include "stm32f10x_dma.h"
+#include "stm32f10x_usart.h"
+#include "stm32f10x_rcc.h"
+#include "misc.h"
+#include <string.h>
+
+#define CFG_RX_MASK         (CFG_RX_BUF_SIZE - 1)
+
+static char rx_buf[CFG_RX_BUF_SIZE];
+static char rx_line_buf[CFG_RX_LINE_MAX];
+static SemaphoreHandle_t rx_signal = NULL;
+static volatile uint16_t rx_idle_pos = CFG_RX_NO_IDLE; // 最近一次空闲中断时的DMA写位置
+static uint16_t rx_read = 0;                // 已扫描到的位置
+static uint16_t rx_frame = 0;               // 当前未结束帧的起始位置
+static uint16_t rx_last_write = 0;          // 上次看到的DMA写位置
+static TickType_t rx_last_change = 0;       // DMA写位置最近一次变化的节拍
+
+// DMA当前写位置
+static uint16_t cfg_rx_dma_pos(void)
+{
+    return (uint16_t)((CFG_RX_BUF_SIZE - DMA_GetCurrDataCounter(DMA1_Channel5)) & CFG_RX_MASK);
+}
+
+// 初始化USART1接收DMA (DMA1通道5，循环模式)
+void CfgRx_Init(SemaphoreHandle_t signal)
+{
+    DMA_InitTypeDef DMA_InitStruct;
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    rx_signal = signal;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DMA1_Channel5);
+
+    DMA_InitStruct.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR;
+    DMA_InitStruct.DMA_MemoryBaseAddr = (uint32_t)rx_buf;
+    DMA_InitStruct.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStruct.DMA_BufferSize = CFG_RX_BUF_SIZE;
+    DMA_InitStruct.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStruct.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStruct.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStruct.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStruct.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStruct.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStruct.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel5, &DMA_InitStruct);
+
+    // 半满/全满时唤醒任务，没有空闲间隔的连续数据也能及时取走
+    DMA_ITConfig(DMA1_Channel5, DMA_IT_HT | DMA_IT_TC, ENABLE);
+    NVIC_InitStruct.NVIC_IRQChannel = DMA1_Channel5_IRQn;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = CFG_RX_IRQ_PRIO;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+
+    // 接收改由DMA完成，关闭逐字节接收中断
+    USART_ITConfig(USART1, USART_IT_RXNE, DISABLE);
+    USART_DMACmd(USART1, USART_DMAReq_Rx, ENABLE);
+    DMA_Cmd(DMA1_Channel5, ENABLE);
+}
+
+// USART1空闲中断: 记录帧结束位置并唤醒配置任务
+void CfgRx_IdleISR(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    // 先读SR再读DR清除IDLE标志
+    (void)USART1->SR;
+    (void)USART1->DR;
+    rx_idle_pos = cfg_rx_dma_pos();
+    if (rx_signal != NULL) {
+        xSemaphoreGiveFromISR(rx_signal, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+void DMA1_Channel5_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    DMA_ClearITPendingBit(DMA1_IT_GL5);
+    if (rx_signal != NULL) {
+        xSemaphoreGiveFromISR(rx_signal, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+// [start, end)之间的数据，连续时直接指向环形缓冲区，跨越末尾时拼接 (超出部分截断)，返回长度
+static uint16_t cfg_rx_view(uint16_t start, uint16_t end, const char **data)
+{
+    uint16_t len = (uint16_t)((end - start) & CFG_RX_MASK);
+    uint16_t first;
+
+    if (start + len <= CFG_RX_BUF_SIZE) {
+        *data = &rx_buf[start];
+        return len;
+    }
+    if (len > CFG_RX_LINE_MAX) {
+        len = CFG_RX_LINE_MAX;
+    }
+    first = (uint16_t)(CFG_RX_BUF_SIZE - start);
+    memcpy(rx_line_buf, &rx_buf[start], first);
+    memcpy(&rx_line_buf[first], rx_buf, len - first);
+    *data = rx_line_buf;
+    return len;
+}
+
+// 交出[start, end)之间的一帧
+static void cfg_rx_emit(uint16_t start, uint16_t end, cfg_rx_frame_cb_t cb)
+{
+    const char *data;
+    uint16_t len = cfg_rx_view(start, end, &data);
+
+    if (len > 0) {
+        cb(data, len);
+    }
+}
+
+// 处理新收到的数据: is_line判定为文本命令的行以换行结束一帧，其余数据 (原有协议的帧，
+// 其中可能含有0x0A) 在空闲线处作为一帧交出。返回交给cb的帧数
+uint16_t CfgRx_Poll(cfg_rx_frame_cb_t cb, cfg_rx_line_cb_t is_line)
+{
+    uint16_t write = cfg_rx_dma_pos();
+    uint16_t idle = rx_idle_pos;
+    TickType_t now = xTaskGetTickCount();
+    uint16_t frames = 0;
+
+    if (write != rx_last_write) {
+        rx_last_write = write;
+        rx_last_change = now;
+    }
+
+    while (rx_read != write) {
+        char c = rx_buf[rx_read];
+
+        rx_read = (uint16_t)((rx_read + 1) & CFG_RX_MASK);
+        if (c == '\n' && is_line != NULL) {
+            const char *data;
+            uint16_t len = cfg_rx_view(rx_frame, rx_read, &data);
+
+            if (is_line(data, len)) {
+                cb(data, len);
+                rx_frame = rx_read;
+                frames++;
+                continue;
+            }
+        }
+        // 过长的帧在半个缓冲区处强制分帧，避免被DMA覆盖
+        if (((rx_read - rx_frame) & CFG_RX_MASK) >= CFG_RX_BUF_SIZE / 2) {
+            cfg_rx_emit(rx_frame, rx_read, cb);
+            rx_frame = rx_read;
+            frames++;
+        }
+    }
+
+    // 发送方已停止发送 (空闲中断记录的位置即当前写位置，或写位置CFG_RX_IDLE_TICKS内未变化)，
+    // 剩余数据作为一帧交出
+    if (rx_frame != write && (idle == write || (TickType_t)(now - rx_last_change) >= CFG_RX_IDLE_TICKS)) {
+        cfg_rx_emit(rx_frame, write, cb);
+        rx_frame = write;
+        frames++;
+    }
+
+    return frames;
+}
+
+// 是否有尚未交出的数据 (配置任务据此缩短等待，按CFG_RX_IDLE_TICKS判定空闲线)
+uint8_t CfgRx_Pending(void)
+{
+    return rx_frame != cfg_rx_dma_pos();
+}
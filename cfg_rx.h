@@ -0,0 +1,36 @@
+#ifndef __CFG_RX_H
+#define __CFG_RX_H
+#include "sys.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/**
+ * 配置口(USART1)DMA循环接收
+ * DMA1通道5把接收数据连续写入环形缓冲区，没有逐字节中断；USART空闲中断和DMA半满/全满中断只唤醒配置任务。
+ * 配置任务按DMA写位置取出新数据并切片，切片直接指向环形缓冲区 (只有跨越缓冲区末尾的帧才拼接复制)，
+ * 不需要每条命令清空缓冲区，也不需要固定延时，连续的多条命令逐条处理。
+ * 分帧: 诊断文本命令 (由CfgRx_Poll的is_line判定) 按换行分帧；原有协议的帧是二进制，可能含有0x0A，
+ * 只在空闲线处分帧。
+ *
+ * USART1_IRQHandler (不在本仓库) 应在IDLE中断时调用CfgRx_IdleISR (取代原来的RXNE逐字节接收)。
+ * 未接入时，配置任务以CFG_RX_POLL_TICKS为周期查询，DMA写位置CFG_RX_IDLE_TICKS内不变即视为空闲线。
+ */
+
+#define CFG_RX_BUF_SIZE     512     // 环形缓冲区大小，必须为2的幂 (115200bps下半满约22ms)
+#define CFG_RX_LINE_MAX     128     // 跨越缓冲区末尾的行拼接缓冲区，超出部分截断
+#define CFG_RX_IRQ_PRIO     6       // DMA中断抢占优先级，不得高于configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define CFG_RX_IDLE_TICKS   5       // DMA写位置多久不变视为空闲线 (节拍，空闲中断未接入时的后备)
+#define CFG_RX_POLL_TICKS   20      // 无待处理数据时配置任务的最长等待 (节拍)
+#define CFG_RX_NO_IDLE      0xFFFF  // 尚未发生空闲中断
+
+// 一帧数据 (以换行结束的文本命令，或空闲线之前的数据)，data在回调返回后失效
+typedef void (*cfg_rx_frame_cb_t)(const char *data, uint16_t len);
+// 判断以换行结束的数据是否为按行分帧的文本命令
+typedef uint8_t (*cfg_rx_line_cb_t)(const char *data, uint16_t len);
+
+void CfgRx_Init(SemaphoreHandle_t signal);
+void CfgRx_IdleISR(void);
+uint16_t CfgRx_Poll(cfg_rx_frame_cb_t cb, cfg_rx_line_cb_t is_line);
+uint8_t CfgRx_Pending(void);
+
+#endif
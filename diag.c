@@ -0,0 +1,347 @@
+/**
+ * 配置口诊断命令处理
+ * 非诊断命令返回0，由原有的Usart1_receive_process_event继续处理
+ */
+
+#include "diag.h"
+#include "ds18b20.h"
+#include "temp_filter.h"
+#include "ds18b20_bus.h"
+#include "publish.h"
+#include "ow_trace.h"
+#include "rtos_alloc.h"
+#include "ds_log.h"
+#include <stdio.h>
+#include <string.h>
+
+// 判断命令是否以指定关键字开头，成功时返回参数起始位置，否则返回NULL
+static const char *diag_match(const char *cmd, uint16_t len, const char *keyword)
+{
+    uint16_t key_len = (uint16_t)strlen(keyword);
+
+    if (len < key_len || strncmp(cmd, keyword, key_len) != 0) {
+        return NULL;
+    }
+    // 关键字后必须是结束、空白或换行
+    if (len > key_len && cmd[key_len] != ' ' && cmd[key_len] != '\r' && cmd[key_len] != '\n') {
+        return NULL;
+    }
+    return cmd + key_len;
+}
+
+// 跳过空格
+static const char *diag_skip_space(const char *p, const char *end)
+{
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    return p;
+}
+
+// 解析单个十六进制字符，非法返回0xFF
+static uint8_t diag_hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return (uint8_t)(c - '0');
+    if (c >= 'A' && c <= 'F') return (uint8_t)(c - 'A' + 10);
+    if (c >= 'a' && c <= 'f') return (uint8_t)(c - 'a' + 10);
+    return 0xFF;
+}
+
+// 解析16个十六进制字符的ROM码，返回1表示成功
+static uint8_t diag_parse_rom(const char *p, const char *end, uint8_t *rom_code)
+{
+    if (end - p < 16) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        uint8_t hi = diag_hex_nibble(p[i * 2]);
+        uint8_t lo = diag_hex_nibble(p[i * 2 + 1]);
+        if (hi == 0xFF || lo == 0xFF) {
+            return 0;
+        }
+        rom_code[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return 1;
+}
+
+// 解析十进制无符号数，成功返回下一个字符位置，否则返回NULL
+static const char *diag_parse_uint(const char *p, const char *end, uint16_t *value)
+{
+    uint32_t v = 0;
+    const char *start;
+
+    p = diag_skip_space(p, end);
+    start = p;
+    while (p < end && *p >= '0' && *p <= '9' && v <= 0xFFFF) {
+        v = v * 10 + (uint32_t)(*p - '0');
+        p++;
+    }
+    if (p == start || v > 0xFFFF) {
+        return NULL;
+    }
+    *value = (uint16_t)v;
+    return p;
+}
+
+// OWFILT命令: 无参数时打印滤波状态，否则设置指定位置的滤波参数
+static void diag_owfilt(const char *args, const char *end)
+{
+    temp_filter_cfg_t cfg;
+    uint16_t position, median_n, max_slew, ema_shift;
+
+    args = diag_skip_space(args, end);
+    if (args == end || *args == '\r' || *args == '\n') {
+        TempFilter_PrintStatus();
+        return;
+    }
+
+    if ((args = diag_parse_uint(args, end, &position)) == NULL ||
+        (args = diag_parse_uint(args, end, &median_n)) == NULL ||
+        (args = diag_parse_uint(args, end, &max_slew)) == NULL ||
+        (args = diag_parse_uint(args, end, &ema_shift)) == NULL ||
+        position == 0) {
+        printf("OWFILT ERR\r\n");
+        return;
+    }
+
+    cfg.median_n = (uint8_t)median_n;
+    cfg.max_slew = max_slew;
+    cfg.ema_shift = (uint8_t)ema_shift;
+    if (!TempFilter_SetConfig((uint8_t)(position - 1), &cfg)) {
+        printf("OWFILT ERR\r\n");
+        return;
+    }
+    printf("OWFILT %d OK\r\n", position);
+}
+
+// PUBDB命令: 无参数时打印按变化上报的状态，否则设置位置死区或最长静默时间
+static void diag_pubdb(const char *args, const char *end)
+{
+    uint16_t position, value;
+
+    args = diag_skip_space(args, end);
+    if (args == end || *args == '\r' || *args == '\n') {
+        Publish_PrintReportStatus();
+        return;
+    }
+
+    if (end - args >= 7 && strncmp(args, "SILENCE", 7) == 0) {
+        if (diag_parse_uint(args + 7, end, &value) == NULL) {
+            printf("PUBDB ERR\r\n");
+            return;
+        }
+        Publish_SetMaxSilence((uint32_t)value * 1000);
+        printf("PUBDB SILENCE %u OK\r\n", value);
+        return;
+    }
+
+    if ((args = diag_parse_uint(args, end, &position)) == NULL ||
+        diag_parse_uint(args, end, &value) == NULL ||
+        position == 0 || position > 0xFF || !Publish_SetDeadband((uint8_t)(position - 1), value)) {
+        printf("PUBDB ERR\r\n");
+        return;
+    }
+    printf("PUBDB %d OK\r\n", position);
+}
+
+// OWMAP命令: 下发位置-ROM映射表
+static void diag_owmap(const char *args, const char *end)
+{
+    uint8_t rom_code[8];
+    uint16_t position = 0;
+
+    args = diag_skip_space(args, end);
+
+    if (end - args >= 5 && strncmp(args, "APPLY", 5) == 0) {
+        DS18B20_RequestCommission();
+        printf("OWMAP APPLY queued\r\n");
+        return;
+    }
+    if (end - args >= 5 && strncmp(args, "CLEAR", 5) == 0) {
+        DS18B20_ClearCommissionTable();
+        printf("OWMAP cleared\r\n");
+        return;
+    }
+
+    // 命令是接收缓冲区中的切片，不以'\0'结束，只能按end解析
+    args = diag_parse_uint(args, end, &position);
+    if (args != NULL) {
+        args = diag_skip_space(args, end);
+    }
+
+    if (args == NULL || position == 0 || position > 0xFF || !diag_parse_rom(args, end, rom_code) ||
+        !DS18B20_SetCommissionEntry((uint8_t)(position - 1), rom_code)) {
+        printf("OWMAP ERR\r\n");
+        return;
+    }
+    printf("OWMAP %d OK\r\n", position);
+}
+
+// 以下在总线任务中执行，不在配置任务的发送权范围内，各自取得发送权
+// 在总线任务中打印统计
+static void diag_print_stats(void *ctx)
+{
+    DS_Log_TxLock();
+    DS18B20_PrintStats();
+    DS_Log_TxUnlock();
+}
+
+// OWTRACE的操作 (含切换模式) 在总线任务中执行，避免与记录并发
+#define DIAG_TRACE_DUMP     0
+#define DIAG_TRACE_CLEAR    1
+#define DIAG_TRACE_ON       2
+#define DIAG_TRACE_OFF      3
+#define DIAG_TRACE_TRIG     4
+
+static void diag_owtrace_call(void *ctx)
+{
+    DS_Log_TxLock();
+    switch ((uintptr_t)ctx) {
+    case DIAG_TRACE_CLEAR:
+        OwTrace_Clear();
+        printf("OWTRACE cleared\r\n");
+        break;
+    case DIAG_TRACE_ON:
+        OwTrace_SetMode(OW_TRACE_MODE_ON);
+        printf("OWTRACE ON\r\n");
+        break;
+    case DIAG_TRACE_OFF:
+        OwTrace_SetMode(OW_TRACE_MODE_OFF);
+        printf("OWTRACE OFF\r\n");
+        break;
+    case DIAG_TRACE_TRIG:
+        OwTrace_SetMode(OW_TRACE_MODE_TRIGGER);
+        printf("OWTRACE TRIG\r\n");
+        break;
+    default:
+        OwTrace_Dump();
+        break;
+    }
+    DS_Log_TxUnlock();
+}
+
+// OWTRACE命令: 无参数时导出跟踪记录，ON/OFF/TRIG切换模式，CLEAR清空
+static void diag_owtrace(const char *args, const char *end)
+{
+    uintptr_t action = DIAG_TRACE_DUMP;
+
+    args = diag_skip_space(args, end);
+    if (end - args >= 2 && strncmp(args, "ON", 2) == 0) {
+        action = DIAG_TRACE_ON;
+    } else if (end - args >= 3 && strncmp(args, "OFF", 3) == 0) {
+        action = DIAG_TRACE_OFF;
+    } else if (end - args >= 4 && strncmp(args, "TRIG", 4) == 0) {
+        action = DIAG_TRACE_TRIG;
+    } else if (end - args >= 5 && strncmp(args, "CLEAR", 5) == 0) {
+        action = DIAG_TRACE_CLEAR;
+    }
+    if (!DS18B20_Bus_Call(diag_owtrace_call, (void *)action, DS18B20_PRIO_HIGH, NULL)) {
+        printf("OWTRACE busy\r\n");
+    }
+}
+
+// OWTIME的操作在总线任务中执行: CAL只开始分步校准，由总线任务在读取之间推进，结果记入日志
+static void diag_owtime_call(void *ctx)
+{
+    ow_timing_t timing;
+    uint8_t started = 0;
+
+    if (ctx != NULL) {
+        started = DS18B20_StartTimingCalibration();
+    }
+    DS18B20_GetTiming(&timing);
+    DS_Log_TxLock();
+    if (ctx != NULL) {
+        printf(started ? "OWTIME CAL started\r\n" : "OWTIME CAL FAIL\r\n");
+    }
+    printf("OWTIME sample=%u us recovery=%u us slot=%u us %s\r\n", timing.sample_us, timing.recovery_us,
+           OW_SLOT_US + timing.recovery_us, (timing.tag == OW_TIMING_TAG) ? "calibrated" : "default");
+    DS_Log_TxUnlock();
+}
+
+// OWTIME命令: 无参数时打印当前时序，CAL重新校准 (结果改变时保存配置)
+static void diag_owtime(const char *args, const char *end)
+{
+    void *calibrate = NULL;
+
+    args = diag_skip_space(args, end);
+    if (end - args >= 3 && strncmp(args, "CAL", 3) == 0) {
+        calibrate = (void *)1;
+    }
+    if (!DS18B20_Bus_Call(diag_owtime_call, calibrate, DS18B20_PRIO_HIGH, NULL)) {
+        printf("OWTIME busy\r\n");
+    }
+}
+
+// 诊断命令关键字 (与Diag_HandleCommand中的分支一致)，配置口据此只对诊断命令按换行分帧
+static const char *const diag_keywords[] = {
+    "OWSTAT", "OWMAP", "AGESTAT", "OWFILT", "OWTRACE", "OWTIME", "PUBDB", "STACKS"
+};
+
+// 判断一帧是否为诊断命令 (以关键字开头)
+uint8_t Diag_IsCommand(const char *cmd, uint16_t len)
+{
+    if (cmd == NULL || len == 0) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < sizeof(diag_keywords) / sizeof(diag_keywords[0]); i++) {
+        if (diag_match(cmd, len, diag_keywords[i]) != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t Diag_HandleCommand(const char *cmd, uint16_t len)
+{
+    const char *args;
+
+    if (cmd == NULL || len == 0) {
+        return 0;
+    }
+
+    if (diag_match(cmd, len, "OWSTAT") != NULL) {
+        // 统计由总线任务更新，交给总线任务打印
+        if (!DS18B20_Bus_Call(diag_print_stats, NULL, DS18B20_PRIO_HIGH, NULL)) {
+            printf("OWSTAT busy\r\n");
+        }
+        return 1;
+    }
+
+    if ((args = diag_match(cmd, len, "OWMAP")) != NULL) {
+        diag_owmap(args, cmd + len);
+        return 1;
+    }
+
+    if (diag_match(cmd, len, "AGESTAT") != NULL) {
+        Publish_PrintStats();
+        return 1;
+    }
+
+    if ((args = diag_match(cmd, len, "OWFILT")) != NULL) {
+        diag_owfilt(args, cmd + len);
+        return 1;
+    }
+
+    if ((args = diag_match(cmd, len, "OWTRACE")) != NULL) {
+        diag_owtrace(args, cmd + len);
+        return 1;
+    }
+
+    if ((args = diag_match(cmd, len, "OWTIME")) != NULL) {
+        diag_owtime(args, cmd + len);
+        return 1;
+    }
+
+    if ((args = diag_match(cmd, len, "PUBDB")) != NULL) {
+        diag_pubdb(args, cmd + len);
+        return 1;
+    }
+
+    if (diag_match(cmd, len, "STACKS") != NULL) {
+        RtosAlloc_PrintStacks();
+        return 1;
+    }
+
+    return 0;
+}
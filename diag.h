@@ -0,0 +1,30 @@
+#ifndef __DIAG_H
+#define __DIAG_H
+#include "sys.h"
+
+/**
+ * 配置口(USART1)诊断命令
+ * OWSTAT                - 打印并清零1-Wire总线统计
+ * OWMAP <位置> <ROM码>   - 设置位置(1起)对应的16位十六进制ROM码
+ * OWMAP APPLY            - 按映射表执行批量调试并保存配置
+ * OWMAP CLEAR            - 清空映射表
+ * AGESTAT                - 打印并清零样本年龄统计 (快照时/上传时的p50与最大值)
+ * OWFILT                 - 打印各位置滤波参数和剔除统计
+ * OWFILT <位置> <中值点数> <斜率> <EMA移位> - 设置位置的滤波参数 (斜率单位1/16°C/样本，0为关闭)
+ * OWTRACE                - 导出1-Wire位级跟踪记录 (十六进制，由host/ow_replay解析)
+ * OWTRACE ON|OFF|TRIG    - 连续记录/关闭/CRC错误后冻结 (默认TRIG)
+ * OWTRACE CLEAR          - 清空跟踪记录并解除冻结
+ * OWTIME                 - 打印1-Wire时序 (读采样点、恢复时间，是否为校准结果)
+ * OWTIME CAL             - 开始重新扫描校准时序 (在读取之间分步进行，结果记入日志，改变时保存配置)
+ * STACKS                 - 打印各任务栈最高水位、堆历史最小剩余和静态池用量
+ * PUBDB                  - 打印按变化上报的死区、最长静默时间、序号和上报统计
+ * PUBDB <位置> <死区>     - 设置位置的上报死区 (1/16°C，0为任何变化都上报)
+ * PUBDB SILENCE <秒>     - 设置最长静默时间 (0为每个周期全部上报)
+ */
+
+// 处理一条配置口命令，返回1表示已作为诊断命令处理
+uint8_t Diag_HandleCommand(const char *cmd, uint16_t len);
+// 判断一帧是否以诊断命令关键字开头 (不执行)
+uint8_t Diag_IsCommand(const char *cmd, uint16_t len);
+
+#endif
@@ -12,6 +12,10 @@
 #include "stm32f10x_gpio.h"
 #include "stm32f10x_rcc.h"
 #include "stm32f10x_flash.h"
+#include "ds_log.h"
+#include "ow_trace.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -19,11 +23,66 @@
 #define DS18B20_DEBUG_FLAG 1
 #define DS18B20_CONFIG_MAGIC 0xD5B20123  // 用于验证配置有效性的魔术数字
 
+// Flash地址到可读指针的转换 (主机仿真时映射到模拟Flash)
+#ifndef FLASH_ADDR_TO_PTR
+#define FLASH_ADDR_TO_PTR(addr) ((const void *)(addr))
+#endif
+
 // 全局变量
 ds18b20_device_t ds18b20_devices[MAX_DS18B20_SENSORS]; // 传感器数组
 static uint8_t ds18b20_count = 0;         // 已发现的传感器数量
 uint8_t ds18b20_config_mode = CONFIG_MODE_NORMAL;  // 默认为正常模式
 
+// 批量调试用的位置-ROM映射表 (由配置口下发)
+static uint8_t commission_table[MAX_DS18B20_SENSORS][8];
+static uint8_t commission_table_set[MAX_DS18B20_SENSORS];
+static volatile uint8_t commission_pending = 0;
+
+// 已发出但尚未读取的广播转换: 启动时的首次转换，或流水线模式下读取后预发的下一次转换
+static uint8_t conv_pending = 0;
+static TickType_t conv_tick = 0;           // 该转换发出时刻
+
+// 启动过程: 首个有效样本时间
+static TickType_t boot_tick = 0;           // DS18B20_Init开始时刻
+static uint32_t boot_first_sample_ms = 0;  // 启动到首个有效样本的时间 (0表示尚未获得)
+
+// 流水线采集: 仅在总线上全部为外部供电时生效 (寄生供电时转换期间不能有其他总线通信)
+static uint8_t parasite_power = 1;         // 总线上有寄生供电器件 (检测前按寄生供电处理)
+static uint8_t pipeline_enabled = DS18B20_PIPELINED;
+
+// 总线拓扑: 单器件总线上用SKIP_ROM寻址，省去每次事务的MATCH_ROM和64位ROM码
+static uint8_t single_drop = 0;            // 搜索确认总线上只有一个器件
+static uint8_t single_rom[8];              // 该器件的ROM码，只有目标ROM与之相同时才跳过匹配
+static uint8_t rom_check_countdown = 0;    // 距下次拓扑复核的采集周期数
+static void ds18b20_classify_bus(void);
+
+// 总线时序: 读采样点和时隙间恢复时间，由校准得到并随配置保存 (未校准时为默认值，tag为0)
+static ow_timing_t ow_timing = { OW_TIMING_DEFAULT_SAMPLE_US, OW_TIMING_DEFAULT_RECOVERY_US, 0 };
+static uint16_t timing_check_countdown = 1; // 距下次时序维护的采集周期数
+static uint8_t timing_dead_cycles = 0;     // 全部位置读取失败的连续采集周期数
+
+// 分步时序维护: 读取只登记待做的工作，由总线任务在请求之间调用DS18B20_TimingStep推进，
+// 每步只检查一个扫描点，一次读取请求最多等待一步
+#define OW_WORK_NONE                0
+#define OW_WORK_MARGIN              1       // 复核余量，余量不足时开始校准
+#define OW_WORK_RESCUE              2       // 按保守时序重新检测，读到器件时开始校准
+#define OW_WORK_SWEEP               3       // 扫描恢复时间档和采样点
+static const uint8_t ow_cal_recovery_steps[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24 };
+static struct {
+    uint8_t work;
+    uint8_t step;                 // 恢复时间档
+    uint8_t sample;               // 下一个扫描的采样点
+    uint8_t run_start;
+    uint8_t run_len;
+    uint8_t best_start;
+    uint8_t best_len;
+    uint8_t result;               // 最近一次校准是否采用了结果
+} ow_cal;
+
+// 最近一次读取的原始温度 (1/16°C)，供滤波等定点处理使用，不写入Flash
+static int16_t last_raw[MAX_DS18B20_SENSORS];
+static uint8_t last_raw_valid[MAX_DS18B20_SENSORS];
+
 
 // 添加预定义的ROM码数组
 const uint8_t PREDEFINED_ROM_CODES[5][8] = {
@@ -38,6 +97,49 @@ const uint8_t PREDEFINED_ROM_CODES[5][8] = {
  ds18b20_device_t ds18b20_devices[MAX_DS18B20_SENSORS]; // 传感器数组
 //static uint8_t ds18b20_count = 0;                       // 已发现的传感器数量
 
+// DWT周期计数器，用于统计总线占用时间
+#ifndef OW_CYCLE_COUNT
+#define OW_DEMCR        (*(volatile uint32_t *)0xE000EDFC)
+#define OW_DWT_CTRL     (*(volatile uint32_t *)0xE0001000)
+#define OW_DWT_CYCCNT   (*(volatile uint32_t *)0xE0001004)
+#define OW_CYCLE_COUNT()            (OW_DWT_CYCCNT)
+#define OW_CYCLE_COUNTER_INIT()     do { OW_DEMCR |= (1UL << 24); OW_DWT_CYCCNT = 0; OW_DWT_CTRL |= 1UL; } while (0)
+#endif
+#define OW_CYCLES_PER_US            (SystemCoreClock / 1000000)
+
+// 1-Wire总线统计
+static ow_stats_t ow_stats;
+static uint32_t ow_txn_cycles = 0;        // 当前事务已占用的周期数
+static uint32_t ow_busy_rem_cycles = 0;   // 不足1us的剩余周期
+
+// 时隙关键窗口的中断屏蔽
+#define OW_PRESENCE_SAMPLE_US       70      // 释放后采样存在脉冲的时刻
+#define OW_PRESENCE_LATE_US         75      // 存在脉冲保证持续到的最晚时刻
+#define OW_PRESENCE_GUARD_US        8       // 采样前提前屏蔽中断的时间
+#define OW_START_LOW_US             2       // 读时隙和写1的起始低电平
+static uint32_t ow_mask_start = 0;        // 本次屏蔽开始的周期数
+static uint32_t ow_mask_max_cycles = 0;   // 最长屏蔽周期数
+
+#if OW_TRACE_ENABLE
+static uint32_t ow_trace_last = 0;        // 上一条跟踪记录的开始周期数
+
+// 记录一个时隙: timing为周期数，复位按1us、读写时隙按0.25us量化
+static void ow_trace_slot(uint8_t kind, uint8_t value, uint32_t start, uint32_t timing)
+{
+    if (!OwTrace_Active()) {
+        return;
+    }
+    timing = (kind == OW_TRACE_RESET) ? timing / OW_CYCLES_PER_US : timing * 4 / OW_CYCLES_PER_US;
+    OwTrace_Slot(kind, value, timing, (start - ow_trace_last) / OW_CYCLES_PER_US);
+    ow_trace_last = start;
+}
+#define OW_TRACE_SLOT(kind, value, start, timing)   ow_trace_slot(kind, value, start, timing)
+#define OW_TRACE_MARK_EVENT(code, arg)              OwTrace_Mark(code, arg)
+#else
+#define OW_TRACE_SLOT(kind, value, start, timing)   do { (void)(start); (void)(timing); } while (0)
+#define OW_TRACE_MARK_EVENT(code, arg)              ((void)0)
+#endif
+
 // 微秒延时函数
 static void Delay_us(uint32_t us)
 {
@@ -47,6 +149,14 @@ static void Delay_us(uint32_t us)
     }
 }
 
+// 忙等到from之后us微秒 (按DWT计时，循环开销和中断不会累积到时隙上)
+static void ow_wait_until(uint32_t from, uint32_t us)
+{
+    while (OW_CYCLE_COUNT() - from < us * OW_CYCLES_PER_US) {
+        __NOP();
+    }
+}
+
 // 配置GPIO为输出模式
 static void ow_output_mode(void)
 {
@@ -68,62 +178,175 @@ static void ow_input_mode(void)
     GPIO_Init(OW_PORT, &GPIO_InitStruct);
 }
 
+// 累计一次总线操作占用的周期数
+static void ow_account(uint32_t start)
+{
+    ow_txn_cycles += OW_CYCLE_COUNT() - start;
+}
+
+// 结束当前事务，更新累计占用时间和最长事务时间
+static void ow_txn_close(void)
+{
+    uint32_t txn_us;
+
+    if (ow_txn_cycles == 0) {
+        return;
+    }
+
+    ow_busy_rem_cycles += ow_txn_cycles;
+    ow_stats.busy_us += ow_busy_rem_cycles / OW_CYCLES_PER_US;
+    ow_busy_rem_cycles %= OW_CYCLES_PER_US;
+
+    txn_us = ow_txn_cycles / OW_CYCLES_PER_US;
+    if (txn_us > ow_stats.txn_max_us) {
+        ow_stats.txn_max_us = txn_us;
+    }
+    ow_stats.transactions++;
+    ow_txn_cycles = 0;
+}
+
+// 屏蔽中断进入时隙关键窗口，返回原PRIMASK (可在已屏蔽的上下文中嵌套调用)
+static uint32_t ow_irq_mask(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    ow_mask_start = OW_CYCLE_COUNT();
+    return primask;
+}
+
+// 退出关键窗口，记录驱动引入的最长中断延迟
+static void ow_irq_restore(uint32_t primask)
+{
+    uint32_t cycles = OW_CYCLE_COUNT() - ow_mask_start;
+
+    __set_PRIMASK(primask);
+    if (cycles > ow_mask_max_cycles) {
+        ow_mask_max_cycles = cycles;
+        ow_stats.irq_mask_max_us = (cycles + OW_CYCLES_PER_US - 1) / OW_CYCLES_PER_US;
+    }
+}
+
 // 读取1-Wire总线上的一位数据
+// 拉低到采样必须在15us内完成，仅这段时间屏蔽中断，恢复时间允许被中断拉长
+// 各时刻以下降沿为基准，采样点和恢复时间取自当前时序参数
 static uint8_t ow_read_bit(void)
 {
     uint8_t bit = 0;
+    uint32_t start = OW_CYCLE_COUNT();
+    uint32_t primask;
+    uint32_t fall, sample;
     
     ow_output_mode();
+    primask = ow_irq_mask();
+    fall = OW_CYCLE_COUNT();
     GPIO_ResetBits(OW_PORT, OW_PIN);  // 拉低总线
-    Delay_us(2);                      // 保持2us
+    ow_wait_until(fall, OW_START_LOW_US);
     
     ow_input_mode();                  // 释放总线
-    Delay_us(10);                     // 等待数据稳定
+    ow_wait_until(fall, ow_timing.sample_us); // 等待数据稳定
     
+    sample = OW_CYCLE_COUNT();
     bit = GPIO_ReadInputDataBit(OW_PORT, OW_PIN); // 读取数据位
-    Delay_us(50);                     // 完成时隙
+    ow_irq_restore(primask);
+    ow_wait_until(fall, OW_SLOT_US + ow_timing.recovery_us); // 完成时隙并留出恢复时间
     
+    OW_TRACE_SLOT(OW_TRACE_READ, bit, fall, sample - fall);
+    ow_stats.bits_read++;
+    ow_account(start);
     return bit;
 }
 
 // 向1-Wire总线写入一位数据
+// 写1的低电平必须短于15us，写0的低电平必须在60~120us之间 (超过120us可能被当作复位)，
+// 两者的低电平都屏蔽中断，恢复时间允许被中断拉长
 static void ow_write_bit(uint8_t bit)
 {
+    uint32_t start = OW_CYCLE_COUNT();
+    uint32_t primask;
+    uint32_t fall, release;
+
     ow_output_mode();
     
+    primask = ow_irq_mask();
+    fall = OW_CYCLE_COUNT();
+    GPIO_ResetBits(OW_PORT, OW_PIN);      // 拉低总线
     if (bit) {
         // 写"1"
-        GPIO_ResetBits(OW_PORT, OW_PIN);  // 拉低总线
-        Delay_us(2);                      // 保持低电平2us
+        ow_wait_until(fall, OW_START_LOW_US);
         
+        release = OW_CYCLE_COUNT();
         GPIO_SetBits(OW_PORT, OW_PIN);    // 释放总线
-        Delay_us(60);                     // 保持高电平
+        ow_irq_restore(primask);
+        ow_wait_until(fall, OW_SLOT_US + ow_timing.recovery_us); // 保持高电平到时隙结束并恢复
     } else {
         // 写"0"
-        GPIO_ResetBits(OW_PORT, OW_PIN);  // 拉低总线
-        Delay_us(60);                     // 保持低电平60us
+        ow_wait_until(fall, OW_SLOT_US);  // 低电平保持整个时隙
         
+        release = OW_CYCLE_COUNT();
         GPIO_SetBits(OW_PORT, OW_PIN);    // 释放总线
-        Delay_us(2);                      // 恢复间隔
+        ow_irq_restore(primask);
+        ow_wait_until(release, ow_timing.recovery_us); // 恢复间隔
     }
+
+    OW_TRACE_SLOT(OW_TRACE_WRITE, bit, fall, release - fall);
+    ow_stats.bits_written++;
+    ow_account(start);
 }
 
 // 发送复位脉冲并检测存在脉冲
+// 复位低电平和恢复时间不屏蔽中断，只在采样点前短暂屏蔽；
+// 若中断把采样推迟到存在脉冲保证窗口之外且未检测到器件，重新复位一次
 static uint8_t ow_reset(void)
 {
-    uint8_t presence;
-    
-    ow_output_mode();
-    GPIO_ResetBits(OW_PORT, OW_PIN);      // 拉低总线
-    Delay_us(480);                        // 至少480us
-    
-    GPIO_SetBits(OW_PORT, OW_PIN);        // 释放总线
-    ow_input_mode();
-    Delay_us(70);                         // 等待器件响应
-    
-    presence = !GPIO_ReadInputDataBit(OW_PORT, OW_PIN); // 检查存在脉冲
-    Delay_us(410);                        // 等待存在脉冲结束
+    uint8_t presence = 0;
+    uint8_t late = 0;
+    uint32_t start;
+    uint32_t fall;
+    uint32_t release;
+    uint32_t sample;
+    uint32_t primask;
+    
+    // 每次复位开始一个新的事务
+    ow_txn_close();
+    start = OW_CYCLE_COUNT();
+
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        ow_output_mode();
+        fall = OW_CYCLE_COUNT();
+        GPIO_ResetBits(OW_PORT, OW_PIN);      // 拉低总线
+        Delay_us(480);                        // 至少480us
+        
+        GPIO_SetBits(OW_PORT, OW_PIN);        // 释放总线
+        ow_input_mode();
+        release = OW_CYCLE_COUNT();
+        Delay_us(OW_PRESENCE_SAMPLE_US - OW_PRESENCE_GUARD_US); // 等待器件响应
+        
+        // 按DWT计时对准采样点
+        primask = ow_irq_mask();
+        while (OW_CYCLE_COUNT() - release < OW_PRESENCE_SAMPLE_US * OW_CYCLES_PER_US) {
+            __NOP();
+        }
+        sample = OW_CYCLE_COUNT();
+        late = (sample - release > OW_PRESENCE_LATE_US * OW_CYCLES_PER_US);
+        presence = !GPIO_ReadInputDataBit(OW_PORT, OW_PIN); // 检查存在脉冲
+        ow_irq_restore(primask);
+        Delay_us(410);                        // 等待存在脉冲结束
+        
+        OW_TRACE_SLOT(OW_TRACE_RESET, presence, fall, sample - release);
+        if (late) {
+            ow_stats.presence_late++;
+        }
+        if (presence || !late) {
+            break;
+        }
+    }
     
+    ow_stats.resets++;
+    if (!presence) {
+        ow_stats.reset_no_presence++;
+    }
+    ow_account(start);
     return presence;
 }
 
@@ -136,6 +359,7 @@ static void ow_write_byte(uint8_t byte)
         ow_write_bit(byte & 0x01);
         byte >>= 1;
     }
+    ow_stats.bytes_written++;
 }
 
 // 读取一个字节
@@ -151,27 +375,14 @@ static uint8_t ow_read_byte(void)
         }
     }
     
+    ow_stats.bytes_read++;
     return byte;
 }
 
-// 计算CRC校验
+// 计算CRC校验 (与跟踪回放工具共用同一实现)
 static uint8_t calculate_crc(uint8_t *data, uint8_t length)
 {
-    uint8_t crc = 0;
-    uint8_t i, j;
-    
-    for (i = 0; i < length; i++) {
-        crc ^= data[i];
-        for (j = 0; j < 8; j++) {
-            if (crc & 0x01) {
-                crc = (crc >> 1) ^ 0x8C;
-            } else {
-                crc >>= 1;
-            }
-        }
-    }
-    
-    return crc;
+    return OW_Crc8(data, length);
 }
 
 // Flash操作函数
@@ -205,20 +416,420 @@ static uint8_t Flash_WriteData(uint32_t address, uint32_t *data, uint16_t count)
     return 1;
 }
 
+// 暂存器是否有效: CRC正确且不是全0 (总线被拉低时读到全0，其CRC恰好也是0)
+static uint8_t ds18b20_scratchpad_valid(const uint8_t *scratchpad)
+{
+    uint8_t any = 0;
+
+    for (uint8_t i = 0; i < 9; i++) {
+        any |= scratchpad[i];
+    }
+    return any != 0 && calculate_crc((uint8_t *)scratchpad, 8) == scratchpad[8];
+}
+
+// 复位并寻址: rom_code为NULL时广播；单器件总线上目标即该器件时用SKIP_ROM，否则MATCH_ROM
+// 返回0表示复位无存在脉冲
+static uint8_t ds18b20_select(const uint8_t *rom_code)
+{
+    if (!ow_reset()) {
+        return 0;
+    }
+    if (rom_code == NULL || (single_drop && memcmp(rom_code, single_rom, 8) == 0)) {
+        ow_write_byte(DS18B20_CMD_SKIP_ROM);
+        return 1;
+    }
+    ow_write_byte(DS18B20_CMD_MATCH_ROM);
+    for (uint8_t i = 0; i < 8; i++) {
+        ow_write_byte(rom_code[i]);
+    }
+    return 1;
+}
+
+// 按ROM码读取暂存器，返回1表示CRC正确
+static uint8_t ds18b20_read_scratchpad(const uint8_t *rom_code, uint8_t *scratchpad)
+{
+    memset(scratchpad, 0xFF, 9);
+
+    if (!ds18b20_select(rom_code)) {
+        return 0;  // 总线上没有设备
+    }
+    ow_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
+    
+    for (uint8_t i = 0; i < 9; i++) {
+        scratchpad[i] = ow_read_byte();
+    }
+    
+    return ds18b20_scratchpad_valid(scratchpad);
+}
+
+// 记录启动到首个有效样本的时间
+static void ds18b20_note_first_sample(void)
+{
+    boot_first_sample_ms = (uint32_t)(xTaskGetTickCount() - boot_tick) * portTICK_PERIOD_MS;
+    if (boot_first_sample_ms == 0) {
+        boot_first_sample_ms = 1;
+    }
+    DS_LOG_INFO(LOG_EVT_FIRST_SAMPLE, boot_first_sample_ms, 0, 0);
+}
+
+// 各分辨率的最长转换时间
+static uint16_t ds18b20_conv_time_ms(uint8_t resolution)
+{
+    return (uint16_t)(DS18B20_CONV_TIME_MS >> (3 - (resolution & 0x03)));
+}
+
+// 发出广播转换，返回0表示复位无存在脉冲、转换未发出
+static uint8_t ds18b20_start_conversion(void)
+{
+    if (!ds18b20_select(NULL)) {             // 跳过ROM命令 (广播命令)
+        return 0;
+    }
+    ow_write_byte(DS18B20_CMD_CONVERT_T);    // 启动温度转换
+    return 1;
+}
+
+// 等待进行中的广播转换完成并丢弃 (写配置前调用)
+static void ds18b20_conv_discard(void)
+{
+    if (conv_pending) {
+        TickType_t elapsed = xTaskGetTickCount() - conv_tick;
+        TickType_t conv_ticks = ds18b20_conv_time_ms(DS18B20_DEFAULT_RESOLUTION) / portTICK_PERIOD_MS;
+
+        conv_pending = 0;
+        if (elapsed < conv_ticks) {
+            vTaskDelay(conv_ticks - elapsed);
+        }
+    }
+}
+
+// 读电源供电状态: 寄生供电的器件在读时隙拉低总线，无应答时按寄生供电处理
+static uint8_t ds18b20_detect_parasite(void)
+{
+    if (!ds18b20_select(NULL)) {
+        return 1;
+    }
+    ow_write_byte(DS18B20_CMD_READ_POWER_SUPPLY);
+    return ow_read_bit() == 0;
+}
+
+// 把暂存器的TH/TL/配置复制到传感器EEPROM，rom_code为NULL时广播给全部器件
+// 所有写暂存器都随后复制，未改写的器件暂存器与EEPROM一致，广播复制不改变其配置
+static void ds18b20_copy_scratchpad(const uint8_t *rom_code)
+{
+    if (!ds18b20_select(rom_code)) {
+        return;
+    }
+    ow_write_byte(DS18B20_CMD_COPY_SCRATCHPAD);
+    
+    // 推挽输出保持高电平，兼作寄生供电的强上拉
+    Delay_ms(DS18B20_EEPROM_WRITE_MS);
+}
+
+// 按ROM码写入TH/TL/配置寄存器，persist为1时复制到传感器EEPROM
+static void ds18b20_write_config(const uint8_t *rom_code, uint8_t config, uint8_t persist)
+{
+    if (!ds18b20_select(rom_code)) {
+        return;  // 重置失败
+    }
+    
+    ow_write_byte(DS18B20_CMD_WRITE_SCRATCHPAD);  // 写暂存器命令
+    ow_write_byte(DS18B20_ALARM_TH);    // TH寄存器 (高温报警阈值)
+    ow_write_byte(DS18B20_ALARM_TL);    // TL寄存器 (低温报警阈值)
+    ow_write_byte(config);              // 配置寄存器
+    
+    if (persist) {
+        ds18b20_copy_scratchpad(rom_code);
+    }
+}
+
+// 以给定时序读取在线器件的暂存器rounds轮，返回CRC错误的次数 (超过max_fail即停止)
+// all为0时只读在线器件中均匀选取的至多OW_CAL_DEVICES个，用于扫描和复核；没有在线器件时返回0xFF
+static uint8_t ow_timing_failures(uint8_t sample_us, uint8_t recovery_us, uint8_t rounds, uint8_t all,
+                                  uint8_t max_fail)
+{
+    ow_timing_t saved = ow_timing;
+    uint8_t scratchpad[9];
+    uint8_t present = 0;
+    uint8_t step;
+    uint8_t failures = 0;
+
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (ds18b20_devices[i].present && ds18b20_devices[i].rom_code[0] != 0x00) {
+            present++;
+        }
+    }
+    if (present == 0) {
+        return 0xFF;
+    }
+    step = all ? 1 : (uint8_t)((present + OW_CAL_DEVICES - 1) / OW_CAL_DEVICES);
+
+    ow_timing.sample_us = sample_us;
+    ow_timing.recovery_us = recovery_us;
+    for (uint8_t round = 0; round < rounds && failures <= max_fail; round++) {
+        uint8_t index = 0;
+
+        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS && failures <= max_fail; i++) {
+            if (!ds18b20_devices[i].present || ds18b20_devices[i].rom_code[0] == 0x00 ||
+                index++ % step != 0) {
+                continue;
+            }
+            if (!ds18b20_read_scratchpad(ds18b20_devices[i].rom_code, scratchpad)) {
+                failures++;
+            }
+        }
+    }
+    ow_timing = saved;
+    return failures;
+}
+
+// 以给定时序全部读取正确时返回1 (第一次失败即返回，不可用的扫描点只占用一次读取)
+static uint8_t ow_timing_check(uint8_t sample_us, uint8_t recovery_us, uint8_t rounds, uint8_t all)
+{
+    return ow_timing_failures(sample_us, recovery_us, rounds, all, 0) == 0;
+}
+
+// 余量复核: 采样点前后各偏移余量、恢复时间减去余量后与当前时序比较错误次数。
+// 随机干扰在各时序下错误率相近，只有偏移点明显多于当前时序时才判定余量不足
+static uint8_t ow_timing_margin_ok(void)
+{
+    uint8_t recovery = ow_timing.recovery_us;
+    uint8_t edge;
+    uint8_t nominal;
+
+    if (recovery > OW_CAL_RECOVERY_MARGIN_US) {
+        recovery -= OW_CAL_RECOVERY_MARGIN_US;
+    }
+    edge = ow_timing_failures(ow_timing.sample_us - OW_CAL_SAMPLE_MARGIN_US, recovery, OW_CAL_ROUNDS, 0, 0xFE);
+    edge += ow_timing_failures(ow_timing.sample_us + OW_CAL_SAMPLE_MARGIN_US, recovery, OW_CAL_ROUNDS, 0, 0xFE);
+    if (edge == 0) {
+        return 1;
+    }
+    nominal = ow_timing_failures(ow_timing.sample_us, ow_timing.recovery_us, OW_CAL_ROUNDS, 0, 0xFE);
+    return edge <= 2 * nominal + OW_CAL_ROUNDS * OW_CAL_DEVICES / 2;
+}
+
+// 时序参数与Flash中保存的不同时写回；尚未调试 (无有效配置) 时随调试一起保存
+static void ds18b20_store_timing(void)
+{
+    const ds18b20_config_t *config = (const ds18b20_config_t *)FLASH_ADDR_TO_PTR(FLASH_CONFIG_PAGE_ADDR);
+
+    if (config->magic != DS18B20_CONFIG_MAGIC || !config->configured ||
+        memcmp(&config->timing, &ow_timing, sizeof(ow_timing)) == 0) {
+        return;
+    }
+    DS18B20_SaveConfig();
+}
+
+// 时序校准: 恢复时间从短到长，每档扫描采样点，取最长的连续可通过采样窗口；
+// 第一档窗口两侧都有余量的恢复时间即最快可用参数，采样点取窗口中心，恢复时间再加余量，
+// 全部在线器件确认通过后生效并保存。找不到可用参数时保持当前时序，标记为未校准
+// 开始校准，返回0表示没有在线器件 (不做任何改变)
+static uint8_t ow_cal_begin(void)
+{
+    uint8_t present = 0;
+
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (ds18b20_devices[i].present && ds18b20_devices[i].rom_code[0] != 0x00) {
+            present = 1;
+            break;
+        }
+    }
+    if (!present) {
+        ow_cal.work = OW_WORK_NONE;
+        return 0;
+    }
+    // 转换期间寄生供电的器件不能通信，先等进行中的转换结束 (外部供电时转换中也能读暂存器)
+    if (parasite_power) {
+        ds18b20_conv_discard();
+    }
+    ow_cal.work = OW_WORK_SWEEP;
+    ow_cal.step = 0;
+    ow_cal.sample = OW_CAL_SAMPLE_MIN_US;
+    ow_cal.run_len = 0;
+    ow_cal.best_len = 0;
+    ow_cal.result = 0;
+    return 1;
+}
+
+// 扫描一个采样点；一档扫描完时选定参数并确认，通过则结束，否则进入下一档
+static void ow_cal_step(void)
+{
+    uint8_t recovery = ow_cal_recovery_steps[ow_cal.step];
+    uint8_t sample;
+
+    if (ow_cal.sample <= OW_CAL_SAMPLE_MAX_US) {
+        if (!ow_timing_check(ow_cal.sample, recovery, OW_CAL_ROUNDS, 0)) {
+            ow_cal.run_len = 0;
+        } else {
+            if (ow_cal.run_len++ == 0) {
+                ow_cal.run_start = ow_cal.sample;
+            }
+            if (ow_cal.run_len > ow_cal.best_len) {
+                ow_cal.best_start = ow_cal.run_start;
+                ow_cal.best_len = ow_cal.run_len;
+            }
+        }
+        ow_cal.sample++;
+        return;
+    }
+
+    if (ow_cal.best_len >= 2 * OW_CAL_SAMPLE_MARGIN_US + 1) {
+        sample = (uint8_t)(ow_cal.best_start + (ow_cal.best_len - 1) / 2);
+        recovery += OW_CAL_RECOVERY_MARGIN_US;
+        if (ow_timing_check(sample, recovery, OW_CAL_VERIFY_ROUNDS, 1)) {
+            ow_timing.sample_us = sample;
+            ow_timing.recovery_us = recovery;
+            ow_timing.tag = OW_TIMING_TAG;
+            DS_LOG_INFO(LOG_EVT_OW_TIMING, ow_timing.sample_us, ow_timing.recovery_us, ow_cal.best_len);
+            ds18b20_store_timing();
+            ow_cal.result = 1;
+            ow_cal.work = OW_WORK_NONE;
+            return;
+        }
+    }
+
+    if (++ow_cal.step < sizeof(ow_cal_recovery_steps)) {
+        ow_cal.sample = OW_CAL_SAMPLE_MIN_US;
+        ow_cal.run_len = 0;
+        ow_cal.best_len = 0;
+        return;
+    }
+    ow_timing.tag = 0;
+    DS_LOG_WARN(LOG_EVT_OW_TIMING_FAIL, 0, 0, 0);
+    ow_cal.work = OW_WORK_NONE;
+}
+
+// 一次完成校准 (初始化和基准测试使用)，返回1表示已采用校准结果；没有在线器件时不做任何改变
+uint8_t DS18B20_CalibrateTiming(void)
+{
+    if (!ow_cal_begin()) {
+        return 0;
+    }
+    while (ow_cal.work == OW_WORK_SWEEP) {
+        ow_cal_step();
+    }
+    return ow_cal.result;
+}
+
+// 开始分步校准 (由DS18B20_TimingStep推进)，没有在线器件时返回0
+uint8_t DS18B20_StartTimingCalibration(void)
+{
+    return ow_cal_begin();
+}
+
+// 获取当前总线时序
+void DS18B20_GetTiming(ow_timing_t *timing)
+{
+    *timing = ow_timing;
+}
+
+// 按当前时序逐个读取已配置位置的暂存器: CRC正确即认为在线，
+// 与期望的TH/TL/分辨率不一致的位置记入rewrite (为NULL时不比较)，返回在线数量
+static uint8_t ds18b20_detect(uint8_t expected_config, ds18b20_mask_t *rewrite)
+{
+    uint8_t scratchpad[9];
+    uint8_t count = 0;
+
+    if (rewrite != NULL) {
+        *rewrite = 0;
+    }
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        // 未配置的位置(ROM码为空)不占用总线
+        if (ds18b20_devices[i].rom_code[0] == 0x00 ||
+            !ds18b20_read_scratchpad(ds18b20_devices[i].rom_code, scratchpad)) {
+            ds18b20_devices[i].present = 0;
+            continue;
+        }
+        
+        count++;
+        ds18b20_devices[i].present = 1;
+        
+        if (rewrite != NULL && (scratchpad[2] != DS18B20_ALARM_TH || scratchpad[3] != DS18B20_ALARM_TL ||
+            (scratchpad[4] & 0x60) != (expected_config & 0x60))) {
+            *rewrite |= DS18B20_MASK_BIT(i);
+            DS_LOG_INFO(LOG_EVT_CFG_REWRITTEN, i + 1, scratchpad[4], 0);
+        }
+    }
+    return count;
+}
+
+// 当前时序下全部位置连续读取失败时调用: 线缆变化可能使时序失效，按保守时序重新检测，
+// 读到器件则重新校准，否则 (器件确实全部离线) 恢复原时序
+static void ds18b20_timing_rescue(void)
+{
+    ow_timing_t saved = ow_timing;
+    uint8_t count;
+
+    ow_timing.sample_us = OW_TIMING_SAFE_SAMPLE_US;
+    ow_timing.recovery_us = OW_TIMING_SAFE_RECOVERY_US;
+    ow_timing.tag = 0;
+    count = ds18b20_detect(0, NULL);
+    if (count == 0) {
+        ow_timing = saved;
+        return;
+    }
+    ds18b20_count = count;
+    DS_LOG_WARN(LOG_EVT_OW_MARGIN_LOST, saved.sample_us, saved.recovery_us, 0);
+    ow_cal_begin();
+    timing_check_countdown = OW_CAL_CHECK_CYCLES;
+}
+
+// 推进一步时序维护 (在总线任务中、没有待处理请求时调用)，返回1表示还有待做的工作
+uint8_t DS18B20_TimingStep(void)
+{
+    switch (ow_cal.work) {
+    case OW_WORK_MARGIN:
+        // 未校准时校准，已校准时复核余量，余量不足时重新校准
+        ow_cal.work = OW_WORK_NONE;
+        if (ow_timing.tag == OW_TIMING_TAG) {
+            if (ow_timing_margin_ok()) {
+                break;
+            }
+            DS_LOG_WARN(LOG_EVT_OW_MARGIN_LOST, ow_timing.sample_us, ow_timing.recovery_us, 0);
+        }
+        ow_cal_begin();
+        break;
+    case OW_WORK_RESCUE:
+        ow_cal.work = OW_WORK_NONE;
+        ds18b20_timing_rescue();
+        break;
+    case OW_WORK_SWEEP:
+        ow_cal_step();
+        break;
+    default:
+        break;
+    }
+    return ow_cal.work != OW_WORK_NONE;
+}
+
 // 初始化函数，改为加载保存的配置
+// 每个位置只读一次暂存器: CRC正确即认为在线，并与期望的TH/TL/分辨率比较，
+// 仅在不一致时重写并复制到传感器EEPROM，随后立即发出首次广播转换
 void DS18B20_Init(void)
 {
+    uint8_t configured = 0;
+    uint8_t expected_config = 0x1F | (DS18B20_DEFAULT_RESOLUTION << 5);
+    ds18b20_mask_t rewrite = 0;
+    
+    boot_tick = xTaskGetTickCount();
+    boot_first_sample_ms = 0;
+    conv_pending = 0;
+    
     RCC_APB2PeriphClockCmd(OW_RCC, ENABLE);
+    OW_CYCLE_COUNTER_INIT();
     
     ow_output_mode();
     GPIO_SetBits(OW_PORT, OW_PIN);
     
     // 清空设备数组
     memset(ds18b20_devices, 0, sizeof(ds18b20_devices));
+    ow_timing.sample_us = OW_TIMING_DEFAULT_SAMPLE_US;
+    ow_timing.recovery_us = OW_TIMING_DEFAULT_RECOVERY_US;
+    ow_timing.tag = 0;
     
     // 尝试从Flash加载配置
     if (!DS18B20_LoadConfig()) {
-        printf("No valid configuration found, initializing with defaults\r\n");
+        DS_LOG_WARN(LOG_EVT_CFG_DEFAULTS, 0, 0, 0);
         // 如果没有有效配置，则初始化为默认状态
         for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
             ds18b20_devices[i].present = 0;
@@ -226,125 +837,249 @@ void DS18B20_Init(void)
         }
     }
     
-    Delay_ms(100);
-    
-    // 检测总线上的传感器
-    ds18b20_count = 0;
+    // 检测总线上的传感器并校验配置 (使用保存的时序，未校准时为默认时序)
+    single_drop = 0;
     for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-        if (DS18B20_CheckSensorPresent(i)) {
-            ds18b20_count++;
-            ds18b20_devices[i].present = 1;
+        if (ds18b20_devices[i].rom_code[0] != 0x00) {
+            configured++;
+        }
+    }
+    ds18b20_count = ds18b20_detect(expected_config, &rewrite);
+    
+    // 有已配置位置无应答时按保守时序重新检测: 长线缆上默认时序或过时的校准结果可能读不到器件，
+    // 保守时序下读到更多器件时重新校准，否则沿用原时序 (器件确实不在线)
+    if (ds18b20_count < configured) {
+        ow_timing_t loaded = ow_timing;
+        ds18b20_mask_t rewrite_safe;
+        uint8_t count;
+        
+        ow_timing.sample_us = OW_TIMING_SAFE_SAMPLE_US;
+        ow_timing.recovery_us = OW_TIMING_SAFE_RECOVERY_US;
+        ow_timing.tag = 0;
+        count = ds18b20_detect(expected_config, &rewrite_safe);
+        if (count > ds18b20_count) {
+            ds18b20_count = count;
+            rewrite = rewrite_safe;
         } else {
-            ds18b20_devices[i].present = 0;
+            ow_timing = loaded;
+        }
+    }
+    
+    // 未校准 (首次启动、旧版本配置或上面改用了保守时序) 时校准；
+    // 启动时没有在线器件则在调试后首个有读数的采集周期校准
+    if (ds18b20_count > 0 && ow_timing.tag != OW_TIMING_TAG) {
+        DS18B20_CalibrateTiming();
+    }
+    timing_check_countdown = (ds18b20_count > 0) ? OW_CAL_CHECK_CYCLES : 1;
+    timing_dead_cycles = 0;
+    
+    // 确定寻址方式，之后的事务在单器件总线上跳过ROM
+    ds18b20_classify_bus();
+    
+    // 配置不一致的器件逐个写暂存器，最后只复制一次EEPROM (多个器件时广播复制)
+    if (rewrite != 0) {
+        int8_t last = -1;
+        uint8_t rewritten = 0;
+        
+        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+            if (rewrite & DS18B20_MASK_BIT(i)) {
+                ds18b20_write_config(ds18b20_devices[i].rom_code, expected_config, 0);
+                last = (int8_t)i;
+                rewritten++;
+            }
         }
+        ds18b20_copy_scratchpad((rewritten == 1) ? ds18b20_devices[last].rom_code : NULL);
+    }
+    
+    // 外部供电时尽早发出首次广播转换，首个采样周期直接读取结果；
+    // 寄生供电时转换期间不能有其他总线通信，由首次读取阻塞等待
+    parasite_power = (ds18b20_count > 0) ? ds18b20_detect_parasite() : 1;
+    if (ds18b20_count > 0 && !parasite_power && ds18b20_start_conversion()) {
+        conv_tick = xTaskGetTickCount();
+        conv_pending = 1;
     }
     
-    printf("DS18B20 initialization complete, %d sensors active\r\n", ds18b20_count);
+    DS_LOG_INFO(LOG_EVT_INIT_DONE, ds18b20_count, 0, 0);
+}
+
+// 获取启动到首个有效样本的时间(ms)，尚未获得时返回0
+uint32_t DS18B20_GetBootToFirstSampleMs(void)
+{
+    return boot_first_sample_ms;
+}
+
+// ow_search_next的返回值
+#define OW_SEARCH_END               0       // 没有更多器件或搜索中断
+#define OW_SEARCH_FOUND             1       // 找到有效器件
+#define OW_SEARCH_CRC_ERR           2       // 本分支ROM码CRC错误，搜索状态已前进，可以继续搜索
+
+// 搜索ROM: 查找总线上的下一个器件
+// rom_code保存上一次的结果，last_discrepancy/last_device为搜索状态
+static uint8_t ow_search_next(uint8_t *rom_code, uint8_t *last_discrepancy, uint8_t *last_device)
+{
+    uint8_t id_bit_number = 1;
+    uint8_t last_zero = 0;
+    uint8_t rom_byte_number = 0;
+    uint8_t rom_byte_mask = 1;
+    uint8_t id_bit, cmp_id_bit, direction;
+
+    if (*last_device) {
+        return 0;
+    }
+
+    if (!ow_reset()) {
+        *last_discrepancy = 0;
+        *last_device = 1;
+        return 0;
+    }
+
+    ow_write_byte(DS18B20_CMD_SEARCH_ROM);
+
+    // 64位ROM码搜索
+    while (rom_byte_number < 8) {
+        // 读取两位：ID位和补位
+        id_bit = ow_read_bit();
+        cmp_id_bit = ow_read_bit();
+
+        if (id_bit && cmp_id_bit) {
+            // 没有器件应答
+            break;
+        }
+
+        if (id_bit != cmp_id_bit) {
+            // 所有器件在该位相同
+            direction = id_bit;
+        } else {
+            // 冲突位：先走上次选择的分支，到达上次冲突位时改走1分支
+            if (id_bit_number < *last_discrepancy) {
+                direction = (rom_code[rom_byte_number] & rom_byte_mask) ? 1 : 0;
+            } else {
+                direction = (id_bit_number == *last_discrepancy);
+            }
+            if (!direction) {
+                last_zero = id_bit_number;
+            }
+        }
+
+        // 保存ROM码位
+        if (direction) {
+            rom_code[rom_byte_number] |= rom_byte_mask;
+        } else {
+            rom_code[rom_byte_number] &= (uint8_t)~rom_byte_mask;
+        }
+
+        // 搜索分支选择
+        ow_write_bit(direction);
+
+        // 准备下一位
+        id_bit_number++;
+        rom_byte_mask <<= 1;
+        if (rom_byte_mask == 0) {
+            rom_byte_number++;
+            rom_byte_mask = 1;
+        }
+    }
+
+    if (id_bit_number < 65) {
+        // 搜索中断，重新开始
+        *last_discrepancy = 0;
+        *last_device = 1;
+        return 0;
+    }
+
+    *last_discrepancy = last_zero;
+    if (last_zero == 0) {
+        *last_device = 1;
+    }
+
+    // 检查CRC
+    if (calculate_crc(rom_code, 7) != rom_code[7]) {
+        ow_stats.crc_errors_rom++;
+        OW_TRACE_MARK_EVENT(OW_TRACE_MARK_ROM_CRC, 0);
+        DS_LOG_WARN(LOG_EVT_SEARCH_CRC, 0, 0, 0);
+        return OW_SEARCH_CRC_ERR;
+    }
+
+    return OW_SEARCH_FOUND;
+}
+
+// 一次搜索遍历总线上的所有器件，返回找到的数量
+// CRC错误的分支已记入统计和日志，跳过后继续遍历其余分支 (错误次数超过max_count时放弃)
+static uint8_t ow_search_all(uint8_t rom_codes[][8], uint8_t max_count)
+{
+    uint8_t rom_code[8] = {0};
+    uint8_t last_discrepancy = 0;
+    uint8_t last_device = 0;
+    uint8_t devices_found = 0;
+    uint8_t errors = 0;
+    uint8_t result;
+
+    while (devices_found < max_count &&
+           (result = ow_search_next(rom_code, &last_discrepancy, &last_device)) != OW_SEARCH_END) {
+        if (result == OW_SEARCH_CRC_ERR) {
+            if (++errors > max_count) {
+                break;
+            }
+            continue;
+        }
+        memcpy(rom_codes[devices_found], rom_code, 8);
+        devices_found++;
+        DS_LOG_INFO(LOG_EVT_SEARCH_FOUND, devices_found, DS_LOG_ROM_HI(rom_code), DS_LOG_ROM_LO(rom_code));
+    }
+
+    return devices_found;
+}
+
+// 判定总线拓扑: 恰有一个已配置位置在线，且一次搜索只找到该器件时为单器件总线
+// 搜索同时复核ROM身份: 器件被更换或总线上多出器件时回到MATCH_ROM寻址
+static void ds18b20_classify_bus(void)
+{
+    uint8_t rom_code[8] = {0};
+    uint8_t last_discrepancy = 0;
+    uint8_t last_device = 0;
+    int8_t index = -1;
+    uint8_t single = 0;
+
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (!ds18b20_devices[i].present || ds18b20_devices[i].rom_code[0] == 0x00) {
+            continue;
+        }
+        if (index >= 0) {
+            index = -1;
+            break;
+        }
+        index = (int8_t)i;
+    }
+
+    // 只找到一个器件时搜索不会遇到冲突位，last_device随之置位
+    if (index >= 0 && ow_search_next(rom_code, &last_discrepancy, &last_device) == OW_SEARCH_FOUND && last_device &&
+        memcmp(rom_code, ds18b20_devices[index].rom_code, 8) == 0) {
+        single = 1;
+        memcpy(single_rom, rom_code, 8);
+    }
+
+    if (single != single_drop) {
+        DS_LOG_INFO(LOG_EVT_BUS_TOPOLOGY, single, index + 1, 0);
+    }
+    single_drop = single;
+    rom_check_countdown = DS18B20_ROM_CHECK_CYCLES;
 }
 
 // 搜索所有传感器
 uint8_t DS18B20_SearchSensors(void)
 {
-    uint8_t sensor_count = 0;
     uint8_t rom_codes[MAX_DS18B20_SENSORS][8];
     uint8_t devices_found = 0;
-    uint8_t last_device = 0;
-    uint8_t last_discrepancy = 0;
     
-    printf("Searching for DS18B20 sensors...\r\n");
+    DS_LOG_INFO(LOG_EVT_SEARCH_START, 0, 0, 0);
     
     // 检查总线上是否有设备
     if (!ow_reset()) {
-        printf("No devices present on 1-Wire bus\r\n");
+        DS_LOG_WARN(LOG_EVT_SEARCH_NO_DEVICE, 0, 0, 0);
         return 0;
     }
     
-    // 搜索ROM算法
-    do {
-        uint8_t rom_code[8];
-        uint8_t bit_number = 1;
-        uint8_t last_zero = 0;
-        uint8_t rom_byte_number = 0;
-        uint8_t rom_byte_mask = 1;
-        uint8_t search_result = 0;
-        uint8_t id_bit, cmp_id_bit;
-        
-        // 发送搜索ROM命令
-        ow_reset();
-        ow_write_byte(DS18B20_CMD_SEARCH_ROM);
-        
-        // 64位ROM码搜索
-        for (bit_number = 1; bit_number <= 64; bit_number++) {
-            // 读取两位：ID位和补位
-            id_bit = ow_read_bit();
-            cmp_id_bit = ow_read_bit();
-            
-            if (id_bit && cmp_id_bit) {
-                // 没有设备或错误
-                break;
-            }
-            
-            if (bit_number <= last_discrepancy)
-                rom_byte_mask = ((last_device >> (bit_number - 1)) & 0x01);
-            else
-                rom_byte_mask = (id_bit != cmp_id_bit) ? id_bit : 1;
-            
-            // 搜索分支选择
-            ow_write_bit(rom_byte_mask);
-            
-            // 保存ROM码位
-            if (rom_byte_mask) {
-                rom_code[rom_byte_number] |= rom_byte_mask;
-            } else {
-                rom_code[rom_byte_number] &= ~rom_byte_mask;
-                last_zero = bit_number;
-            }
-            
-            // 准备下一位
-            rom_byte_mask <<= 1;
-            if (rom_byte_mask == 0) {
-                rom_byte_number++;
-                rom_byte_mask = 1;
-            }
-        }
-        
-        // 检查是否找到设备
-        if (bit_number == 65) {
-            // 检查CRC
-            uint8_t crc = calculate_crc(rom_code, 7);
-            if (crc == rom_code[7]) {
-                // 保存找到的ROM码
-                memcpy(rom_codes[devices_found], rom_code, 8);
-                devices_found++;
-                
-                printf("Found device %d, ROM: ", devices_found);
-                for (int i = 0; i < 8; i++) {
-                    printf("%02X ", rom_code[i]);
-                }
-                printf("\r\n");
-                
-                // 更新搜索状态
-                last_discrepancy = last_zero;
-                search_result = 1;
-                
-                if (devices_found >= MAX_DS18B20_SENSORS) {
-                    // 达到最大支持数量
-                    break;
-                }
-            } else {
-                printf("CRC error in device search\r\n");
-                search_result = 0;
-            }
-        } else {
-            search_result = 0;
-        }
-        
-        // 检查是否继续搜索
-        if (!search_result || !last_discrepancy) {
-            break;
-        }
-        
-    } while (devices_found < MAX_DS18B20_SENSORS);
+    devices_found = ow_search_all(rom_codes, MAX_DS18B20_SENSORS);
     
     // 如果处于学习模式，不要覆盖现有配置
     if (ds18b20_config_mode == CONFIG_MODE_NORMAL) {
@@ -361,8 +1096,9 @@ uint8_t DS18B20_SearchSensors(void)
         
         ds18b20_count = devices_found;
     }
+    ds18b20_classify_bus();
     
-    printf("Search complete, found %d DS18B20 sensors\r\n", devices_found);
+    DS_LOG_INFO(LOG_EVT_SEARCH_DONE, devices_found, 0, 0);
     return devices_found;
 }
 
@@ -384,21 +1120,19 @@ uint8_t DS18B20_DiscoverSingleSensor(uint8_t *rom_code)
     // 验证CRC
     uint8_t crc = calculate_crc(rom_code, 7);
     if (crc != rom_code[7]) {
-        printf("CRC error in ROM code\r\n");
+        ow_stats.crc_errors_rom++;
+        OW_TRACE_MARK_EVENT(OW_TRACE_MARK_ROM_CRC, 0);
+        DS_LOG_WARN(LOG_EVT_ROM_CRC, 0, 0, 0);
         return 0;
     }
     
     // 验证ROM码首字节是否为0x28 (DS18B20的家族码)
     if (rom_code[0] != 0x28) {
-        printf("Device is not a DS18B20 (family code: %02X)\r\n", rom_code[0]);
+        DS_LOG_WARN(LOG_EVT_ROM_FAMILY, rom_code[0], 0, 0);
         return 0;
     }
     
-    printf("Discovered DS18B20, ROM: ");
-    for (int i = 0; i < 8; i++) {
-        printf("%02X ", rom_code[i]);
-    }
-    printf("\r\n");
+    DS_LOG_INFO(LOG_EVT_DISCOVERED, DS_LOG_ROM_HI(rom_code), DS_LOG_ROM_LO(rom_code), 0);
     
     return 1;
 }
@@ -407,12 +1141,11 @@ uint8_t DS18B20_DiscoverSingleSensor(uint8_t *rom_code)
 void DS18B20_LearnSensor(uint8_t position)
 {
     if (position >= MAX_DS18B20_SENSORS) {
-        printf("Invalid position %d\r\n", position);
+        DS_LOG_ERROR(LOG_EVT_LEARN_BAD_POS, position, 0, 0);
         return;
     }
     
-    printf("Learning sensor for position %d...\r\n", position + 1);
-    printf("Please ensure only ONE sensor is connected to the bus\r\n");
+    DS_LOG_INFO(LOG_EVT_LEARN_START, position + 1, 0, 0);
     
     uint8_t rom_code[8];
     if (DS18B20_DiscoverSingleSensor(rom_code)) {
@@ -420,22 +1153,227 @@ void DS18B20_LearnSensor(uint8_t position)
         memcpy(ds18b20_devices[position].rom_code, rom_code, 8);
         ds18b20_devices[position].present = 1;
         
-        printf("Learned sensor for position %d: ", position + 1);
-        for (int i = 0; i < 8; i++) {
-            printf("%02X ", rom_code[i]);
-        }
-        printf("\r\n");
+        DS_LOG_INFO(LOG_EVT_LEARN_OK, position + 1, DS_LOG_ROM_HI(rom_code), DS_LOG_ROM_LO(rom_code));
         
         // 测试一下传感器
         float temp = DS18B20_ReadTemperature(position);
         if (temp > DS18B20_TEMP_MIN && temp < DS18B20_TEMP_MAX) {
-            printf("Sensor test successful: %.2f°C\r\n", temp);
+            DS_LOG_INFO(LOG_EVT_LEARN_TEST_OK, DS_LOG_CENTI(temp), 0, 0);
+        } else {
+            DS_LOG_WARN(LOG_EVT_LEARN_TEST_FAIL, DS_LOG_CENTI(temp), 0, 0);
+        }
+    } else {
+        DS_LOG_WARN(LOG_EVT_LEARN_FAIL, position + 1, 0, 0);
+    }
+}
+
+// 设置批量调试的ROM映射表项 (position从0开始)，返回1表示ROM码有效
+uint8_t DS18B20_SetCommissionEntry(uint8_t position, const uint8_t *rom_code)
+{
+    if (position >= MAX_DS18B20_SENSORS) {
+        return 0;
+    }
+    if (rom_code[0] != 0x28 || calculate_crc((uint8_t *)rom_code, 7) != rom_code[7]) {
+        return 0;
+    }
+    
+    // 映射表由配置任务写入、总线任务读取，整项在临界区内写入
+    taskENTER_CRITICAL();
+    memcpy(commission_table[position], rom_code, 8);
+    commission_table_set[position] = 1;
+    taskEXIT_CRITICAL();
+    return 1;
+}
+
+// 清空ROM映射表
+void DS18B20_ClearCommissionTable(void)
+{
+    taskENTER_CRITICAL();
+    memset(commission_table, 0, sizeof(commission_table));
+    memset(commission_table_set, 0, sizeof(commission_table_set));
+    commission_pending = 0;
+    taskEXIT_CRITICAL();
+}
+
+// 请求按映射表调试 (由采集任务执行总线操作)
+void DS18B20_RequestCommission(void)
+{
+    commission_pending = 1;
+}
+
+// 是否有待执行的映射表调试
+uint8_t DS18B20_CommissionPending(void)
+{
+    return commission_pending;
+}
+
+// 按映射表批量调试: 一次搜索遍历总线，将表中ROM码映射到位置，一次写入Flash
+uint8_t DS18B20_CommissionFromTable(void)
+{
+    uint8_t rom_codes[MAX_DS18B20_SENSORS][8];
+    uint8_t table[MAX_DS18B20_SENSORS][8];
+    uint8_t table_set[MAX_DS18B20_SENSORS];
+    uint8_t found;
+    uint8_t assigned = 0;
+    
+    // 配置任务可能同时在写映射表，先在临界区内复制一份
+    taskENTER_CRITICAL();
+    memcpy(table, commission_table, sizeof(table));
+    memcpy(table_set, commission_table_set, sizeof(table_set));
+    commission_pending = 0;
+    taskEXIT_CRITICAL();
+    
+    found = ow_search_all(rom_codes, MAX_DS18B20_SENSORS);
+    DS_LOG_INFO(LOG_EVT_COMMISSION_START, found, 0, 0);
+    
+    for (uint8_t pos = 0; pos < MAX_DS18B20_SENSORS; pos++) {
+        uint8_t on_bus = 0;
+        
+        if (!table_set[pos]) {
+            continue;  // 未给出的位置保持原配置
+        }
+        
+        for (uint8_t i = 0; i < found; i++) {
+            if (memcmp(rom_codes[i], table[pos], 8) == 0) {
+                on_bus = 1;
+                break;
+            }
+        }
+        
+        // 不在总线上的ROM码仍然保存，待传感器接入后自动恢复
+        memcpy(ds18b20_devices[pos].rom_code, table[pos], 8);
+        ds18b20_devices[pos].present = on_bus;
+        if (on_bus) {
+            assigned++;
+            DS_LOG_INFO(LOG_EVT_COMMISSION_ASSIGNED, pos + 1, DS_LOG_ROM_HI(table[pos]), DS_LOG_ROM_LO(table[pos]));
+        } else {
+            DS_LOG_WARN(LOG_EVT_COMMISSION_MISSING, pos + 1, 0, 0);
+        }
+    }
+    
+    ds18b20_count = 0;
+    for (uint8_t pos = 0; pos < MAX_DS18B20_SENSORS; pos++) {
+        ds18b20_count += ds18b20_devices[pos].present;
+    }
+    
+    DS18B20_SaveConfig();
+    DS_LOG_INFO(LOG_EVT_COMMISSION_DONE, assigned, 0, 0);
+    return assigned;
+}
+
+// 广播启动转换并等待完成
+static void ds18b20_convert_all_wait(void)
+{
+    DS18B20_StartConversion();
+    Delay_ms(DS18B20_CONV_TIME_MS);
+}
+
+// 按加热刺激批量调试: 开始时一次搜索遍历总线并建立基线，之后每轮一次转换 (DS18B20_StimulusStep)，
+// 升温超过阈值的传感器映射到当前位置，全部完成后一次写入Flash。
+// 每轮是一个单独的总线请求，轮与轮之间总线任务照常处理读取和诊断请求
+static struct {
+    uint8_t active;               // 调试进行中
+    uint8_t found;                // 搜索到的传感器数量
+    uint8_t candidates;           // 其中可读的数量
+    uint8_t done;                 // 已映射的数量
+    uint8_t pos;                  // 当前提示加热的位置
+    uint16_t cycle;               // 当前位置已等待的转换次数
+    uint8_t rom_codes[MAX_DS18B20_SENSORS][8];
+    int16_t baseline[MAX_DS18B20_SENSORS];
+    uint8_t assigned[MAX_DS18B20_SENSORS];
+} stimulus;
+
+// 开始加热刺激调试，返回参与映射的传感器数量 (为0时不进入调试，配置不变)
+uint8_t DS18B20_StimulusBegin(void)
+{
+    uint8_t scratchpad[9];
+    
+    memset(&stimulus, 0, sizeof(stimulus));
+    stimulus.found = ow_search_all(stimulus.rom_codes, MAX_DS18B20_SENSORS);
+    DS_LOG_INFO(LOG_EVT_COMMISSION_START, stimulus.found, 0, 0);
+    if (stimulus.found == 0) {
+        return 0;
+    }
+    
+    // 一次广播转换建立所有传感器的基线温度
+    ds18b20_convert_all_wait();
+    for (uint8_t i = 0; i < stimulus.found; i++) {
+        if (ds18b20_read_scratchpad(stimulus.rom_codes[i], scratchpad)) {
+            stimulus.baseline[i] = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+            stimulus.candidates++;
         } else {
-            printf("Sensor test failed: %.2f°C\r\n", temp);
+            stimulus.assigned[i] = 1;  // 无法读取的传感器不参与映射
+        }
+    }
+    if (stimulus.candidates == 0) {
+        return 0;
+    }
+    
+    // 重新建立位置配置
+    memset(ds18b20_devices, 0, sizeof(ds18b20_devices));
+    ds18b20_count = 0;
+    stimulus.active = 1;
+    DS_LOG_INFO(LOG_EVT_COMMISSION_PROMPT, 1, 0, 0);
+    return stimulus.candidates;
+}
+
+// 执行一轮加热刺激检测 (一次广播转换)，返回DS18B20_STIMULUS_*
+// 可读的传感器全部映射后结束，不再逐个位置等待超时；结束时一次保存配置
+uint8_t DS18B20_StimulusStep(void)
+{
+    int16_t best_rise = DS18B20_STIMULUS_DELTA - 1;
+    int8_t best = -1;
+    uint8_t scratchpad[9];
+    uint8_t status = DS18B20_STIMULUS_WAITING;
+    
+    if (!stimulus.active) {
+        return DS18B20_STIMULUS_DONE;
+    }
+    
+    ds18b20_convert_all_wait();
+    for (uint8_t i = 0; i < stimulus.found; i++) {
+        int16_t raw;
+        
+        if (stimulus.assigned[i] || !ds18b20_read_scratchpad(stimulus.rom_codes[i], scratchpad)) {
+            continue;
+        }
+        
+        raw = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+        if (raw - stimulus.baseline[i] > best_rise) {
+            best_rise = raw - stimulus.baseline[i];
+            best = (int8_t)i;
+        } else if (raw < stimulus.baseline[i]) {
+            stimulus.baseline[i] = raw;  // 跟随环境温度下降
         }
+    }
+    
+    if (best >= 0) {
+        memcpy(ds18b20_devices[stimulus.pos].rom_code, stimulus.rom_codes[best], 8);
+        ds18b20_devices[stimulus.pos].present = 1;
+        stimulus.assigned[best] = 1;
+        stimulus.done++;
+        ds18b20_count = stimulus.done;
+        status = DS18B20_STIMULUS_MAPPED;
+        DS_LOG_INFO(LOG_EVT_COMMISSION_ASSIGNED, stimulus.pos + 1,
+                    DS_LOG_ROM_HI(stimulus.rom_codes[best]), DS_LOG_ROM_LO(stimulus.rom_codes[best]));
+    } else if (++stimulus.cycle >= DS18B20_STIMULUS_TIMEOUT) {
+        DS_LOG_WARN(LOG_EVT_COMMISSION_TIMEOUT, stimulus.pos + 1, 0, 0);
     } else {
-        printf("Failed to learn sensor for position %d\r\n", position + 1);
+        return DS18B20_STIMULUS_WAITING;
+    }
+    
+    // 本位置已映射或超时，转到下一个位置
+    stimulus.pos++;
+    stimulus.cycle = 0;
+    if (stimulus.pos < MAX_DS18B20_SENSORS && stimulus.done < stimulus.candidates) {
+        DS_LOG_INFO(LOG_EVT_COMMISSION_PROMPT, stimulus.pos + 1, 0, 0);
+        return status;
     }
+    
+    stimulus.active = 0;
+    DS18B20_SaveConfig();
+    DS_LOG_INFO(LOG_EVT_COMMISSION_DONE, stimulus.done, 0, 0);
+    return DS18B20_STIMULUS_DONE;
 }
 
 // 设置配置模式
@@ -446,8 +1384,7 @@ void DS18B20_SetConfigMode(uint8_t mode)
     }
     
     ds18b20_config_mode = mode;
-    printf("DS18B20 config mode set to: %s\r\n", 
-           mode == CONFIG_MODE_NORMAL ? "Normal" : "Learning");
+    DS_LOG_INFO(LOG_EVT_MODE, mode, 0, 0);
 }
 
 // 获取当前配置模式
@@ -463,37 +1400,44 @@ void DS18B20_SaveConfig(void)
     config.magic = DS18B20_CONFIG_MAGIC;
     config.configured = 1;
     memcpy(config.devices, ds18b20_devices, sizeof(ds18b20_devices));
+    config.timing = ow_timing;
     
     // 擦除配置页
     if (!Flash_ErasePage(FLASH_CONFIG_PAGE_ADDR)) {
-        printf("Failed to erase Flash page\r\n");
+        DS_LOG_ERROR(LOG_EVT_FLASH_ERASE_FAIL, 0, 0, 0);
         return;
     }
     
     // 写入配置数据
     if (!Flash_WriteData(FLASH_CONFIG_PAGE_ADDR, (uint32_t *)&config, sizeof(config) / 4)) {
-        printf("Failed to write configuration to Flash\r\n");
+        DS_LOG_ERROR(LOG_EVT_FLASH_WRITE_FAIL, 0, 0, 0);
         return;
     }
     
-    printf("Configuration saved successfully\r\n");
+    DS_LOG_INFO(LOG_EVT_CFG_SAVED, 0, 0, 0);
 }
 
 // 从Flash加载配置
 uint8_t DS18B20_LoadConfig(void)
 {
-    ds18b20_config_t *config = (ds18b20_config_t *)FLASH_CONFIG_PAGE_ADDR;
+    const ds18b20_config_t *config = (const ds18b20_config_t *)FLASH_ADDR_TO_PTR(FLASH_CONFIG_PAGE_ADDR);
     
     // 检查魔术数字和配置标志
     if (config->magic != DS18B20_CONFIG_MAGIC || !config->configured) {
-        printf("No valid configuration found in Flash\r\n");
+        DS_LOG_WARN(LOG_EVT_CFG_INVALID, 0, 0, 0);
         return 0;
     }
     
     // 加载设备配置
     memcpy(ds18b20_devices, config->devices, sizeof(ds18b20_devices));
     
-    printf("Configuration loaded from Flash\r\n");
+    // 时序参数: 旧版本配置中此处为擦除值，按未校准处理
+    if (config->timing.tag == OW_TIMING_TAG && config->timing.sample_us >= OW_CAL_SAMPLE_MIN_US &&
+        config->timing.sample_us <= OW_CAL_SAMPLE_MAX_US) {
+        ow_timing = config->timing;
+    }
+    
+    DS_LOG_INFO(LOG_EVT_CFG_LOADED, 0, 0, 0);
     
     // 打印配置信息
     DS18B20_PrintConfig();
@@ -504,6 +1448,7 @@ uint8_t DS18B20_LoadConfig(void)
 // 打印当前配置
 void DS18B20_PrintConfig(void)
 {
+    DS_Log_TxLock();
     printf("\r\n--- DS18B20 Sensor Configuration ---\r\n");
     
     for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
@@ -521,53 +1466,42 @@ void DS18B20_PrintConfig(void)
     }
     
     printf("------------------------------------\r\n\n");
+    DS_Log_TxUnlock();
 	}
 
 
 
 uint8_t DS18B20_CheckSensorPresent(uint8_t sensor_index)
 {
+    uint8_t scratchpad[9];
+
     if (sensor_index >= MAX_DS18B20_SENSORS) return 0;
     
-    // 复位总线
-    if (!ow_reset()) {
-        return 0;  // 总线上没有设备
-    }
+    // 读取9字节暂存器数据，通过验证CRC来检查传感器是否真的存在
+    uint8_t crc_ok = ds18b20_read_scratchpad(ds18b20_devices[sensor_index].rom_code, scratchpad);
     
-    // 使用匹配ROM命令
-    ow_write_byte(DS18B20_CMD_MATCH_ROM);
+    // 复位总线
+    ow_reset();
     
-//    // 发送预定义的ROM码
-//    for (uint8_t i = 0; i < 8; i++) {
-//        ow_write_byte(ds18b20_devices[sensor_index].rom_code[i]);
-//    }
-    // 发送ROM码
-    for (uint8_t i = 0; i < 8; i++) {
-        ow_write_byte(ds18b20_devices[sensor_index].rom_code[i]);
+    if (crc_ok) {
+        return 1;
     }
-    // 发送读取暂存器命令
-    ow_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
-    
-    // 读取9字节暂存器数据
-    uint8_t scratchpad[9];
+
+    // 全0xFF表示无器件应答，不计为CRC错误
     for (uint8_t i = 0; i < 9; i++) {
-        scratchpad[i] = ow_read_byte();
+        if (scratchpad[i] != 0xFF) {
+            ow_stats.crc_errors[sensor_index]++;
+            OW_TRACE_MARK_EVENT(OW_TRACE_MARK_CRC, sensor_index + 1);
+            break;
+        }
     }
-    
-    // 复位总线
-    ow_reset();
-    
-    // 通过验证CRC来检查传感器是否真的存在
-    return (calculate_crc(scratchpad, 8) == scratchpad[8]);
+    return 0;
 }
 
 // 启动所有传感器的温度转换
 void DS18B20_StartConversion(void)
 {
-    if (ow_reset()) {
-        ow_write_byte(DS18B20_CMD_SKIP_ROM);     // 跳过ROM命令 (广播命令)
-        ow_write_byte(DS18B20_CMD_CONVERT_T);    // 启动温度转换
-    }
+    ds18b20_start_conversion();
 }
 
 // 启动指定传感器的温度转换
@@ -575,14 +1509,7 @@ void DS18B20_StartConversionById(uint8_t sensor_id)
 {
     if (sensor_id >= ds18b20_count) return;
     
-    if (ow_reset()) {
-        ow_write_byte(DS18B20_CMD_MATCH_ROM);    // 匹配ROM命令
-        
-        // 发送64位ROM码
-        for (uint8_t i = 0; i < 8; i++) {
-            ow_write_byte(ds18b20_devices[sensor_id].rom_code[i]);
-        }
-        
+    if (ds18b20_select(ds18b20_devices[sensor_id].rom_code)) {
         ow_write_byte(DS18B20_CMD_CONVERT_T);    // 启动温度转换
     }
 }
@@ -594,29 +1521,29 @@ float DS18B20_ReadTemperature(uint8_t sensor_id)
     int16_t raw_temp;
     float temperature;
     
-    if (sensor_id >= MAX_DS18B20_SENSORS || !ds18b20_devices[sensor_id].present) {
+    if (sensor_id >= MAX_DS18B20_SENSORS) {
         return -999.0f;  // 无效的传感器ID
     }
+    last_raw_valid[sensor_id] = 0;
+    if (!ds18b20_devices[sensor_id].present) {
+        return -999.0f;
+    }
     
     // 添加重试机制
     uint8_t retry = 3;
     uint8_t success = 0;
     
     while (retry-- && !success) {
-        // 先复位总线
-        if (!ow_reset()) {
+        if (retry < 2) {
+            ow_stats.retries++;
+        }
+
+        // 复位总线并寻址 (单器件总线上为跳过ROM)
+        if (!ds18b20_select(ds18b20_devices[sensor_id].rom_code)) {
             Delay_ms(10);
             continue;  // 重置失败，重试
         }
         
-        // 发送匹配ROM命令
-        ow_write_byte(DS18B20_CMD_MATCH_ROM);    
-        
-        // 发送64位ROM码
-        for (uint8_t i = 0; i < 8; i++) {
-            ow_write_byte(ds18b20_devices[sensor_id].rom_code[i]);
-        }
-        
         // 发送转换命令
         ow_write_byte(DS18B20_CMD_CONVERT_T);
         
@@ -630,20 +1557,12 @@ float DS18B20_ReadTemperature(uint8_t sensor_id)
             Delay_ms(250); // 额外等待时间
         }
         
-        // 再次复位总线
-        if (!ow_reset()) {
+        // 再次复位总线并寻址
+        if (!ds18b20_select(ds18b20_devices[sensor_id].rom_code)) {
             Delay_ms(10);
             continue;
         }
         
-        // 再次发送匹配ROM命令
-        ow_write_byte(DS18B20_CMD_MATCH_ROM);    
-        
-        // 再次发送64位ROM码
-        for (uint8_t i = 0; i < 8; i++) {
-            ow_write_byte(ds18b20_devices[sensor_id].rom_code[i]);
-        }
-        
         // 发送读暂存器命令
         ow_write_byte(DS18B20_CMD_READ_SCRATCHPAD);
         
@@ -653,9 +1572,11 @@ float DS18B20_ReadTemperature(uint8_t sensor_id)
         }
         
         // 验证CRC
-        if (calculate_crc(scratchpad, 8) == scratchpad[8]) {
+        if (ds18b20_scratchpad_valid(scratchpad)) {
             success = 1;
         } else {
+            ow_stats.crc_errors[sensor_id]++;
+            OW_TRACE_MARK_EVENT(OW_TRACE_MARK_CRC, sensor_id + 1);
             Delay_ms(10); // 延时后重试
         }
     }
@@ -663,7 +1584,7 @@ float DS18B20_ReadTemperature(uint8_t sensor_id)
     if (!success) {
         // 标记传感器为不存在
         ds18b20_devices[sensor_id].present = 0;
-        printf("CRC Error for sensor %d, marking as disconnected\r\n", sensor_id+1);
+        DS_LOG_WARN(LOG_EVT_READ_CRC_FAIL, sensor_id + 1, 0, 0);
         return -999.0f;
     }
     
@@ -673,9 +1594,12 @@ float DS18B20_ReadTemperature(uint8_t sensor_id)
     
     raw_temp = (int16_t)((temp_msb << 8) | temp_lsb);
     temperature = raw_temp * 0.0625f;
+    last_raw[sensor_id] = raw_temp;
+    last_raw_valid[sensor_id] = 1;
     
     // 保存最新温度值
     ds18b20_devices[sensor_id].last_temperature = temperature;
+    ds18b20_devices[sensor_id].last_read_time = xTaskGetTickCount();
     
     return temperature;
 }
@@ -683,34 +1607,222 @@ float DS18B20_ReadTemperature(uint8_t sensor_id)
 // 修改读取所有传感器温度的函数
 void DS18B20_ReadAllTemperatures(float *temperatures)
 {
+    uint8_t scratchpad[9];
+    
     // 为所有传感器（包括不存在的）设置一个默认的错误值
     for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
         temperatures[i] = -999.0f;
+        last_raw_valid[i] = 0;
+    }
+    
+    // 已有进行中的广播转换: 等待剩余转换时间后直接读取暂存器
+    if (conv_pending) {
+        uint32_t elapsed_ms = (uint32_t)(xTaskGetTickCount() - conv_tick) * portTICK_PERIOD_MS;
+        uint16_t conv_ms = ds18b20_conv_time_ms(DS18B20_DEFAULT_RESOLUTION);
+        
+        conv_pending = 0;
+        if (elapsed_ms < conv_ms) {
+            Delay_ms(conv_ms - elapsed_ms);
+        }
+        
+        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+            if (ds18b20_devices[i].present &&
+                ds18b20_read_scratchpad(ds18b20_devices[i].rom_code, scratchpad)) {
+                int16_t raw_temp = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+                temperatures[i] = raw_temp * 0.0625f;
+                ds18b20_devices[i].last_temperature = temperatures[i];
+                ds18b20_devices[i].last_read_time = xTaskGetTickCount();
+                last_raw[i] = raw_temp;
+                last_raw_valid[i] = 1;
+            }
+        }
     }
     
-    // 只读取存在的传感器
+    // 只读取存在且尚未取得结果的传感器
     for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-        if (ds18b20_devices[i].present) {
+        if (ds18b20_devices[i].present && temperatures[i] <= -999.0f) {
             float temp = DS18B20_ReadTemperature(i);
             temperatures[i] = temp;
-            #if DS18B20_debug_flag
-            // 打印传感器编号和温度
-            printf("Sensor %d ROM: ", i+1);
-            for (int j = 0; j < 8; j++) {
-                printf("%02X ", ds18b20_devices[i].rom_code[j]);
+            // 打印传感器编号和温度 (仅DEBUG等级编译)
+            DS_LOG_DEBUG(LOG_EVT_SENSOR_TEMP, i + 1, DS_LOG_CENTI(temp), 0);
+        }
+    }
+    
+    // 记录启动到首个有效样本的时间
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS && boot_first_sample_ms == 0; i++) {
+        if (temperatures[i] >= DS18B20_TEMP_MIN && temperatures[i] <= DS18B20_TEMP_MAX) {
+            ds18b20_note_first_sample();
+        }
+    }
+}
+
+// 对掩码中的位置发出一次广播转换后逐个读取暂存器，转换期间让出CPU
+// 流水线模式下读取上一周期末发出的转换结果，读完立即发出下一次转换，周期只受读出时间限制
+// raw保存各位置的原始温度(1/16°C)，stamp记录转换开始和完成节拍 (可为NULL)
+// 返回读取成功的位置掩码；读取成功即视为在线
+ds18b20_mask_t DS18B20_ReadPositions(ds18b20_mask_t mask, int16_t *raw, ds18b20_stamp_t *stamp)
+{
+    TickType_t conv_start;
+    TickType_t conv_done;
+    uint8_t scratchpad[9];
+    ds18b20_mask_t valid = 0;
+    TickType_t conv_ticks = DS18B20_CONV_TIME_MS / portTICK_PERIOD_MS;
+    
+    if (mask == 0) {
+        return 0;
+    }
+    
+    // 已有进行中的广播转换 (启动转换或上一周期预发的转换) 可直接使用
+    if (conv_pending) {
+        TickType_t elapsed = xTaskGetTickCount() - conv_tick;
+        
+        conv_pending = 0;
+        conv_start = conv_tick;
+        conv_ticks = ds18b20_conv_time_ms(DS18B20_DEFAULT_RESOLUTION) / portTICK_PERIOD_MS;
+        conv_done = conv_start + conv_ticks;
+        conv_ticks = (elapsed < conv_ticks) ? (conv_ticks - elapsed) : 0;
+    } else {
+        conv_start = xTaskGetTickCount();
+        // 转换命令无存在脉冲时重发一次；仍失败则本周期不读，避免把上次的结果当作新样本
+        if (!ds18b20_start_conversion() && !ds18b20_start_conversion()) {
+            for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+                if (mask & DS18B20_MASK_BIT(i)) {
+                    last_raw_valid[i] = 0;
+                }
+            }
+            return 0;
+        }
+        conv_done = conv_start + conv_ticks;
+    }
+    if (conv_ticks > 0) {
+        vTaskDelay(conv_ticks);
+    }
+    // 转换早已完成时以完成时刻为准，样本年龄不包含等待读取的时间
+    if ((TickType_t)(xTaskGetTickCount() - conv_start) < (TickType_t)(conv_done - conv_start)) {
+        conv_done = xTaskGetTickCount();
+    }
+    if (stamp != NULL) {
+        stamp->conv_start = conv_start;
+        stamp->conv_done = conv_done;
+    }
+    
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        uint8_t ok = 0;
+        
+        if (!(mask & DS18B20_MASK_BIT(i)) || ds18b20_devices[i].rom_code[0] == 0x00) {
+            continue;
+        }
+        last_raw_valid[i] = 0;
+        
+        // CRC错误时重读一次暂存器，无需重新转换；无应答(全0xFF)不重试
+        for (uint8_t attempt = 0; attempt < 2 && !ok; attempt++) {
+            uint8_t idle = 1;
+            
+            if (attempt > 0) {
+                ow_stats.retries++;
+            }
+            ok = ds18b20_read_scratchpad(ds18b20_devices[i].rom_code, scratchpad);
+            if (ok) {
+                break;
+            }
+            for (uint8_t j = 0; j < 9; j++) {
+                if (scratchpad[j] != 0xFF) {
+                    idle = 0;
+                    break;
+                }
+            }
+            if (idle) {
+                break;
+            }
+            ow_stats.crc_errors[i]++;
+            OW_TRACE_MARK_EVENT(OW_TRACE_MARK_CRC, i + 1);
+            // 跳过ROM时的CRC错误可能是总线上多出的器件同时应答，本周期末即复核拓扑
+            if (single_drop) {
+                rom_check_countdown = 1;
+            }
+        }
+        
+        if (!ok) {
+            if (ds18b20_devices[i].present) {
+                DS_LOG_WARN(LOG_EVT_READ_CRC_FAIL, i + 1, 0, 0);
             }
-            printf(" Temp: %.2f°C\r\n", temp);
-						#endif
+            ds18b20_devices[i].present = 0;
+            continue;
+        }
+        
+        raw[i] = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+        last_raw[i] = raw[i];
+        last_raw_valid[i] = 1;
+        ds18b20_devices[i].present = 1;
+        ds18b20_devices[i].last_temperature = raw[i] * 0.0625f;
+        ds18b20_devices[i].last_read_time = conv_done;
+        valid |= DS18B20_MASK_BIT(i);
+        if (boot_first_sample_ms == 0) {
+            ds18b20_note_first_sample();
+        }
+    }
+    
+    // 定期复核拓扑和ROM身份 (在发出下一次转换之前，寄生供电时转换期间不能通信)
+    if (rom_check_countdown == 0 || --rom_check_countdown == 0) {
+        ds18b20_classify_bus();
+    }
+    
+    // 时序维护: 已校准时定期复核余量；尚未校准时在首个有读数的周期校准；
+    // 全部位置连续读取失败时按保守时序重新检测。这里只登记，由DS18B20_TimingStep在读取之间分步执行
+    if (timing_check_countdown > 1) {
+        timing_check_countdown--;
+    } else if (valid != 0) {
+        timing_check_countdown = OW_CAL_CHECK_CYCLES;
+        if (ow_cal.work == OW_WORK_NONE) {
+            ow_cal.work = OW_WORK_MARGIN;
         }
     }
+    if (valid != 0) {
+        timing_dead_cycles = 0;
+    } else if (++timing_dead_cycles >= OW_CAL_RESCUE_CYCLES) {
+        timing_dead_cycles = 0;
+        ow_cal.work = OW_WORK_RESCUE;
+    }
+    
+    // 流水线: 读完立即发出下一次转换，与本周期其余工作及下一周期的等待重叠
+    if (pipeline_enabled && !parasite_power && ds18b20_start_conversion()) {
+        conv_tick = xTaskGetTickCount();
+        conv_pending = 1;
+    }
+    
+    return valid;
+}
+
+// 启用/关闭流水线采集；寄生供电的总线上始终按阻塞方式采集
+void DS18B20_SetPipelined(uint8_t enable)
+{
+    pipeline_enabled = enable ? 1 : 0;
+}
+
+// 流水线采集是否实际生效
+uint8_t DS18B20_IsPipelined(void)
+{
+    return pipeline_enabled && !parasite_power;
+}
+
+// 总线上是否有寄生供电器件 (初始化时检测)
+uint8_t DS18B20_IsParasitePowered(void)
+{
+    return parasite_power;
 }
-// 配置传感器分辨率 (9-12位)
+
+// 总线是否按单器件总线以SKIP_ROM寻址
+uint8_t DS18B20_IsSingleDrop(void)
+{
+    return single_drop;
+}
+// 配置传感器分辨率 (9-12位)，并保存到传感器EEPROM，掉电后无需重新配置
 // resolution: 0=9位(0.5°C), 1=10位(0.25°C), 2=11位(0.125°C), 3=12位(0.0625°C)
 void DS18B20_SetResolution(uint8_t sensor_id, uint8_t resolution)
 {
     uint8_t config;
     
-    if (sensor_id >= ds18b20_count || !ds18b20_devices[sensor_id].present) {
+    if (sensor_id >= MAX_DS18B20_SENSORS || !ds18b20_devices[sensor_id].present) {
         return;  // 无效的传感器ID
     }
     
@@ -718,24 +1830,49 @@ void DS18B20_SetResolution(uint8_t sensor_id, uint8_t resolution)
     if (resolution > 3) resolution = 3;
     config = 0x1F | (resolution << 5);  // 配置寄存器 (位5-6为分辨率)
     
-    if (!ow_reset()) {
-        return;  // 重置失败
-    }
+    // 分辨率改变后进行中转换的结果不再可信，等其完成后再写配置
+    ds18b20_conv_discard();
+    ds18b20_write_config(ds18b20_devices[sensor_id].rom_code, config, 1);
+}
+
+// 批量配置掩码中各位置的分辨率: 逐个写暂存器后只复制一次EEPROM，多个器件时广播复制，
+// 每个器件只寻址一次，EEPROM写入等待也只有一次
+void DS18B20_SetResolutionMask(ds18b20_mask_t mask, uint8_t resolution)
+{
+    uint8_t config;
+    int8_t last = -1;
+    uint8_t written = 0;
     
-    ow_write_byte(DS18B20_CMD_MATCH_ROM);    // 匹配ROM命令
+    if (resolution > 3) resolution = 3;
+    config = 0x1F | (resolution << 5);
     
-    // 发送64位ROM码
-    for (uint8_t i = 0; i < 8; i++) {
-        ow_write_byte(ds18b20_devices[sensor_id].rom_code[i]);
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (!(mask & DS18B20_MASK_BIT(i)) || !ds18b20_devices[i].present) {
+            continue;
+        }
+        if (written == 0) {
+            ds18b20_conv_discard();
+        }
+        ds18b20_write_config(ds18b20_devices[i].rom_code, config, 0);
+        last = (int8_t)i;
+        written++;
+    }
+    if (written > 0) {
+        ds18b20_copy_scratchpad((written == 1) ? ds18b20_devices[last].rom_code : NULL);
     }
-    
-    ow_write_byte(DS18B20_CMD_WRITE_SCRATCHPAD);  // 写暂存器命令
-    ow_write_byte(0x00);        // TH寄存器 (高温报警阈值)
-    ow_write_byte(0x00);        // TL寄存器 (低温报警阈值)
-    ow_write_byte(config);      // 配置寄存器
 }
 
 
+// 获取最近一次读取的原始温度 (1/16°C)，返回0表示该位置最近一次读取失败
+uint8_t DS18B20_GetLastRaw(uint8_t sensor_id, int16_t *raw)
+{
+    if (sensor_id >= MAX_DS18B20_SENSORS || !last_raw_valid[sensor_id]) {
+        return 0;
+    }
+    *raw = last_raw[sensor_id];
+    return 1;
+}
+
 // 获取已发现的传感器数量
 uint8_t DS18B20_GetSensorCount(void)
 {
@@ -767,3 +1904,49 @@ int8_t DS18B20_FindSensorByROM(uint8_t *rom_code)
     }
     return -1;  // 未找到
 }
+
+
+// 获取1-Wire总线统计
+void DS18B20_GetStats(ow_stats_t *stats)
+{
+    ow_txn_close();
+    memcpy(stats, &ow_stats, sizeof(ow_stats_t));
+}
+
+// 清零1-Wire总线统计
+void DS18B20_ResetStats(void)
+{
+    ow_txn_close();
+    memset(&ow_stats, 0, sizeof(ow_stats));
+    ow_mask_max_cycles = 0;
+}
+
+// 打印并清零1-Wire总线统计
+void DS18B20_PrintStats(void)
+{
+    ow_stats_t stats;
+
+    DS18B20_GetStats(&stats);
+    DS18B20_ResetStats();
+
+    printf("\r\n--- 1-Wire Bus Statistics ---\r\n");
+    printf("Resets: %lu (no presence: %lu)\r\n",
+           (unsigned long)stats.resets, (unsigned long)stats.reset_no_presence);
+    printf("Retries: %lu, ROM CRC errors: %lu\r\n",
+           (unsigned long)stats.retries, (unsigned long)stats.crc_errors_rom);
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        printf("Position %d CRC errors: %lu\r\n", i + 1, (unsigned long)stats.crc_errors[i]);
+    }
+    printf("Bytes W/R: %lu/%lu, Bits W/R: %lu/%lu\r\n",
+           (unsigned long)stats.bytes_written, (unsigned long)stats.bytes_read,
+           (unsigned long)stats.bits_written, (unsigned long)stats.bits_read);
+    printf("Bus busy: %lu us, transactions: %lu, worst: %lu us\r\n",
+           (unsigned long)stats.busy_us, (unsigned long)stats.transactions,
+           (unsigned long)stats.txn_max_us);
+    printf("IRQ masked worst: %lu us, late presence samples: %lu\r\n",
+           (unsigned long)stats.irq_mask_max_us, (unsigned long)stats.presence_late);
+    printf("Addressing: %s\r\n", single_drop ? "SKIP_ROM (single-drop)" : "MATCH_ROM");
+    printf("Timing: sample %u us, recovery %u us (%s)\r\n", ow_timing.sample_us, ow_timing.recovery_us,
+           (ow_timing.tag == OW_TIMING_TAG) ? "calibrated" : "default");
+    printf("-----------------------------\r\n\n");
+}
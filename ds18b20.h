@@ -22,7 +22,9 @@
 #define BUTTON_PIN GPIO_Pin_6
 
 // 可支持的最大传感器数量
+#ifndef MAX_DS18B20_SENSORS
 #define MAX_DS18B20_SENSORS 5
+#endif
 #define DS18B20_TEMP_MIN -55.0f
 #define DS18B20_TEMP_MAX 125.0f
 // Flash存储相关定义
@@ -32,28 +34,117 @@
 // 配置模式
 #define CONFIG_MODE_NORMAL          0       // 正常模式
 #define CONFIG_MODE_LEARNING        1       // 学习模式
+
+// 转换与批量调试参数
+#define DS18B20_CONV_TIME_MS        750     // 12位分辨率最长转换时间
+#define DS18B20_EEPROM_WRITE_MS     10      // 复制暂存器到EEPROM耗时
+#define DS18B20_PIPELINED           1       // 读取后立即发出下一次转换 (寄生供电时自动退回阻塞方式)
+#define DS18B20_ROM_CHECK_CYCLES    60      // 每隔多少个采集周期搜索复核总线拓扑和ROM身份
+
+// 1-Wire时序自动校准 (时隙长度固定为规格下限，只调整读采样点和时隙间恢复时间)
+#define OW_SLOT_US                  60      // 下降沿到时隙结束，不含恢复时间
+#define OW_TIMING_DEFAULT_SAMPLE_US 12      // 默认读采样点 (下降沿后)
+#define OW_TIMING_DEFAULT_RECOVERY_US 2     // 默认恢复时间
+#define OW_TIMING_SAFE_SAMPLE_US    12      // 检测失败时重新检测用的保守时序
+#define OW_TIMING_SAFE_RECOVERY_US  16
+#define OW_TIMING_TAG               0x7A31  // 时序参数有效标记 (旧配置此处为擦除值0xFFFF)
+#define OW_CAL_SAMPLE_MIN_US        4       // 扫描的最早采样点
+#define OW_CAL_SAMPLE_MAX_US        14      // 扫描的最晚采样点 (器件保证的0至少保持15us)
+#define OW_CAL_SAMPLE_MARGIN_US     1       // 采样点两侧都要有可通过的余量
+#define OW_CAL_RECOVERY_MARGIN_US   1       // 在最短可通过的恢复时间上增加的余量
+#define OW_CAL_DEVICES              4       // 扫描和复核时读取的器件数上限 (在在线器件中均匀选取)
+#define OW_CAL_ROUNDS               2       // 每个扫描点读取暂存器的轮数
+#define OW_CAL_VERIFY_ROUNDS        2       // 选定参数后读取全部在线器件确认的轮数
+#define OW_CAL_CHECK_CYCLES         3600    // 每隔多少个采集周期复核时序余量
+#define OW_CAL_RESCUE_CYCLES        10      // 全部位置连续读取失败多少个周期后按保守时序重新检测
+
+// 期望的传感器配置 (保存在各传感器EEPROM中，启动时校验)
+#define DS18B20_DEFAULT_RESOLUTION  3       // 12位
+#define DS18B20_ALARM_TH            0x00    // 高温报警阈值
+#define DS18B20_ALARM_TL            0x00    // 低温报警阈值
+#define DS18B20_STIMULUS_DELTA      16      // 判定为加热的升温阈值 (1/16°C，即1°C)
+#define DS18B20_STIMULUS_TIMEOUT    60      // 每个位置等待加热的最大转换次数
+// DS18B20_StimulusStep的返回值
+#define DS18B20_STIMULUS_DONE       0       // 调试已结束 (配置已保存)
+#define DS18B20_STIMULUS_WAITING    1       // 当前位置尚未检测到升温
+#define DS18B20_STIMULUS_MAPPED     2       // 本轮映射了一个位置
+// 位置掩码 (位i对应位置i)
+#if MAX_DS18B20_SENSORS > 32
+typedef uint64_t ds18b20_mask_t;
+#else
+typedef uint32_t ds18b20_mask_t;
+#endif
+#define DS18B20_MASK_BIT(i)         ((ds18b20_mask_t)1 << (i))
+#define DS18B20_MASK_ALL            ((ds18b20_mask_t)~(ds18b20_mask_t)0 >> (sizeof(ds18b20_mask_t) * 8 - MAX_DS18B20_SENSORS))
+
+// 一次温度转换的时间戳 (系统节拍)
+typedef struct {
+    uint32_t conv_start;          // 发出转换命令
+    uint32_t conv_done;           // 转换完成，开始读取暂存器
+} ds18b20_stamp_t;
+
+// 1-Wire时序参数 (随配置保存)
+typedef struct {
+    uint8_t sample_us;            // 读时隙: 下降沿到采样点
+    uint8_t recovery_us;          // 时隙结束到下一个下降沿
+    uint16_t tag;                 // OW_TIMING_TAG表示由校准得到
+} ow_timing_t;
+
 // 传感器ROM码存储结构
 typedef struct {
     uint8_t present;              // 传感器是否存在
     uint8_t rom_code[8];          // 传感器64位ROM码
     float last_temperature;       // 上次读取的温度值
-    uint32_t last_read_time;      // 上次读取时间戳
+    uint32_t last_read_time;      // 上次读取时间戳 (转换完成节拍)
 } ds18b20_device_t;
  // 配置数据结构
 typedef struct {
     uint32_t magic;               // 魔术数字，用于验证配置有效性
     uint8_t configured;           // 是否已配置
     ds18b20_device_t devices[MAX_DS18B20_SENSORS]; // 传感器配置
+    ow_timing_t timing;           // 总线时序 (放在末尾，旧配置仍可加载)
 } ds18b20_config_t;
 
+// 1-Wire总线统计计数器 (事务以复位划分)
+typedef struct {
+    uint32_t resets;              // 复位次数
+    uint32_t reset_no_presence;   // 无存在脉冲的复位次数
+    uint32_t crc_errors[MAX_DS18B20_SENSORS]; // 各位置暂存器CRC错误次数
+    uint32_t crc_errors_rom;      // 搜索/读ROM时的CRC错误次数
+    uint32_t retries;             // 读温度重试次数
+    uint32_t bytes_written;       // 写入字节数
+    uint32_t bytes_read;          // 读取字节数
+    uint32_t bits_written;        // 写时隙数
+    uint32_t bits_read;           // 读时隙数
+    uint32_t busy_us;             // 累计总线占用时间(us)
+    uint32_t transactions;        // 事务数
+    uint32_t txn_max_us;          // 最长事务占用时间(us)
+    uint32_t irq_mask_max_us;     // 时隙关键窗口最长屏蔽中断时间(us)，即驱动引入的最坏中断延迟
+    uint32_t presence_late;       // 存在脉冲采样被中断推迟的次数
+} ow_stats_t;
+
 extern ds18b20_device_t ds18b20_devices[MAX_DS18B20_SENSORS]; // 传感器数组
 extern uint8_t ds18b20_config_mode;  // 配置模式
 void DS18B20_Init(void);
 uint8_t DS18B20_SearchSensors(void);
 void DS18B20_SetResolution(uint8_t sensor_id, uint8_t resolution);
+void DS18B20_SetResolutionMask(ds18b20_mask_t mask, uint8_t resolution);
 void DS18B20_ReadAllTemperatures(float *temperatures);
 uint8_t DS18B20_CheckSensorPresent(uint8_t sensor_index);
 float DS18B20_ReadTemperature(uint8_t sensor_id);
+void DS18B20_StartConversion(void);
+uint32_t DS18B20_GetBootToFirstSampleMs(void);
+uint8_t DS18B20_GetLastRaw(uint8_t sensor_id, int16_t *raw);
+ds18b20_mask_t DS18B20_ReadPositions(ds18b20_mask_t mask, int16_t *raw, ds18b20_stamp_t *stamp);
+void DS18B20_SetPipelined(uint8_t enable);
+uint8_t DS18B20_IsPipelined(void);
+uint8_t DS18B20_IsParasitePowered(void);
+uint8_t DS18B20_IsSingleDrop(void);
+// 总线时序校准 (DS18B20_TimingStep在总线任务空闲时推进周期性维护和分步校准)
+uint8_t DS18B20_CalibrateTiming(void);
+uint8_t DS18B20_StartTimingCalibration(void);
+uint8_t DS18B20_TimingStep(void);
+void DS18B20_GetTiming(ow_timing_t *timing);
 // 新增配置功能
 void DS18B20_SetConfigMode(uint8_t mode);
 uint8_t DS18B20_GetConfigMode(void);
@@ -62,5 +153,17 @@ uint8_t DS18B20_DiscoverSingleSensor(uint8_t *rom_code);
 void DS18B20_SaveConfig(void);
 uint8_t DS18B20_LoadConfig(void);
 void DS18B20_PrintConfig(void);
+// 批量调试
+uint8_t DS18B20_SetCommissionEntry(uint8_t position, const uint8_t *rom_code);
+void DS18B20_ClearCommissionTable(void);
+void DS18B20_RequestCommission(void);
+uint8_t DS18B20_CommissionPending(void);
+uint8_t DS18B20_CommissionFromTable(void);
+uint8_t DS18B20_StimulusBegin(void);
+uint8_t DS18B20_StimulusStep(void);
+// 总线统计
+void DS18B20_GetStats(ow_stats_t *stats);
+void DS18B20_ResetStats(void);
+void DS18B20_PrintStats(void);
 
 #endif
@@ -0,0 +1,190 @@
+/**
+ * 1-Wire总线所有者任务
+ * 每轮先从高优先级队列、再从普通队列取出最多DS18B20_BUS_BATCH_MAX个请求:
+ * 非读请求按取出顺序执行，全部读请求的位置掩码合并后只发一次广播转换，
+ * 读完后按各自的掩码分发结果。
+ * 完成通知携带请求标记，提交前清除本任务残留的通知；同一结果缓冲区的读请求按提交顺序完成，
+ * 等到本次标记时之前超时的请求都已写完，之后不会再有写入。
+ */
+
+#include "ds18b20_bus.h"
+#include "rtos_alloc.h"
+#include <string.h>
+
+static QueueHandle_t bus_queue[2];
+static TaskHandle_t bus_task_handle = NULL;
+static uint32_t bus_tag = 0;              // 最近分配的请求标记
+static ds18b20_bus_req_t bus_batch[DS18B20_BUS_BATCH_MAX]; // 只由总线任务使用，不占任务栈
+
+void DS18B20_Bus_Init(void)
+{
+    bus_queue[DS18B20_PRIO_NORMAL] = RtosAlloc_QueueCreate(DS18B20_BUS_QUEUE_LEN, sizeof(ds18b20_bus_req_t));
+    bus_queue[DS18B20_PRIO_HIGH] = RtosAlloc_QueueCreate(DS18B20_BUS_QUEUE_LEN, sizeof(ds18b20_bus_req_t));
+}
+
+// 提交请求，返回分配的标记；队列满时立即返回0，不等待
+uint32_t DS18B20_Bus_Submit(const ds18b20_bus_req_t *req, uint8_t priority)
+{
+    QueueHandle_t queue = bus_queue[priority ? DS18B20_PRIO_HIGH : DS18B20_PRIO_NORMAL];
+    ds18b20_bus_req_t item = *req;
+
+    if (queue == NULL) {
+        return 0;
+    }
+    taskENTER_CRITICAL();
+    if (++bus_tag == 0) {
+        bus_tag = 1;
+    }
+    item.tag = bus_tag;
+    taskEXIT_CRITICAL();
+
+    // 丢弃之前超时的请求已经发来的通知
+    if (item.notify != NULL && item.notify == xTaskGetCurrentTaskHandle()) {
+        xTaskNotifyStateClear(NULL);
+    }
+    if (xQueueSend(queue, &item, 0) != pdTRUE) {
+        return 0;
+    }
+    if (bus_task_handle != NULL) {
+        xTaskNotifyGive(bus_task_handle);
+    }
+    return item.tag;
+}
+
+// 提交读请求，完成后结果写入result并通知notify任务
+uint32_t DS18B20_Bus_Read(ds18b20_mask_t mask, ds18b20_bus_result_t *result, TaskHandle_t notify)
+{
+    ds18b20_bus_req_t req;
+
+    memset(&req, 0, sizeof(req));
+    req.type = DS18B20_REQ_READ;
+    req.mask = mask;
+    req.result = result;
+    req.notify = notify;
+    return DS18B20_Bus_Submit(&req, DS18B20_PRIO_NORMAL);
+}
+
+// 提交在总线任务中执行的函数
+uint32_t DS18B20_Bus_Call(void (*call)(void *ctx), void *ctx, uint8_t priority, TaskHandle_t notify)
+{
+    ds18b20_bus_req_t req;
+
+    memset(&req, 0, sizeof(req));
+    req.type = DS18B20_REQ_CALL;
+    req.call = call;
+    req.ctx = ctx;
+    req.notify = notify;
+    return DS18B20_Bus_Submit(&req, priority);
+}
+
+// 等待本任务提交的标记为tag的请求完成，返回0表示超时
+// 其他标记的通知来自之前超时的请求，忽略后继续等待剩余时间
+uint8_t DS18B20_Bus_Wait(uint32_t tag, TickType_t timeout)
+{
+    TimeOut_t time_out;
+    uint32_t done;
+
+    if (tag == 0) {
+        return 0;
+    }
+    vTaskSetTimeOutState(&time_out);
+    do {
+        if (xTaskNotifyWait(0, 0, &done, timeout) != pdTRUE) {
+            return 0;
+        }
+        if (done == tag) {
+            return 1;
+        }
+    } while (xTaskCheckForTimeOut(&time_out, &timeout) == pdFALSE);
+    return 0;
+}
+
+// 按优先级取出一批请求
+static uint8_t bus_fetch(ds18b20_bus_req_t *batch)
+{
+    uint8_t count = 0;
+
+    while (count < DS18B20_BUS_BATCH_MAX &&
+           xQueueReceive(bus_queue[DS18B20_PRIO_HIGH], &batch[count], 0) == pdTRUE) {
+        count++;
+    }
+    while (count < DS18B20_BUS_BATCH_MAX &&
+           xQueueReceive(bus_queue[DS18B20_PRIO_NORMAL], &batch[count], 0) == pdTRUE) {
+        count++;
+    }
+    return count;
+}
+
+// 执行非读请求
+static void bus_execute(const ds18b20_bus_req_t *req)
+{
+    if (req->type == DS18B20_REQ_CALL && req->call != NULL) {
+        req->call(req->ctx);
+    }
+}
+
+// 请求完成: 先回调再以请求标记通知
+static void bus_complete(const ds18b20_bus_req_t *req)
+{
+    if (req->callback != NULL) {
+        req->callback(req);
+    }
+    if (req->notify != NULL) {
+        xTaskNotify(req->notify, req->tag, eSetValueWithOverwrite);
+    }
+}
+
+void DS18B20_Bus_Task(void *pvParameters)
+{
+    ds18b20_bus_req_t *batch = bus_batch;
+    int16_t raw[MAX_DS18B20_SENSORS];
+    ds18b20_stamp_t stamp;
+    uint8_t count;
+
+    bus_task_handle = xTaskGetCurrentTaskHandle();
+
+    while (1) {
+        ds18b20_mask_t read_mask = 0;
+        ds18b20_mask_t valid;
+
+        count = bus_fetch(batch);
+        if (count == 0) {
+            // 没有请求时推进一步时序维护，步间让出CPU；没有待做的维护时一直等待请求
+            ulTaskNotifyTake(pdTRUE, DS18B20_TimingStep() ? DS18B20_BUS_STEP_TICKS : portMAX_DELAY);
+            continue;
+        }
+
+        // 非读请求按顺序执行，读请求只收集位置
+        for (uint8_t i = 0; i < count; i++) {
+            if (batch[i].type == DS18B20_REQ_READ) {
+                read_mask |= batch[i].mask;
+            } else {
+                bus_execute(&batch[i]);
+                bus_complete(&batch[i]);
+            }
+        }
+        if (read_mask == 0) {
+            continue;
+        }
+
+        // 合并后的读请求只做一次广播转换
+        valid = DS18B20_ReadPositions(read_mask, raw, &stamp);
+        for (uint8_t i = 0; i < count; i++) {
+            ds18b20_bus_result_t *result = batch[i].result;
+
+            if (batch[i].type != DS18B20_REQ_READ) {
+                continue;
+            }
+            if (result != NULL) {
+                result->valid = valid & batch[i].mask;
+                result->stamp = stamp;
+                for (uint8_t j = 0; j < MAX_DS18B20_SENSORS; j++) {
+                    if (result->valid & DS18B20_MASK_BIT(j)) {
+                        result->raw[j] = raw[j];
+                    }
+                }
+            }
+            bus_complete(&batch[i]);
+        }
+    }
+}
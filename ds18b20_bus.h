@@ -0,0 +1,62 @@
+#ifndef __DS18B20_BUS_H
+#define __DS18B20_BUS_H
+#include "sys.h"
+#include "ds18b20.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * 1-Wire总线所有者任务
+ * 所有总线操作都以请求形式提交到队列，由唯一的总线任务依次执行，提交方不阻塞在总线上。
+ * 高优先级队列先于普通队列处理；同一轮中的多个读请求合并为一次广播转换。
+ * 完成后在总线任务中调用回调，并可向指定任务发送任务通知。
+ * 每个请求提交时分配一个非0标记，完成通知以标记为通知值 (覆盖写入)，
+ * DS18B20_Bus_Wait只接受本次请求的标记: 超时后仍在队列中的请求稍后完成时，其通知不会被当作下一个请求的完成。
+ * 队列为空时总线任务调用DS18B20_TimingStep推进时序复核/校准，每步之后先处理新到的请求，优先级低于所有请求。
+ */
+
+#define DS18B20_BUS_TASK_PRIO       2
+#define DS18B20_BUS_STK_SIZE        384     // 批量调试、校准和OWSTAT/OWTRACE/OWTIME打印都在本任务执行，按STACKS报告调整
+#define DS18B20_BUS_QUEUE_LEN       8       // 每个优先级队列的深度
+#define DS18B20_BUS_BATCH_MAX       8       // 单轮最多取出的请求数
+#define DS18B20_BUS_STEP_TICKS      2       // 时序维护两步之间让出CPU的时间 (有新请求时立即唤醒)
+
+// 请求类型
+#define DS18B20_REQ_READ            0       // 读取位置掩码中的温度
+#define DS18B20_REQ_CALL            1       // 在总线任务中执行任意函数 (初始化、批量调试、诊断等)
+
+// 请求优先级
+#define DS18B20_PRIO_NORMAL         0
+#define DS18B20_PRIO_HIGH           1
+
+// 请求结果 (由提交方提供，总线任务在完成前填写)
+typedef struct {
+    ds18b20_mask_t valid;         // READ: 读取成功的位置
+    int16_t raw[MAX_DS18B20_SENSORS]; // READ: 原始温度 (1/16°C)
+    ds18b20_stamp_t stamp;        // READ: 本次转换的开始/完成节拍
+} ds18b20_bus_result_t;
+
+typedef struct ds18b20_bus_req ds18b20_bus_req_t;
+typedef void (*ds18b20_bus_cb_t)(const ds18b20_bus_req_t *req);
+
+// 总线请求 (按值拷贝进入队列)
+struct ds18b20_bus_req {
+    uint8_t type;                 // 请求类型
+    ds18b20_mask_t mask;          // READ: 位置掩码
+    void (*call)(void *ctx);      // CALL: 执行的函数
+    void *ctx;                    // 回调/函数参数
+    ds18b20_bus_result_t *result; // 结果缓冲区 (可为NULL)
+    ds18b20_bus_cb_t callback;    // 完成回调，在总线任务中执行 (可为NULL)
+    TaskHandle_t notify;          // 完成后通知的任务 (可为NULL)
+    uint32_t tag;                 // 请求标记，提交时分配
+};
+
+void DS18B20_Bus_Init(void);
+void DS18B20_Bus_Task(void *pvParameters);
+// 提交函数返回请求标记，0表示队列满未提交
+uint32_t DS18B20_Bus_Submit(const ds18b20_bus_req_t *req, uint8_t priority);
+uint32_t DS18B20_Bus_Read(ds18b20_mask_t mask, ds18b20_bus_result_t *result, TaskHandle_t notify);
+uint32_t DS18B20_Bus_Call(void (*call)(void *ctx), void *ctx, uint8_t priority, TaskHandle_t notify);
+uint8_t DS18B20_Bus_Wait(uint32_t tag, TickType_t timeout);
+
+#endif
@@ -0,0 +1,300 @@
+/**
+ * 延迟二进制日志
+ * 调用点仅占用环形缓冲区的一个槽位并写入事件ID和参数 (约数百个周期)，
+ * 格式化与串口输出由低优先级的DS_Log_Task完成，通过DMA1通道4发送到USART1
+ * 日志DMA和printf通过同一个互斥量轮流使用USART1发送
+ */
+
+#include "ds_log.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "rtos_alloc.h"
+#include "stm32f10x.h"
+#include "stm32f10x_dma.h"
+#include "stm32f10x_usart.h"
+#include "stm32f10x_rcc.h"
+#include <stdio.h>
+#include <string.h>
+
+// 事件格式描述: fmt中每个参数均为%s，types按顺序给出参数渲染方式
+// 'd'=十进制 'x'=8位十六进制 'b'=2位十六进制 'c'=0.01°C温度 '-'=无参数
+typedef struct {
+    const char *fmt;
+    const char *types;
+} ds_log_format_t;
+
+static const ds_log_format_t log_formats[LOG_EVT_COUNT] = {
+    [LOG_EVT_CFG_DEFAULTS]      = { "No valid configuration found, initializing with defaults", "-" },
+    [LOG_EVT_INIT_DONE]         = { "DS18B20 initialization complete, %s sensors active", "d" },
+    [LOG_EVT_SEARCH_START]      = { "Searching for DS18B20 sensors...", "-" },
+    [LOG_EVT_SEARCH_NO_DEVICE]  = { "No devices present on 1-Wire bus", "-" },
+    [LOG_EVT_SEARCH_FOUND]      = { "Found device %s, ROM: %s%s", "dxx" },
+    [LOG_EVT_SEARCH_CRC]        = { "CRC error in device search", "-" },
+    [LOG_EVT_SEARCH_DONE]       = { "Search complete, found %s DS18B20 sensors", "d" },
+    [LOG_EVT_ROM_CRC]           = { "CRC error in ROM code", "-" },
+    [LOG_EVT_ROM_FAMILY]        = { "Device is not a DS18B20 (family code: %s)", "b" },
+    [LOG_EVT_DISCOVERED]        = { "Discovered DS18B20, ROM: %s%s", "xx" },
+    [LOG_EVT_LEARN_BAD_POS]     = { "Invalid position %s", "d" },
+    [LOG_EVT_LEARN_START]       = { "Learning sensor for position %s, ensure only ONE sensor is connected", "d" },
+    [LOG_EVT_LEARN_OK]          = { "Learned sensor for position %s: %s%s", "dxx" },
+    [LOG_EVT_LEARN_TEST_OK]     = { "Sensor test successful: %s C", "c" },
+    [LOG_EVT_LEARN_TEST_FAIL]   = { "Sensor test failed: %s C", "c" },
+    [LOG_EVT_LEARN_FAIL]        = { "Failed to learn sensor for position %s", "d" },
+    [LOG_EVT_MODE]              = { "DS18B20 config mode set to: %s (0=Normal, 1=Learning)", "d" },
+    [LOG_EVT_FLASH_ERASE_FAIL]  = { "Failed to erase Flash page", "-" },
+    [LOG_EVT_FLASH_WRITE_FAIL]  = { "Failed to write configuration to Flash", "-" },
+    [LOG_EVT_CFG_SAVED]         = { "Configuration saved successfully", "-" },
+    [LOG_EVT_CFG_INVALID]       = { "No valid configuration found in Flash", "-" },
+    [LOG_EVT_CFG_LOADED]        = { "Configuration loaded from Flash", "-" },
+    [LOG_EVT_READ_CRC_FAIL]     = { "CRC Error for sensor %s, marking as disconnected", "d" },
+    [LOG_EVT_SENSOR_TEMP]       = { "Sensor %s Temp: %s C", "dc" },
+    [LOG_EVT_LEARN_BUTTON_BOOT] = { "Button pressed at startup, entering learning mode...", "-" },
+    [LOG_EVT_LEARN_MODE]        = { "*** DS18B20 LEARNING MODE *** connect all sensors, warm each probe when prompted", "-" },
+    [LOG_EVT_LEARN_COMPLETE]    = { "Learning complete! System will now restart in normal mode", "-" },
+    [LOG_EVT_NORMAL_MODE]       = { "Running in normal mode", "-" },
+    [LOG_EVT_SENSOR_COUNT]      = { "Found %s configured DS18B20 sensors", "d" },
+    [LOG_EVT_POS_VALID]         = { "Position %s Temp: %s C (Valid)", "dc" },
+    [LOG_EVT_POS_RANGE]         = { "Position %s Temp: %s C (Out of range, not updated)", "dc" },
+    [LOG_EVT_POS_INVALID]       = { "Position %s: Not connected or invalid reading", "d" },
+    [LOG_EVT_BUTTON_HOLD]       = { "Button pressed! Hold for 3 seconds to enter learning mode...", "-" },
+    [LOG_EVT_BUTTON_LEARN]      = { "Entering learning mode...", "-" },
+    [LOG_EVT_BUTTON_SHORT]      = { "Button released too early, continuing normal operation", "-" },
+    [LOG_EVT_DROPPED]           = { "[log] %s records dropped", "d" },
+    [LOG_EVT_COMMISSION_START]  = { "Commissioning: %s sensors on bus", "d" },
+    [LOG_EVT_COMMISSION_PROMPT] = { "Warm the probe for position %s (touch or hold)", "d" },
+    [LOG_EVT_COMMISSION_ASSIGNED] = { "Position %s mapped to ROM: %s%s", "dxx" },
+    [LOG_EVT_COMMISSION_TIMEOUT] = { "Position %s: no warming detected, left unconfigured", "d" },
+    [LOG_EVT_COMMISSION_MISSING] = { "Position %s: mapped ROM not found on bus", "d" },
+    [LOG_EVT_COMMISSION_DONE]   = { "Commissioning complete, %s positions mapped", "d" },
+    [LOG_EVT_CFG_REWRITTEN]     = { "Position %s config mismatch (cfg %s), rewritten to EEPROM", "db" },
+    [LOG_EVT_FIRST_SAMPLE]      = { "Boot to first valid sample: %s ms", "d" },
+    [LOG_EVT_POS_POR]           = { "Position %s: 85 C power-on value rejected", "d" },
+    [LOG_EVT_BUS_TOPOLOGY]      = { "Bus single-drop: %s (position %s), SKIP_ROM addressing when 1", "dd" },
+    [LOG_EVT_OW_TIMING]         = { "1-Wire timing: sample %s us, recovery %s us (%s sample points pass)", "ddd" },
+    [LOG_EVT_OW_TIMING_FAIL]    = { "1-Wire timing calibration failed, using defaults", "-" },
+    [LOG_EVT_OW_MARGIN_LOST]    = { "1-Wire timing margin lost at sample %s us, recovery %s us, recalibrating", "dd" },
+    [LOG_EVT_BUS_TIMEOUT]       = { "Bus request not completed within %s ticks, continuing", "d" },
+};
+
+static const char log_level_tag[] = { ' ', 'E', 'W', 'I', 'D' };
+
+static ds_log_record_t log_ring[DS_LOG_RING_SIZE];
+static volatile uint32_t log_head = 0;   // 生产者已占用的槽位数
+static volatile uint32_t log_tail = 0;   // 消费者已处理的槽位数
+static volatile uint32_t log_dropped = 0;
+
+static char log_tx_buf[2][DS_LOG_TX_BUF_SIZE];  // DMA双缓冲
+static uint8_t log_tx_index = 0;
+static SemaphoreHandle_t log_tx_mutex = NULL;   // USART1发送权
+
+// 初始化USART1发送DMA (DMA1通道4)
+void DS_Log_Init(void)
+{
+    DMA_InitTypeDef DMA_InitStruct;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    DMA_DeInit(DMA1_Channel4);
+
+    DMA_InitStruct.DMA_PeripheralBaseAddr = (uint32_t)&USART1->DR;
+    DMA_InitStruct.DMA_MemoryBaseAddr = (uint32_t)log_tx_buf[0];
+    DMA_InitStruct.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_InitStruct.DMA_BufferSize = 1;
+    DMA_InitStruct.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStruct.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStruct.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStruct.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStruct.DMA_Mode = DMA_Mode_Normal;
+    DMA_InitStruct.DMA_Priority = DMA_Priority_Low;
+    DMA_InitStruct.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(DMA1_Channel4, &DMA_InitStruct);
+
+    USART_DMACmd(USART1, USART_DMAReq_Tx, ENABLE);
+
+    log_tx_mutex = RtosAlloc_MutexCreate();
+}
+
+// 写入一条日志记录，可在任务和中断中调用
+void DS_Log_Push(uint8_t level, uint16_t event, int32_t a0, int32_t a1, int32_t a2)
+{
+    uint32_t head;
+    uint32_t dropped;
+    ds_log_record_t *rec;
+
+    // 通过LDREX/STREX无锁占用一个槽位
+    do {
+        head = __LDREXW(&log_head);
+        if (head - log_tail >= DS_LOG_RING_SIZE) {
+            __CLREX();
+            // 缓冲区满，丢弃本条；计数同样用LDREX/STREX，任务和中断同时丢弃时不丢失
+            do {
+                dropped = __LDREXW(&log_dropped);
+            } while (__STREXW(dropped + 1, &log_dropped));
+            return;
+        }
+    } while (__STREXW(head + 1, &log_head));
+
+    rec = &log_ring[head & (DS_LOG_RING_SIZE - 1)];
+    // 中断中只能调用FromISR版本
+    rec->tick = (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+    rec->event = event;
+    rec->level = level;
+    rec->arg[0] = a0;
+    rec->arg[1] = a1;
+    rec->arg[2] = a2;
+
+    // 所有字段写完后再提交序号
+    __DMB();
+    rec->seq = head + 1;
+}
+
+// 获取因缓冲区满而丢弃的日志数量
+uint32_t DS_Log_GetDropped(void)
+{
+    return log_dropped;
+}
+
+// 按类型渲染单个参数
+static void log_render_arg(char *out, uint8_t size, char type, int32_t value)
+{
+    uint32_t abs_value;
+
+    switch (type) {
+    case 'd':
+        snprintf(out, size, "%ld", (long)value);
+        break;
+    case 'x':
+        snprintf(out, size, "%08lX", (unsigned long)(uint32_t)value);
+        break;
+    case 'b':
+        snprintf(out, size, "%02X", (unsigned int)(value & 0xFF));
+        break;
+    case 'c':
+        abs_value = (value < 0) ? (uint32_t)(-value) : (uint32_t)value;
+        snprintf(out, size, "%s%lu.%02lu", (value < 0) ? "-" : "",
+                 (unsigned long)(abs_value / 100), (unsigned long)(abs_value % 100));
+        break;
+    default:
+        out[0] = '\0';
+        break;
+    }
+}
+
+// 将一条记录格式化为文本行，返回长度
+static uint16_t log_format_record(const ds_log_record_t *rec, char *line, uint16_t size)
+{
+    char args[3][12];
+    const ds_log_format_t *format;
+    int len;
+
+    if (rec->event >= LOG_EVT_COUNT || log_formats[rec->event].fmt == NULL) {
+        len = snprintf(line, size, "[%7lu] ? event %u\r\n", (unsigned long)rec->tick, rec->event);
+        return (len < 0) ? 0 : (uint16_t)((len >= size) ? size - 1 : len);
+    }
+
+    format = &log_formats[rec->event];
+    for (uint8_t i = 0; i < 3; i++) {
+        char type = '-';
+        if (i < strlen(format->types)) {
+            type = format->types[i];
+        }
+        log_render_arg(args[i], sizeof(args[i]), type, rec->arg[i]);
+    }
+
+    len = snprintf(line, size, "[%7lu] %c ", (unsigned long)rec->tick,
+                   log_level_tag[rec->level <= DS_LOG_LVL_DEBUG ? rec->level : 0]);
+    if (len < 0 || len >= size) {
+        return 0;
+    }
+    len += snprintf(line + len, size - len, format->fmt, args[0], args[1], args[2]);
+    if (len > size - 3) {
+        len = size - 3;
+    }
+    line[len++] = '\r';
+    line[len++] = '\n';
+    line[len] = '\0';
+
+    return (uint16_t)len;
+}
+
+// 等待上一次DMA发送完成
+static void log_wait_dma_idle(void)
+{
+    while ((DMA1_Channel4->CCR & DMA_CCR1_EN) && DMA_GetCurrDataCounter(DMA1_Channel4) != 0) {
+        vTaskDelay(1);
+    }
+}
+
+// 取得USART1发送权并等待进行中的日志DMA发送完成，之后可以直接printf
+// 不能在中断或临界区中调用 (启动任务中创建对象时的出错打印尚无日志输出，不需要加锁)
+void DS_Log_TxLock(void)
+{
+    if (log_tx_mutex != NULL) {
+        xSemaphoreTake(log_tx_mutex, portMAX_DELAY);
+    }
+    log_wait_dma_idle();
+}
+
+void DS_Log_TxUnlock(void)
+{
+    if (log_tx_mutex != NULL) {
+        xSemaphoreGive(log_tx_mutex);
+    }
+}
+
+// 启动一次DMA发送
+static void log_dma_send(const char *buf, uint16_t len)
+{
+    DMA_Cmd(DMA1_Channel4, DISABLE);
+    DMA1_Channel4->CMAR = (uint32_t)buf;
+    DMA_SetCurrDataCounter(DMA1_Channel4, len);
+    DMA_ClearFlag(DMA1_FLAG_TC4);
+    DMA_Cmd(DMA1_Channel4, ENABLE);
+}
+
+// 低优先级日志任务: 取出已提交的记录，格式化后批量DMA发送
+void DS_Log_Task(void *pvParameters)
+{
+    char line[DS_LOG_LINE_MAX];
+    uint32_t reported_dropped = 0;
+
+    while (1) {
+        char *tx = log_tx_buf[log_tx_index];
+        uint16_t tx_len = 0;
+        uint32_t tail = log_tail;
+
+        // 报告新增的丢弃数量
+        if (log_dropped != reported_dropped) {
+            ds_log_record_t drop_rec;
+            memset(&drop_rec, 0, sizeof(drop_rec));
+            drop_rec.tick = xTaskGetTickCount();
+            drop_rec.event = LOG_EVT_DROPPED;
+            drop_rec.level = DS_LOG_LVL_WARN;
+            drop_rec.arg[0] = (int32_t)(log_dropped - reported_dropped);
+            reported_dropped = log_dropped;
+            tx_len = log_format_record(&drop_rec, tx, DS_LOG_TX_BUF_SIZE);
+        }
+
+        // 尽可能多地将记录装入当前发送缓冲区
+        while (log_ring[tail & (DS_LOG_RING_SIZE - 1)].seq == tail + 1) {
+            uint16_t len = log_format_record(&log_ring[tail & (DS_LOG_RING_SIZE - 1)], line, sizeof(line));
+            if (tx_len + len > DS_LOG_TX_BUF_SIZE) {
+                break;  // 本缓冲区已满，下一轮继续
+            }
+            memcpy(tx + tx_len, line, len);
+            tx_len += len;
+            tail++;
+            log_tail = tail;  // 释放槽位
+        }
+
+        if (tx_len > 0) {
+            // printf输出期间不启动DMA；释放后由printf方等待本次DMA完成
+            DS_Log_TxLock();
+            log_dma_send(tx, tx_len);
+            DS_Log_TxUnlock();
+            log_tx_index ^= 1;  // 切换到另一个缓冲区继续格式化
+        } else {
+            vTaskDelay(DS_LOG_POLL_MS);
+        }
+    }
+}
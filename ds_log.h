@@ -0,0 +1,135 @@
+#ifndef __DS_LOG_H
+#define __DS_LOG_H
+#include "sys.h"
+
+/**
+ * 延迟二进制日志 - 调用点只写入事件ID和参数到无锁环形缓冲区，
+ * 由低优先级任务统一格式化并通过USART1 DMA发送
+ * USART1发送由日志DMA和printf共用: 打印多行输出(诊断命令、配置和统计转储)的代码段
+ * 前后调用DS_Log_TxLock/DS_Log_TxUnlock，持有期间日志任务不启动DMA (需要configUSE_MUTEXES为1)
+ */
+
+// 日志等级
+#define DS_LOG_LVL_NONE     0
+#define DS_LOG_LVL_ERROR    1
+#define DS_LOG_LVL_WARN     2
+#define DS_LOG_LVL_INFO     3
+#define DS_LOG_LVL_DEBUG    4
+
+// 编译期日志等级，高于该等级的调用点不生成任何代码
+#ifndef DS_LOG_LEVEL
+#define DS_LOG_LEVEL        DS_LOG_LVL_INFO
+#endif
+
+#define DS_LOG_RING_SIZE    64      // 环形缓冲区记录数，必须为2的幂
+#define DS_LOG_LINE_MAX     96      // 单条日志格式化后的最大长度
+#define DS_LOG_TX_BUF_SIZE  256     // 单个DMA发送缓冲区大小
+#define DS_LOG_POLL_MS      20      // 日志任务轮询周期
+
+#define DS_LOG_TASK_PRIO    1
+#define DS_LOG_STK_SIZE     192
+
+// 日志事件ID，格式字符串见ds_log.c中的事件表
+typedef enum {
+    LOG_EVT_CFG_DEFAULTS = 0,   // 无有效配置，使用默认值
+    LOG_EVT_INIT_DONE,          // 初始化完成 (数量)
+    LOG_EVT_SEARCH_START,       // 开始搜索
+    LOG_EVT_SEARCH_NO_DEVICE,   // 总线无设备
+    LOG_EVT_SEARCH_FOUND,       // 搜索到设备 (序号, ROM高, ROM低)
+    LOG_EVT_SEARCH_CRC,         // 搜索CRC错误
+    LOG_EVT_SEARCH_DONE,        // 搜索完成 (数量)
+    LOG_EVT_ROM_CRC,            // ROM码CRC错误
+    LOG_EVT_ROM_FAMILY,         // 家族码错误 (家族码)
+    LOG_EVT_DISCOVERED,         // 发现单个传感器 (ROM高, ROM低)
+    LOG_EVT_LEARN_BAD_POS,      // 学习位置无效 (位置)
+    LOG_EVT_LEARN_START,        // 开始学习 (位置)
+    LOG_EVT_LEARN_OK,           // 学习成功 (位置, ROM高, ROM低)
+    LOG_EVT_LEARN_TEST_OK,      // 学习后测试成功 (温度)
+    LOG_EVT_LEARN_TEST_FAIL,    // 学习后测试失败 (温度)
+    LOG_EVT_LEARN_FAIL,         // 学习失败 (位置)
+    LOG_EVT_MODE,               // 配置模式切换 (模式)
+    LOG_EVT_FLASH_ERASE_FAIL,   // Flash擦除失败
+    LOG_EVT_FLASH_WRITE_FAIL,   // Flash写入失败
+    LOG_EVT_CFG_SAVED,          // 配置已保存
+    LOG_EVT_CFG_INVALID,        // Flash中无有效配置
+    LOG_EVT_CFG_LOADED,         // 配置已加载
+    LOG_EVT_READ_CRC_FAIL,      // 读温度CRC失败 (位置)
+    LOG_EVT_SENSOR_TEMP,        // 传感器温度 (位置, 温度)
+    LOG_EVT_LEARN_BUTTON_BOOT,  // 启动时按键按下
+    LOG_EVT_LEARN_MODE,         // 进入学习模式提示
+    LOG_EVT_LEARN_COMPLETE,     // 学习完成
+    LOG_EVT_NORMAL_MODE,        // 正常运行模式
+    LOG_EVT_SENSOR_COUNT,       // 已配置传感器数量 (数量)
+    LOG_EVT_POS_VALID,          // 位置温度有效 (位置, 温度)
+    LOG_EVT_POS_RANGE,          // 位置温度超范围 (位置, 温度)
+    LOG_EVT_POS_INVALID,        // 位置未连接或读数无效 (位置)
+    LOG_EVT_BUTTON_HOLD,        // 按键按下，提示长按
+    LOG_EVT_BUTTON_LEARN,       // 长按确认，进入学习模式
+    LOG_EVT_BUTTON_SHORT,       // 按键释放过早
+    LOG_EVT_DROPPED,            // 日志丢弃计数 (数量)
+    LOG_EVT_COMMISSION_START,   // 批量调试开始 (总线器件数)
+    LOG_EVT_COMMISSION_PROMPT,  // 提示加热探头 (位置)
+    LOG_EVT_COMMISSION_ASSIGNED,// 位置映射成功 (位置, ROM高, ROM低)
+    LOG_EVT_COMMISSION_TIMEOUT, // 位置等待加热超时 (位置)
+    LOG_EVT_COMMISSION_MISSING, // 映射表ROM不在总线上 (位置)
+    LOG_EVT_COMMISSION_DONE,    // 批量调试完成 (映射数量)
+    LOG_EVT_CFG_REWRITTEN,      // 传感器配置不一致已重写 (位置, 原配置寄存器)
+    LOG_EVT_FIRST_SAMPLE,       // 启动到首个有效样本时间 (ms)
+    LOG_EVT_POS_POR,            // 位置读到上电值85°C已剔除 (位置)
+    LOG_EVT_BUS_TOPOLOGY,       // 寻址方式改变 (1单器件SKIP_ROM/0 MATCH_ROM, 位置)
+    LOG_EVT_OW_TIMING,          // 时序校准结果 (采样点us, 恢复时间us, 可通过的采样点数)
+    LOG_EVT_OW_TIMING_FAIL,     // 时序校准无可用参数，沿用默认时序
+    LOG_EVT_OW_MARGIN_LOST,     // 复核时序余量不足，重新校准 (采样点us, 恢复时间us)
+    LOG_EVT_BUS_TIMEOUT,        // 总线请求未在限定时间内完成，继续运行 (节拍)
+    LOG_EVT_COUNT
+} ds_log_event_t;
+
+// 环形缓冲区中的一条二进制日志记录
+typedef struct {
+    volatile uint32_t seq;        // 提交序号，写完所有字段后置位
+    uint32_t tick;                // 系统节拍时间戳
+    uint16_t event;               // 事件ID
+    uint16_t level;               // 日志等级
+    int32_t arg[3];               // 事件参数
+} ds_log_record_t;
+
+void DS_Log_Init(void);
+void DS_Log_Push(uint8_t level, uint16_t event, int32_t a0, int32_t a1, int32_t a2);
+uint32_t DS_Log_GetDropped(void);
+void DS_Log_Task(void *pvParameters);
+void DS_Log_TxLock(void);
+void DS_Log_TxUnlock(void);
+
+#if DS_LOG_LEVEL >= DS_LOG_LVL_ERROR
+#define DS_LOG_ERROR(evt, a0, a1, a2) DS_Log_Push(DS_LOG_LVL_ERROR, (evt), (int32_t)(a0), (int32_t)(a1), (int32_t)(a2))
+#else
+#define DS_LOG_ERROR(evt, a0, a1, a2) ((void)0)
+#endif
+
+#if DS_LOG_LEVEL >= DS_LOG_LVL_WARN
+#define DS_LOG_WARN(evt, a0, a1, a2)  DS_Log_Push(DS_LOG_LVL_WARN, (evt), (int32_t)(a0), (int32_t)(a1), (int32_t)(a2))
+#else
+#define DS_LOG_WARN(evt, a0, a1, a2)  ((void)0)
+#endif
+
+#if DS_LOG_LEVEL >= DS_LOG_LVL_INFO
+#define DS_LOG_INFO(evt, a0, a1, a2)  DS_Log_Push(DS_LOG_LVL_INFO, (evt), (int32_t)(a0), (int32_t)(a1), (int32_t)(a2))
+#else
+#define DS_LOG_INFO(evt, a0, a1, a2)  ((void)0)
+#endif
+
+#if DS_LOG_LEVEL >= DS_LOG_LVL_DEBUG
+#define DS_LOG_DEBUG(evt, a0, a1, a2) DS_Log_Push(DS_LOG_LVL_DEBUG, (evt), (int32_t)(a0), (int32_t)(a1), (int32_t)(a2))
+#else
+#define DS_LOG_DEBUG(evt, a0, a1, a2) ((void)0)
+#endif
+
+// ROM码打包为两个32位参数 (按字节顺序输出)
+#define DS_LOG_ROM_HI(rom) ((int32_t)(((uint32_t)(rom)[0] << 24) | ((uint32_t)(rom)[1] << 16) | \
+                                      ((uint32_t)(rom)[2] << 8) | (uint32_t)(rom)[3]))
+#define DS_LOG_ROM_LO(rom) ((int32_t)(((uint32_t)(rom)[4] << 24) | ((uint32_t)(rom)[5] << 16) | \
+                                      ((uint32_t)(rom)[6] << 8) | (uint32_t)(rom)[7]))
+// 温度(°C)转为0.01°C整数，避免在调用点格式化浮点数
+#define DS_LOG_CENTI(t)    ((int32_t)((t) * 100.0f))
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * 批量帧和上报帧主机解码工具
+ *
+ * 构建 (在仓库根目录):
+ *   gcc -std=gnu99 -O2 -I. host/batch_decode.c batch_frame.c -o batch_decode
+ *
+ * 用法:
+ *   batch_decode FILE           解码二进制帧文件 (可包含多个连续的批量帧/上报帧)
+ *   batch_decode -x             从stdin读取十六进制文本 (空白分隔任意)
+ *   batch_decode -b [N] [ROWS]  用随机游走的合成数据测量压缩率并校验往返编解码
+ *
+ * 输出: 每行一个JSON对象 (JSON Lines)
+ */
+
+#include "batch_frame.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DECODE_BUF_SIZE     65536
+
+static void decode_print_row(void *ctx, uint32_t tick, uint32_t mask, const int16_t *raw)
+{
+    uint8_t positions = *(const uint8_t *)ctx;
+    uint8_t first = 1;
+
+    printf("{\"tick\":%lu,\"temps\":{", (unsigned long)tick);
+    for (uint8_t i = 0; i < positions; i++) {
+        if (mask & (1UL << i)) {
+            printf("%s\"%u\":%.4f", first ? "" : ",", i + 1, raw[i] * 0.0625);
+            first = 0;
+        }
+    }
+    printf("}}\n");
+}
+
+static void decode_print_report(void *ctx, uint32_t seq, uint32_t tick, uint8_t position,
+                                uint8_t flags, int16_t raw)
+{
+    (void)ctx;
+    printf("{\"seq\":%lu,\"tick\":%lu,\"position\":%u,\"temp\":%.4f,\"changed\":%d,\"silence\":%d}\n",
+           (unsigned long)seq, (unsigned long)tick, position + 1, raw * 0.0625,
+           (flags & BATCH_REPORT_FLAG_CHANGED) != 0, (flags & BATCH_REPORT_FLAG_SILENCE) != 0);
+}
+
+// 批量帧长度由行内容决定，逐个尝试可能的结束位置直到CRC通过；上报帧长度由条目数确定
+static int decode_stream(const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+    int frames = 0;
+
+    while (pos < len) {
+        size_t remain = len - pos;
+        size_t max = remain < 0xFFFF ? remain : 0xFFFF;
+        size_t flen;
+        int rows = BATCH_FRAME_ERR_SHORT;
+
+        if (data[pos] == BATCH_REPORT_MAGIC && remain >= 4) {
+            flen = BATCH_REPORT_HEADER_SIZE + (size_t)data[pos + 3] * BATCH_REPORT_ENTRY_SIZE + BATCH_FRAME_CRC_SIZE;
+            if (flen <= remain && BatchFrame_DecodeReport(&data[pos], (uint16_t)flen, NULL, NULL) >= 0) {
+                BatchFrame_DecodeReport(&data[pos], (uint16_t)flen, decode_print_report, NULL);
+                pos += flen;
+                frames++;
+                continue;
+            }
+        }
+
+        for (flen = BATCH_FRAME_HEADER_SIZE + BATCH_FRAME_CRC_SIZE; flen <= max; flen++) {
+            rows = BatchFrame_Decode(&data[pos], (uint16_t)flen, NULL, NULL);
+            if (rows >= 0) {
+                break;
+            }
+        }
+        if (rows < 0) {
+            fprintf(stderr, "no valid frame at offset %lu\n", (unsigned long)pos);
+            return 1;
+        }
+
+        uint8_t positions = data[pos + 2];
+        BatchFrame_Decode(&data[pos], (uint16_t)flen, decode_print_row, &positions);
+        pos += flen;
+        frames++;
+    }
+    fprintf(stderr, "%d frame(s)\n", frames);
+    return 0;
+}
+
+static size_t read_hex(FILE *in, uint8_t *buf, size_t cap)
+{
+    size_t len = 0;
+    int hi = -1;
+    int c;
+
+    while ((c = fgetc(in)) != EOF && len < cap) {
+        int v;
+        if (!isxdigit(c)) {
+            continue;
+        }
+        v = isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10);
+        if (hi < 0) {
+            hi = v;
+        } else {
+            buf[len++] = (uint8_t)((hi << 4) | v);
+            hi = -1;
+        }
+    }
+    return len;
+}
+
+// 往返校验的期望值
+typedef struct {
+    int16_t (*rows)[BATCH_FRAME_MAX_POSITIONS];
+    uint32_t *ticks;
+    uint32_t *masks;
+    uint8_t positions;
+    int index;
+    int errors;
+} bench_check_t;
+
+static void bench_check_row(void *ctx, uint32_t tick, uint32_t mask, const int16_t *raw)
+{
+    bench_check_t *chk = ctx;
+    int r = chk->index++;
+
+    if (tick != chk->ticks[r] || mask != chk->masks[r]) {
+        chk->errors++;
+        return;
+    }
+    for (uint8_t i = 0; i < chk->positions; i++) {
+        if ((mask & (1UL << i)) && raw[i] != chk->rows[r][i]) {
+            chk->errors++;
+        }
+    }
+}
+
+// 合成数据: 约每秒一行 (0~4节拍抖动)，12位分辨率的温度每步变化0或±1 LSB，
+// 1%的样本跳变±20 LSB，5%的行缺失一个位置
+static int run_bench(uint8_t positions, int total_rows)
+{
+    int16_t (*rows)[BATCH_FRAME_MAX_POSITIONS] = calloc((size_t)total_rows, sizeof(*rows));
+    uint32_t *ticks = calloc((size_t)total_rows, sizeof(uint32_t));
+    uint32_t *masks = calloc((size_t)total_rows, sizeof(uint32_t));
+    int16_t temp[BATCH_FRAME_MAX_POSITIONS];
+    uint8_t frame[256];
+    unsigned long frame_bytes = 0, samples = 0, frames = 0;
+    bench_check_t chk = { rows, ticks, masks, positions, 0, 0 };
+    int r = 0;
+
+    srand(1);
+    for (uint8_t i = 0; i < positions; i++) {
+        temp[i] = (int16_t)(20 * 16 + i * 8);
+    }
+    for (int k = 0; k < total_rows; k++) {
+        ticks[k] = 100000u + (uint32_t)k * 1000u + (uint32_t)(rand() % 5);
+        masks[k] = (positions < 32) ? ((1UL << positions) - 1) : 0xFFFFFFFFUL;
+        if (rand() % 20 == 0) {
+            masks[k] &= ~(1UL << (rand() % positions));
+        }
+        for (uint8_t i = 0; i < positions; i++) {
+            temp[i] = (int16_t)(temp[i] + rand() % 3 - 1);
+            if (rand() % 100 == 0) {
+                temp[i] = (int16_t)(temp[i] + (rand() % 2 ? 20 : -20));
+            }
+            rows[k][i] = temp[i];
+            if (masks[k] & (1UL << i)) {
+                samples++;
+            }
+        }
+    }
+
+    while (r < total_rows) {
+        batch_encoder_t enc;
+        uint16_t len;
+        int rows_in_frame;
+
+        BatchFrame_Begin(&enc, frame, sizeof(frame), positions, ticks[r], 1000);
+        while (r < total_rows && BatchFrame_AddRow(&enc, ticks[r], masks[r], rows[r])) {
+            r++;
+        }
+        len = BatchFrame_Finish(&enc);
+        rows_in_frame = BatchFrame_Decode(frame, len, bench_check_row, &chk);
+        if (rows_in_frame != enc.rows) {
+            chk.errors++;
+        }
+        frame_bytes += len;
+        frames++;
+    }
+
+    printf("{\"positions\":%u,\"rows\":%d,\"samples\":%lu,\"frames\":%lu,\"frame_bytes\":%lu,"
+           "\"bytes_per_sample\":%.3f,\"float_bytes_per_sample\":4,\"ratio\":%.2f,\"roundtrip_errors\":%d}\n",
+           positions, total_rows, samples, frames, frame_bytes,
+           (double)frame_bytes / samples, 4.0 * samples / frame_bytes, chk.errors);
+
+    free(rows);
+    free(ticks);
+    free(masks);
+    return chk.errors != 0;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t buf[DECODE_BUF_SIZE];
+    size_t len;
+
+    if (argc >= 2 && strcmp(argv[1], "-b") == 0) {
+        int positions = (argc >= 3) ? atoi(argv[2]) : 5;
+        int rows = (argc >= 4) ? atoi(argv[3]) : 3600;
+        if (positions < 1 || positions > BATCH_FRAME_MAX_POSITIONS || rows < 1) {
+            fprintf(stderr, "bad arguments\n");
+            return 2;
+        }
+        return run_bench((uint8_t)positions, rows);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "-x") == 0) {
+        len = read_hex(stdin, buf, sizeof(buf));
+    } else if (argc >= 2) {
+        FILE *in = fopen(argv[1], "rb");
+        if (in == NULL) {
+            perror(argv[1]);
+            return 2;
+        }
+        len = fread(buf, 1, sizeof(buf), in);
+        fclose(in);
+    } else {
+        fprintf(stderr, "usage: %s FILE | -x | -b [N] [ROWS]\n", argv[0]);
+        return 2;
+    }
+
+    return decode_stream(buf, len);
+}
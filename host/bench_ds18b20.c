@@ -0,0 +1,385 @@
+/**
+ * DS18B20驱动主机基准测试
+ * 在时序精确的1-Wire仿真总线上运行ds18b20.c，按传感器数量和分辨率测量
+ * 初始化、搜索、读取全部温度以及配置保存/加载的仿真总线时间和主机CPU时间，
+ * 以及不同线缆电气参数下时序校准的结果和耗时
+ *
+ * 构建 (在仓库根目录):
+ *   gcc -std=gnu99 -O2 -Ihost/include -Ihost -I. -DMAX_DS18B20_SENSORS=64 -DDS_LOG_LEVEL=0 \
+ *       host/bench_ds18b20.c host/ow_sim.c ds18b20.c ow_trace.c -o bench_ds18b20
+ *
+ * 输出: 每个测量一行JSON (JSON Lines)，驱动自身的printf输出默认丢弃，-v 时保留到stderr
+ */
+
+#include "ow_sim.h"
+#include "ds18b20.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+static const uint8_t bench_sensor_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+// 线缆电气参数: 释放后的上升时间和器件发送0的保持时间
+typedef struct {
+    const char *name;
+    uint32_t rise_ns;
+    uint32_t hold_ns;
+} bench_cable_t;
+
+static const bench_cable_t bench_cables[] = {
+    { "short", 1000, 30000 },
+    { "long", 5000, 15000 },
+    { "heavy", 10000, 15000 },
+};
+
+// 单次测量的起点
+typedef struct {
+    uint64_t sim_ns;
+    uint64_t cpu_ns;
+    uint32_t busy_us;
+} bench_mark_t;
+
+static FILE *bench_out;
+
+static uint64_t bench_cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_begin(bench_mark_t *mark)
+{
+    ow_stats_t stats;
+
+    DS18B20_GetStats(&stats);
+    mark->busy_us = stats.busy_us;
+    mark->sim_ns = OwSim_NowNs();
+    mark->cpu_ns = bench_cpu_ns();
+}
+
+// 输出一条测量结果
+static void bench_end(const bench_mark_t *mark, const char *op, uint8_t sensors,
+                      uint8_t resolution, uint32_t result)
+{
+    uint64_t cpu_ns = bench_cpu_ns() - mark->cpu_ns;
+    ow_stats_t stats;
+
+    DS18B20_GetStats(&stats);
+    fprintf(bench_out,
+            "{\"op\":\"%s\",\"sensors\":%u,\"resolution_bits\":%u,"
+            "\"sim_elapsed_us\":%llu,\"sim_bus_busy_us\":%lu,\"cpu_us\":%llu,\"result\":%lu}\n",
+            op, sensors, 9 + resolution,
+            (unsigned long long)((OwSim_NowNs() - mark->sim_ns) / 1000u),
+            (unsigned long)(stats.busy_us - mark->busy_us),
+            (unsigned long long)(cpu_ns / 1000u),
+            (unsigned long)result);
+}
+
+// 在仿真总线上挂接指定数量的传感器，EEPROM预置为指定分辨率
+static void bench_setup_bus(uint8_t sensors, uint8_t resolution)
+{
+    uint8_t rom[8];
+
+    OwSim_Reset();
+    for (uint8_t i = 0; i < sensors; i++) {
+        int index;
+
+        OwSim_MakeRom(0x1000u + i * 0x3Bu, rom);
+        index = OwSim_AddDevice(rom, (int16_t)(20 * 16 + i));
+        OwSim_Device(index)->eeprom[2] = (uint8_t)(0x1F | (resolution << 5));
+        OwSim_Device(index)->scratchpad[4] = OwSim_Device(index)->eeprom[2];
+    }
+}
+
+static void bench_run(uint8_t sensors, uint8_t resolution)
+{
+    bench_mark_t mark;
+    float temperatures[MAX_DS18B20_SENSORS];
+    uint32_t result;
+
+    bench_setup_bus(sensors, resolution);
+    DS18B20_ResetStats();
+
+    // 搜索总线 (正常模式下结果写入设备数组)
+    DS18B20_SetConfigMode(CONFIG_MODE_NORMAL);
+    bench_begin(&mark);
+    result = DS18B20_SearchSensors();
+    bench_end(&mark, "search", sensors, resolution, result);
+
+    // 以仿真器件的ROM码作为已学习配置，避免依赖搜索结果
+    memset(ds18b20_devices, 0, sizeof(ds18b20_devices));
+    for (uint8_t i = 0; i < sensors; i++) {
+        memcpy(ds18b20_devices[i].rom_code, OwSim_Device(i)->rom, 8);
+        ds18b20_devices[i].present = 1;
+    }
+
+    // 先校准时序，随后保存的配置带有校准结果，初始化时直接加载
+    bench_begin(&mark);
+    result = DS18B20_CalibrateTiming();
+    bench_end(&mark, "calibrate", sensors, resolution, result);
+
+    // 分步校准 (运行中由总线任务在读取之间推进)，结果为单步最长耗时 (us)，即读取请求最多多等的时间
+    bench_begin(&mark);
+    result = 0;
+    if (DS18B20_StartTimingCalibration()) {
+        uint8_t more;
+
+        do {
+            uint64_t step_ns = OwSim_NowNs();
+
+            more = DS18B20_TimingStep();
+            step_ns = OwSim_NowNs() - step_ns;
+            if (step_ns / 1000u > result) {
+                result = (uint32_t)(step_ns / 1000u);
+            }
+        } while (more);
+    }
+    bench_end(&mark, "calibrate_step_max", sensors, resolution, result);
+
+    bench_begin(&mark);
+    DS18B20_SaveConfig();
+    bench_end(&mark, "save_config", sensors, resolution, 1);
+
+    bench_begin(&mark);
+    result = DS18B20_LoadConfig();
+    bench_end(&mark, "load_config", sensors, resolution, result);
+
+    bench_begin(&mark);
+    DS18B20_Init();
+    result = 0;
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        result += ds18b20_devices[i].present;
+    }
+    bench_end(&mark, "init", sensors, resolution, result);
+
+    bench_begin(&mark);
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (ds18b20_devices[i].present) {
+            DS18B20_SetResolution(i, resolution);
+        }
+    }
+    bench_end(&mark, "set_resolution", sensors, resolution, sensors);
+
+    bench_begin(&mark);
+    DS18B20_SetResolutionMask(DS18B20_MASK_ALL, resolution);
+    bench_end(&mark, "set_resolution_mask", sensors, resolution, DS18B20_IsSingleDrop());
+
+    bench_begin(&mark);
+    DS18B20_ReadAllTemperatures(temperatures);
+    result = 0;
+    for (uint8_t i = 0; i < sensors; i++) {
+        int16_t expected = OwSim_Device(i)->temp_raw & ~((1 << (3 - resolution)) - 1);
+        if (temperatures[i] == expected * 0.0625f) {
+            result++;
+        }
+    }
+    bench_end(&mark, "read_all", sensors, resolution, result);
+
+    // 总线任务的合并读取: 一次广播转换后逐个读暂存器
+    {
+        int16_t raw[MAX_DS18B20_SENSORS];
+        ds18b20_mask_t valid;
+
+        bench_begin(&mark);
+        valid = DS18B20_ReadPositions(DS18B20_MASK_ALL, raw, NULL);
+        result = 0;
+        for (uint8_t i = 0; i < sensors; i++) {
+            int16_t expected = OwSim_Device(i)->temp_raw & ~((1 << (3 - resolution)) - 1);
+            if ((valid & DS18B20_MASK_BIT(i)) && raw[i] == expected) {
+                result++;
+            }
+        }
+        bench_end(&mark, "read_positions", sensors, resolution, result);
+    }
+
+    // 1秒采集周期下每周期在读取中阻塞的平均时间: 阻塞方式与流水线方式
+    // (流水线的读数来自上一周期末发出的转换，仿真温度不变时读数应全部一致)
+    for (uint8_t pipelined = 0; pipelined < 2; pipelined++) {
+        int16_t raw[MAX_DS18B20_SENSORS];
+        ds18b20_mask_t valid = 0;
+        uint64_t blocked_ns = 0;
+        const int cycles = 5;
+        uint64_t next;
+
+        DS18B20_SetPipelined(pipelined);
+        DS18B20_ReadPositions(DS18B20_MASK_ALL, raw, NULL);
+        next = OwSim_NowNs() + 1000000000ull;
+        for (int c = 0; c < cycles; c++) {
+            uint64_t start;
+
+            if (OwSim_NowNs() < next) {
+                OwSim_AdvanceNs(next - OwSim_NowNs());
+            }
+            start = OwSim_NowNs();
+            next = start + 1000000000ull;
+            valid = DS18B20_ReadPositions(DS18B20_MASK_ALL, raw, NULL);
+            blocked_ns += OwSim_NowNs() - start;
+        }
+        result = 0;
+        for (uint8_t i = 0; i < sensors; i++) {
+            int16_t expected = OwSim_Device(i)->temp_raw & ~((1 << (3 - resolution)) - 1);
+            if ((valid & DS18B20_MASK_BIT(i)) && raw[i] == expected) {
+                result++;
+            }
+        }
+        bench_begin(&mark);
+        bench_end(&mark, pipelined ? "cycle_pipelined_us" : "cycle_blocking_us", sensors, resolution,
+                  (uint32_t)(blocked_ns / cycles / 1000u));
+        bench_end(&mark, pipelined ? "cycle_pipelined_valid" : "cycle_blocking_valid", sensors, resolution, result);
+    }
+    DS18B20_SetPipelined(DS18B20_PIPELINED);
+
+    // 周期性中断负载 (约10kHz、每次25us)下读取，检验时隙屏蔽窗口
+    DS18B20_ResetStats();
+    OwSim_SetIrqLoad(97000u, 25000u);
+    bench_begin(&mark);
+    DS18B20_ReadAllTemperatures(temperatures);
+    result = 0;
+    for (uint8_t i = 0; i < sensors; i++) {
+        int16_t expected = OwSim_Device(i)->temp_raw & ~((1 << (3 - resolution)) - 1);
+        if (temperatures[i] == expected * 0.0625f) {
+            result++;
+        }
+    }
+    bench_end(&mark, "read_all_irq", sensors, resolution, result);
+    OwSim_SetIrqLoad(0, 0);
+    {
+        ow_stats_t stats;
+        DS18B20_GetStats(&stats);
+        bench_begin(&mark);
+        bench_end(&mark, "irq_mask_max_us", sensors, resolution, stats.irq_mask_max_us);
+        bench_end(&mark, "irq_retries", sensors, resolution, stats.retries);
+    }
+
+    // 模拟重新上电: 从初始化开始到获得首个有效样本
+    bench_begin(&mark);
+    DS18B20_Init();
+    DS18B20_ReadAllTemperatures(temperatures);
+    bench_end(&mark, "boot_first_sample", sensors, resolution, DS18B20_GetBootToFirstSampleMs());
+
+    // 寄生供电器件在总线上时退回阻塞方式
+    OwSim_Device(0)->parasite = 1;
+    DS18B20_Init();
+    bench_begin(&mark);
+    bench_end(&mark, "parasite_pipelined", sensors, resolution, DS18B20_IsPipelined());
+    OwSim_Device(0)->parasite = 0;
+}
+
+// 统计读数正确的位置数
+static uint32_t bench_count_correct(const float *temperatures, uint8_t sensors, uint8_t resolution)
+{
+    uint32_t result = 0;
+
+    for (uint8_t i = 0; i < sensors; i++) {
+        int16_t expected = OwSim_Device(i)->temp_raw & ~((1 << (3 - resolution)) - 1);
+        if (temperatures[i] == expected * 0.0625f) {
+            result++;
+        }
+    }
+    return result;
+}
+
+// 初始化检测到的在线位置数
+static uint32_t bench_count_present(void)
+{
+    uint32_t result = 0;
+
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        result += ds18b20_devices[i].present;
+    }
+    return result;
+}
+
+// 不同线缆上的时序校准: 默认时序的读数、带旧版本配置 (无时序参数) 启动时的校准耗时和结果、
+// 校准后的读数，以及已保存校准结果时的再次启动
+static void bench_timing(uint8_t sensors)
+{
+    const uint8_t resolution = DS18B20_DEFAULT_RESOLUTION;
+    float temperatures[MAX_DS18B20_SENSORS];
+    bench_mark_t mark;
+    ow_timing_t timing;
+    char op[40];
+
+    for (size_t c = 0; c < sizeof(bench_cables) / sizeof(bench_cables[0]); c++) {
+        const bench_cable_t *cable = &bench_cables[c];
+
+        bench_setup_bus(sensors, resolution);
+        OwSim_SetTiming(cable->rise_ns, cable->hold_ns);
+        DS18B20_Init();  // Flash为空: 默认时序，无器件
+
+        memset(ds18b20_devices, 0, sizeof(ds18b20_devices));
+        for (uint8_t i = 0; i < sensors; i++) {
+            memcpy(ds18b20_devices[i].rom_code, OwSim_Device(i)->rom, 8);
+            ds18b20_devices[i].present = 1;
+        }
+        DS18B20_SaveConfig();
+
+        DS18B20_ReadAllTemperatures(temperatures);
+        bench_begin(&mark);
+        snprintf(op, sizeof(op), "timing_%s_default_valid", cable->name);
+        bench_end(&mark, op, sensors, resolution, bench_count_correct(temperatures, sensors, resolution));
+
+        bench_begin(&mark);
+        DS18B20_Init();
+        snprintf(op, sizeof(op), "timing_%s_boot_calibrate", cable->name);
+        bench_end(&mark, op, sensors, resolution, bench_count_present());
+
+        DS18B20_GetTiming(&timing);
+        bench_begin(&mark);
+        snprintf(op, sizeof(op), "timing_%s_sample_us", cable->name);
+        bench_end(&mark, op, sensors, resolution, timing.sample_us);
+        snprintf(op, sizeof(op), "timing_%s_recovery_us", cable->name);
+        bench_end(&mark, op, sensors, resolution, timing.recovery_us);
+
+        DS18B20_ReadAllTemperatures(temperatures);
+        bench_begin(&mark);
+        snprintf(op, sizeof(op), "timing_%s_calibrated_valid", cable->name);
+        bench_end(&mark, op, sensors, resolution, bench_count_correct(temperatures, sensors, resolution));
+
+        bench_begin(&mark);
+        DS18B20_Init();
+        snprintf(op, sizeof(op), "timing_%s_boot_saved", cable->name);
+        bench_end(&mark, op, sensors, resolution, bench_count_present());
+    }
+    OwSim_SetTiming(1000, 30000);
+}
+
+int main(int argc, char **argv)
+{
+    int verbose = (argc > 1 && strcmp(argv[1], "-v") == 0);
+    int out_fd;
+
+    // 保留原stdout输出结果，驱动的printf重定向
+    out_fd = dup(STDOUT_FILENO);
+    bench_out = fdopen(out_fd, "w");
+    if (bench_out == NULL) {
+        perror("fdopen");
+        return 1;
+    }
+    if (!freopen(verbose ? "/dev/stderr" : "/dev/null", "w", stdout)) {
+        perror("freopen");
+        return 1;
+    }
+
+    for (uint8_t resolution = 0; resolution < 4; resolution++) {
+        for (size_t i = 0; i < sizeof(bench_sensor_counts); i++) {
+            if (bench_sensor_counts[i] > MAX_DS18B20_SENSORS) {
+                continue;
+            }
+            bench_run(bench_sensor_counts[i], resolution);
+        }
+    }
+    for (size_t i = 0; i < sizeof(bench_sensor_counts); i++) {
+        if (bench_sensor_counts[i] <= MAX_DS18B20_SENSORS) {
+            bench_timing(bench_sensor_counts[i]);
+        }
+    }
+
+    fclose(bench_out);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef __HOST_FREERTOS_H
+#define __HOST_FREERTOS_H
+
+/**
+ * 主机仿真用的FreeRTOS最小替身，节拍时间由仿真时间换算 (1ms/节拍)
+ */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE             ((BaseType_t)0)
+#define pdTRUE              ((BaseType_t)1)
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS  ((TickType_t)1)
+
+#endif
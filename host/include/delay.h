@@ -0,0 +1,8 @@
+#ifndef __HOST_DELAY_H
+#define __HOST_DELAY_H
+#include "stm32f10x.h"
+
+// 毫秒延时直接推进仿真时间
+void Delay_ms(uint32_t ms);
+
+#endif
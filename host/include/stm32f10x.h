@@ -0,0 +1,42 @@
+#ifndef __HOST_STM32F10X_H
+#define __HOST_STM32F10X_H
+
+/**
+ * 主机仿真用的STM32F10x最小替身头文件
+ * 仅提供ds18b20.c用到的类型和宏，GPIO/Flash行为由ow_sim.c实现
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus;
+
+typedef struct {
+    volatile uint32_t ODR;        // 输出数据寄存器
+    volatile uint32_t OUT_MASK;   // 处于输出模式的引脚
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef OwSim_GPIOB;
+#define GPIOB               (&OwSim_GPIOB)
+
+#define GPIO_Pin_6          ((uint16_t)0x0040)
+#define GPIO_Pin_7          ((uint16_t)0x0080)
+
+#define RCC_APB2Periph_GPIOB ((uint32_t)0x00000008)
+
+extern uint32_t SystemCoreClock;
+
+// 每条NOP推进仿真时间 (与Delay_us的8 NOP/us标定一致)
+void OwSim_Nop(void);
+#define __NOP()             OwSim_Nop()
+
+// PRIMASK由仿真器记录，屏蔽期间到期的仿真中断挂起到解除屏蔽时执行
+uint32_t OwSim_GetPrimask(void);
+void OwSim_SetPrimask(uint32_t primask);
+#define __get_PRIMASK()     OwSim_GetPrimask()
+#define __set_PRIMASK(m)    OwSim_SetPrimask(m)
+#define __disable_irq()     OwSim_SetPrimask(1)
+#define __enable_irq()      OwSim_SetPrimask(0)
+
+#endif
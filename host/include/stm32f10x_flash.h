@@ -0,0 +1,22 @@
+#ifndef __HOST_STM32F10X_FLASH_H
+#define __HOST_STM32F10X_FLASH_H
+#include "stm32f10x.h"
+
+typedef enum {
+    FLASH_BUSY = 1,
+    FLASH_ERROR_PG,
+    FLASH_ERROR_WRP,
+    FLASH_COMPLETE,
+    FLASH_TIMEOUT
+} FLASH_Status;
+
+void FLASH_Unlock(void);
+void FLASH_Lock(void);
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address);
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data);
+
+// 配置页地址映射到仿真Flash
+const void *OwSim_FlashPtr(uint32_t address);
+#define FLASH_ADDR_TO_PTR(addr)     OwSim_FlashPtr(addr)
+
+#endif
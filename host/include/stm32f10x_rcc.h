@@ -0,0 +1,7 @@
+#ifndef __HOST_STM32F10X_RCC_H
+#define __HOST_STM32F10X_RCC_H
+#include "stm32f10x.h"
+
+#define RCC_APB2PeriphClockCmd(periph, state)   ((void)(periph), (void)(state))
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef __HOST_SYS_H
+#define __HOST_SYS_H
+#include "stm32f10x.h"
+
+// DWT周期计数器由仿真时间换算
+uint32_t OwSim_CycleCount(void);
+#define OW_CYCLE_COUNT()            OwSim_CycleCount()
+#define OW_CYCLE_COUNTER_INIT()     ((void)0)
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __HOST_TASK_H
+#define __HOST_TASK_H
+#include "FreeRTOS.h"
+
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+
+// 单线程仿真，临界区为空
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif
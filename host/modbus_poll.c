@@ -0,0 +1,789 @@
+/**
+ * 网关侧Modbus RTU多串口并发轮询工具
+ * 每个串口是一条RS485总线，挂多个采集节点。总线半双工，同一串口同时只有一个未完成请求；
+ * 不同串口由epoll事件循环并发推进，互不等待。每个节点用一次功能码0x03读出全部寄存器
+ * (布局见publish.h中的Modbus寄存器映射，即Publish_FillRegisters)，解码为按位置的时间序列。
+ *
+ * 帧间隔: 应答长度由请求确定，收到最后一个字节即完成，不再等待3.5字符的静默；
+ * 下一个请求从该字节起隔t3.5发出 (19200以下按3.5个字符时间，以上固定1750us)，超时后同样隔t3.5。
+ * USB转串口设置低延迟模式 (FTDI默认16ms的延迟定时器会远大于帧间隔)，需要自动收发切换的RS485转换器。
+ *
+ * 构建 (在仓库根目录):
+ *   gcc -std=gnu99 -O2 -Ihost/include -I. host/modbus_poll.c publish.c batch_frame.c -o modbus_poll
+ *
+ * 用法:
+ *   modbus_poll [选项] 串口:地址[,地址...] [串口:地址...]   地址可写范围，如/dev/ttyUSB0:1-8,12
+ *   modbus_poll [选项] -S 串口数x节点数                    测试模式: 用pty仿真节点代替串口
+ * 选项:
+ *   -b 波特率   默认19200
+ *   -E          8E1 (默认8N1)
+ *   -n 位置数   节点的位置数 (固件的MAX_DS18B20_SENSORS)，默认与本工具编译时相同
+ *   -i 周期ms   每个串口一轮轮询的最短周期，默认0 (连续轮询)
+ *   -w 超时ms   请求发送完成后等待应答的时间 (另加应答帧的传输时间)，默认50
+ *   -t 秒       运行时间，默认10，0为一直运行 (Ctrl-C结束)
+ *   -q          顺序轮询: 全部串口同时只有一个未完成请求，作为对比基准
+ *   -o 文件     时间序列输出，默认stdout
+ *   -r us       测试模式: 节点收到请求到开始应答的延时，默认1000
+ *   -l ppm      测试模式: 节点不应答的比例，默认0
+ *
+ * 测试模式下位置数与固件相同时，仿真节点的应答由固件的Publish_HandleModbus生成 (每个请求前装入该节点的样本)，
+ * 否则按同一布局直接生成寄存器。
+ * 测试模式下pty没有线路速率，仿真节点把请求和应答帧按波特率计算的传输时间计入应答延时，
+ * 吞吐量与真实总线上相同波特率时可比。
+ *
+ * 输出: 时间序列每行一个JSON对象 (JSON Lines)，每次轮询每个有效位置一行:
+ *   t 接收时间(ms，Unix时间)，sample_t 样本时间 (接收时间减样本年龄，无年龄时为null)，
+ *   temp 温度(°C)，flags 标志，seq 最近一次上报的序号
+ * 结束时向stderr输出一行统计JSON
+ */
+
+#define _GNU_SOURCE
+#include "publish.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "batch_frame.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define POLL_PORT_MAX           32
+#define POLL_NODE_MAX           247     // 从站地址1~247
+#define POLL_REG_MAX            125     // 0x03一次最多读取的寄存器数
+#define POLL_POSITION_MAX       ((POLL_REG_MAX - 3) / PUBLISH_REG_PER_POSITION)
+#define POLL_FRAME_MAX          256
+#define POLL_REQ_SIZE           8       // 地址、功能码、起始地址、数量、CRC
+#define POLL_EXC_SIZE           5       // 异常应答
+#define POLL_FC_READ_HOLDING    0x03
+#define POLL_EXC_ILLEGAL_ADDR   0x02
+#define POLL_T35_FIXED_NS       1750000ULL // 19200以上的固定t3.5
+#define POLL_OUT_BUF_SIZE       (1 << 16)
+
+// 串口轮询状态
+#define POLL_IDLE               0       // 等待帧间隔或轮询周期
+#define POLL_WAIT               1       // 等待应答
+#define POLL_HOLD               2       // 顺序轮询时等待轮到本串口
+
+typedef struct {
+    const char *path;
+    int fd;
+    int timer_fd;
+    uint8_t addrs[POLL_NODE_MAX];
+    uint16_t addr_count;
+    uint16_t next;                // 下一个轮询的节点下标
+    uint8_t state;
+    uint8_t rx[POLL_FRAME_MAX];
+    uint16_t rx_len;
+    uint64_t tx_ns;               // 请求写入时刻
+    uint64_t next_ns;             // 最早可以发出下一个请求的时刻
+    uint64_t round_ns;            // 本轮开始时刻
+    // 统计
+    uint32_t ok;
+    uint32_t timeouts;
+    uint32_t bad_frames;          // CRC错误或地址/功能码/长度不符
+    uint32_t exceptions;
+    uint64_t rtt_sum_ns;
+    uint64_t rtt_max_ns;
+} poll_port_t;
+
+typedef struct {
+    int fd;                       // pty主端
+    int timer_fd;
+    uint8_t port;
+    uint16_t node_count;          // 节点地址1~node_count
+    uint8_t rx[POLL_FRAME_MAX];
+    uint16_t rx_len;
+    uint8_t tx[POLL_FRAME_MAX];
+    uint16_t tx_len;              // 定时到后发出的应答
+} sim_port_t;
+
+static poll_port_t poll_ports[POLL_PORT_MAX];
+static uint8_t poll_port_count = 0;
+static uint32_t poll_baud = 19200;
+static uint8_t poll_even = 0;
+static uint8_t poll_positions = MAX_DS18B20_SENSORS;
+static uint16_t poll_regs;
+static uint64_t poll_char_ns;
+static uint64_t poll_t35_ns;
+static uint64_t poll_interval_ns = 0;
+static uint64_t poll_timeout_ns = 50000000ULL;
+static uint8_t poll_sequential = 0;
+static uint8_t poll_token = 0;    // 顺序轮询时持有发送权的串口
+static uint64_t poll_samples = 0;
+static uint64_t poll_wire_ns = 0; // 成功轮询的请求+应答传输时间之和
+static FILE *poll_out;
+static volatile sig_atomic_t poll_stop = 0;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double wall_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// 定时器在绝对时刻到期 (0会解除定时器，最早取1ns)
+static void timer_arm_at(int fd, uint64_t at_ns)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (at_ns == 0) at_ns = 1;
+    its.it_value.tv_sec = (time_t)(at_ns / 1000000000ULL);
+    its.it_value.tv_nsec = (long)(at_ns % 1000000000ULL);
+    timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void timer_ack(int fd)
+{
+    uint64_t expirations;
+
+    if (read(fd, &expirations, sizeof(expirations)) < 0) {
+        // 非阻塞，未到期时忽略
+    }
+}
+
+static uint16_t reg_get(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void reg_put(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint16_t frame_append_crc(uint8_t *frame, uint16_t len)
+{
+    uint16_t crc = BatchFrame_Crc16(frame, len);
+
+    frame[len++] = (uint8_t)crc;
+    frame[len++] = (uint8_t)(crc >> 8);
+    return len;
+}
+
+static uint8_t frame_crc_ok(const uint8_t *frame, uint16_t len)
+{
+    return len >= 4 && BatchFrame_Crc16(frame, len - 2) == (uint16_t)(frame[len - 2] | (frame[len - 1] << 8));
+}
+
+static speed_t baud_speed(uint32_t baud)
+{
+    switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+    }
+}
+
+// 以原始模式打开串口 (测试模式下为pty从端)
+static int port_open(const char *path)
+{
+    struct termios tio;
+    struct serial_struct ss;
+    speed_t speed = baud_speed(poll_baud);
+    int fd;
+
+    if (speed == 0) {
+        fprintf(stderr, "unsupported baud %u\n", poll_baud);
+        return -1;
+    }
+    fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (tcgetattr(fd, &tio) != 0) {
+        fprintf(stderr, "%s: not a tty\n", path);
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | PARODD | CRTSCTS);
+    if (poll_even) tio.c_cflag |= PARENB;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIOFLUSH);
+    // 不支持的驱动(包括pty)忽略
+    if (ioctl(fd, TIOCGSERIAL, &ss) == 0) {
+        ss.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &ss);
+    }
+    return fd;
+}
+
+// 解析"串口:地址[,地址...]"，地址可写a-b范围
+static int port_parse(const char *spec)
+{
+    poll_port_t *p;
+    char *colon;
+    char *list;
+    char *tok;
+    char *save = NULL;
+
+    if (poll_port_count >= POLL_PORT_MAX) return -1;
+    colon = strrchr(spec, ':');
+    if (colon == NULL || colon == spec) return -1;
+    p = &poll_ports[poll_port_count];
+    memset(p, 0, sizeof(*p));
+    p->path = strndup(spec, (size_t)(colon - spec));
+    list = strdup(colon + 1);
+    for (tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        char *end;
+        long first = strtol(tok, &end, 10);
+        long last = first;
+
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        if (*end != '\0' || first < 1 || last > POLL_NODE_MAX || first > last) {
+            free(list);
+            return -1;
+        }
+        for (long a = first; a <= last && p->addr_count < POLL_NODE_MAX; a++) {
+            p->addrs[p->addr_count++] = (uint8_t)a;
+        }
+    }
+    free(list);
+    if (p->addr_count == 0) return -1;
+    poll_port_count++;
+    return 0;
+}
+
+// 解码一个节点的寄存器，每个有效位置输出一行
+static void poll_decode(const poll_port_t *p, uint8_t addr, const uint8_t *data)
+{
+    uint16_t n = reg_get(data);
+    uint32_t seq;
+    double t = wall_ms();
+
+    seq = reg_get(&data[2 * (1 + PUBLISH_REG_PER_POSITION * n)]) |
+          ((uint32_t)reg_get(&data[2 * (2 + PUBLISH_REG_PER_POSITION * n)]) << 16);
+    for (uint16_t i = 0; i < n; i++) {
+        const uint8_t *r = &data[2 * (1 + PUBLISH_REG_PER_POSITION * i)];
+        int16_t centi = (int16_t)reg_get(r);
+        uint16_t age = reg_get(r + 2);
+        uint16_t flags = reg_get(r + 4);
+
+        if (!(flags & PUBLISH_FLAG_VALID)) continue;
+        fprintf(poll_out, "{\"t\":%.1f,\"port\":\"%s\",\"addr\":%u,\"position\":%u,\"temp\":%.2f,",
+                t, p->path, addr, i + 1, centi / 100.0);
+        if (age == 0xFFFF) {
+            fprintf(poll_out, "\"sample_t\":null,");
+        } else {
+            fprintf(poll_out, "\"sample_t\":%.1f,", t - (double)age * PUBLISH_REG_AGE_UNIT_MS);
+        }
+        fprintf(poll_out, "\"flags\":%u,\"seq\":%lu}\n", flags, (unsigned long)seq);
+        poll_samples++;
+    }
+}
+
+static void poll_send(poll_port_t *p, uint64_t now)
+{
+    uint8_t req[POLL_REQ_SIZE];
+    uint16_t resp_len = (uint16_t)(5 + 2 * poll_regs);
+
+    req[0] = p->addrs[p->next];
+    req[1] = POLL_FC_READ_HOLDING;
+    reg_put(&req[2], 0);
+    reg_put(&req[4], poll_regs);
+    frame_append_crc(req, 6);
+
+    tcflush(p->fd, TCIFLUSH);
+    p->rx_len = 0;
+    p->tx_ns = now;
+    p->state = POLL_WAIT;
+    if (write(p->fd, req, sizeof(req)) != (ssize_t)sizeof(req)) {
+        // 写失败按超时处理
+    }
+    timer_arm_at(p->timer_fd, now + (POLL_REQ_SIZE + resp_len) * poll_char_ns + poll_timeout_ns);
+}
+
+// 本次轮询结束，安排下一个请求
+static void poll_finish(poll_port_t *p, uint64_t now)
+{
+    p->state = POLL_IDLE;
+    p->next_ns = now + poll_t35_ns;
+    if (++p->next >= p->addr_count) {
+        p->next = 0;
+        if (p->round_ns + poll_interval_ns > p->next_ns) {
+            p->next_ns = p->round_ns + poll_interval_ns;
+        }
+        p->round_ns = p->next_ns;
+    }
+
+    if (poll_sequential) {
+        poll_port_t *q;
+
+        p->state = POLL_HOLD;
+        poll_token = (uint8_t)((poll_token + 1) % poll_port_count);
+        q = &poll_ports[poll_token];
+        q->state = POLL_IDLE;
+        // 不同总线之间不需要帧间隔
+        timer_arm_at(q->timer_fd, q->next_ns > now || q == p ? q->next_ns : now);
+    } else {
+        timer_arm_at(p->timer_fd, p->next_ns);
+    }
+}
+
+static void poll_on_timer(poll_port_t *p)
+{
+    uint64_t now = now_ns();
+
+    timer_ack(p->timer_fd);
+    if (p->state == POLL_IDLE) {
+        if (now < p->next_ns) {
+            timer_arm_at(p->timer_fd, p->next_ns);
+        } else {
+            poll_send(p, now);
+        }
+    } else if (p->state == POLL_WAIT) {
+        p->timeouts++;
+        poll_finish(p, now);
+    }
+}
+
+static void poll_on_rx(poll_port_t *p)
+{
+    uint64_t now;
+    uint8_t buf[POLL_FRAME_MAX];
+    ssize_t n;
+    uint16_t need;
+    uint8_t addr;
+
+    n = read(p->fd, buf, sizeof(buf));
+    if (n <= 0) return;
+    now = now_ns();
+    if (p->state != POLL_WAIT) {
+        // 超时后迟到的应答: 丢弃，线路忙，从最后一个字节重新计算帧间隔
+        if (p->next_ns < now + poll_t35_ns) p->next_ns = now + poll_t35_ns;
+        return;
+    }
+    if (p->rx_len + n > POLL_FRAME_MAX) n = POLL_FRAME_MAX - p->rx_len;
+    memcpy(&p->rx[p->rx_len], buf, (size_t)n);
+    p->rx_len += (uint16_t)n;
+
+    if (p->rx_len < 2) return;
+    need = (p->rx[1] & 0x80) ? POLL_EXC_SIZE : (uint16_t)(5 + 2 * poll_regs);
+    if (p->rx_len < need) return;
+
+    addr = p->addrs[p->next];
+    if (!frame_crc_ok(p->rx, need) || p->rx[0] != addr || (p->rx[1] & 0x7F) != POLL_FC_READ_HOLDING) {
+        p->bad_frames++;
+    } else if (p->rx[1] & 0x80) {
+        p->exceptions++;
+    } else if (p->rx[2] != 2 * poll_regs || reg_get(&p->rx[3]) != poll_positions) {
+        // 节点的位置数与-n不同
+        p->bad_frames++;
+    } else {
+        uint64_t rtt = now - p->tx_ns;
+
+        p->ok++;
+        p->rtt_sum_ns += rtt;
+        if (rtt > p->rtt_max_ns) p->rtt_max_ns = rtt;
+        poll_wire_ns += (POLL_REQ_SIZE + need) * poll_char_ns;
+        poll_decode(p, addr, &p->rx[3]);
+    }
+    poll_finish(p, now);
+}
+
+// 仿真节点位置i的温度 (0.01°C)，缓慢变化
+static int32_t sim_centi(uint8_t port, uint8_t addr, uint8_t i, uint64_t t_ms)
+{
+    return 2000 + 100 * (port % 10) + 10 * (addr % 10) + i + (int32_t)((t_ms / 1000 + i * 7) % 60) * 5;
+}
+
+// 仿真节点的样本年龄 (ms)，每秒一次采集，各节点错开
+static uint32_t sim_age_ms(uint8_t addr, uint64_t t_ms)
+{
+    return (uint32_t)((t_ms + addr * 37u) % 1000);
+}
+
+// publish.c的节拍来源: 仿真节点进程内的单调时钟 (1ms/节拍)
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(now_ns() / 1000000ULL);
+}
+
+// 仿真节点的寄存器: 与Publish_FillRegisters相同的布局，温度缓慢变化，每秒一次上报 (用于-n与固件位置数不同时)
+static uint16_t sim_fill_registers(uint8_t port, uint8_t addr, uint64_t t_ms, uint16_t *regs)
+{
+    uint16_t count = 0;
+    uint32_t seq = (uint32_t)(t_ms / 1000) + addr;
+
+    regs[count++] = poll_positions;
+    for (uint8_t i = 0; i < poll_positions; i++) {
+        uint8_t valid = ((addr + i) % 13) != 0;
+        int32_t centi = sim_centi(port, addr, i, t_ms);
+
+        regs[count++] = valid ? (uint16_t)(int16_t)centi : 0;
+        regs[count++] = valid ? (uint16_t)(sim_age_ms(addr, t_ms) / PUBLISH_REG_AGE_UNIT_MS) : 0xFFFF;
+        regs[count++] = valid ? (PUBLISH_FLAG_VALID | (((seq + i) % 4) == 0 ? PUBLISH_FLAG_CHANGED : 0)) : 0;
+    }
+    regs[count++] = (uint16_t)seq;
+    regs[count++] = (uint16_t)(seq >> 16);
+    return count;
+}
+
+// 固件的发布模块只有一份状态: 应答前把该节点此刻的样本装入，再由Publish_HandleModbus生成应答
+static void sim_load_node(uint8_t port, uint8_t addr, uint64_t t_ms)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    Publish_Init();
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        ds18b20_stamp_t stamp;
+
+        if (((addr + i) % 13) == 0) continue;
+        stamp.conv_done = now - sim_age_ms(addr, t_ms) / portTICK_PERIOD_MS;
+        stamp.conv_start = stamp.conv_done - 750 / portTICK_PERIOD_MS;
+        Publish_Update(i, (int16_t)(sim_centi(port, addr, i, t_ms) * 16 / 100), &stamp);
+    }
+    Publish_Snapshot();
+}
+
+static void sim_on_request(sim_port_t *s, uint64_t turnaround_ns, uint32_t loss_ppm)
+{
+    const uint8_t *req = s->rx;
+    uint16_t regs[POLL_REG_MAX];
+    uint16_t reg_count;
+    uint16_t start;
+    uint16_t count;
+    uint8_t *tx = s->tx;
+    uint16_t len = 0;
+    uint64_t t_ms = now_ns() / 1000000ULL;
+
+    if (!frame_crc_ok(req, POLL_REQ_SIZE) || req[0] == 0 || req[0] > s->node_count) {
+        return;
+    }
+    if (loss_ppm > 0 && (uint32_t)(rand() % 1000000) < loss_ppm) return;
+
+    if (poll_positions == MAX_DS18B20_SENSORS) {
+        // 与固件相同的从站应答 (USART2收到请求后调用的同一函数)
+        sim_load_node(s->port, req[0], t_ms);
+        s->tx_len = Publish_HandleModbus(req[0], req, POLL_REQ_SIZE, tx, sizeof(s->tx));
+    } else {
+        if (req[1] != POLL_FC_READ_HOLDING) return;
+        reg_count = sim_fill_registers(s->port, req[0], t_ms, regs);
+        start = reg_get(&req[2]);
+        count = reg_get(&req[4]);
+        tx[len++] = req[0];
+        if (count == 0 || count > POLL_REG_MAX || start + count > reg_count) {
+            tx[len++] = POLL_FC_READ_HOLDING | 0x80;
+            tx[len++] = POLL_EXC_ILLEGAL_ADDR;
+        } else {
+            tx[len++] = POLL_FC_READ_HOLDING;
+            tx[len++] = (uint8_t)(2 * count);
+            for (uint16_t i = 0; i < count; i++) {
+                reg_put(&tx[len], regs[start + i]);
+                len += 2;
+            }
+        }
+        s->tx_len = frame_append_crc(tx, len);
+    }
+    if (s->tx_len == 0) return;
+    // 请求在pty上瞬间到达，应答一次写出: 两者的线路传输时间都计入应答时刻
+    timer_arm_at(s->timer_fd, now_ns() + (POLL_REQ_SIZE + s->tx_len) * poll_char_ns + turnaround_ns);
+}
+
+// 仿真节点进程: 每个pty主端是一条总线，直到轮询端关闭从端
+static void sim_run(sim_port_t *sims, uint8_t count, uint64_t turnaround_ns, uint32_t loss_ppm)
+{
+    struct epoll_event ev;
+    struct epoll_event events[2 * POLL_PORT_MAX];
+    int ep = epoll_create1(0);
+
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    srand(12345);
+    for (uint8_t i = 0; i < count; i++) {
+        sims[i].timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)i << 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, sims[i].fd, &ev);
+        ev.data.u32 = ((uint32_t)i << 1) | 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, sims[i].timer_fd, &ev);
+    }
+
+    for (;;) {
+        int n = epoll_wait(ep, events, 2 * POLL_PORT_MAX, -1);
+
+        for (int e = 0; e < n; e++) {
+            sim_port_t *s = &sims[events[e].data.u32 >> 1];
+
+            if (events[e].data.u32 & 1) {
+                timer_ack(s->timer_fd);
+                if (s->tx_len > 0 && write(s->fd, s->tx, s->tx_len) < 0) {
+                    // 轮询端已退出
+                }
+                s->tx_len = 0;
+                continue;
+            }
+            if (events[e].events & (EPOLLHUP | EPOLLERR)) _exit(0);
+            ssize_t r = read(s->fd, &s->rx[s->rx_len], POLL_FRAME_MAX - s->rx_len);
+            if (r <= 0) {
+                if (r == 0 || errno != EAGAIN) _exit(0);
+                continue;
+            }
+            s->rx_len += (uint16_t)r;
+            // 请求都是8字节，多余或不成帧的数据丢弃
+            if (s->rx_len >= POLL_REQ_SIZE) {
+                sim_on_request(s, turnaround_ns, loss_ppm);
+                s->rx_len = 0;
+            }
+        }
+    }
+}
+
+// 创建pty仿真节点，轮询端打开从端，仿真节点在子进程中运行
+static pid_t sim_start(const char *spec, uint64_t turnaround_ns, uint32_t loss_ppm)
+{
+    static sim_port_t sims[POLL_PORT_MAX];
+    static char paths[POLL_PORT_MAX][64];
+    unsigned ports = 0;
+    unsigned nodes = 0;
+    pid_t pid;
+
+    if (sscanf(spec, "%ux%u", &ports, &nodes) != 2 || ports == 0 || ports > POLL_PORT_MAX ||
+        nodes == 0 || nodes > POLL_NODE_MAX) {
+        fprintf(stderr, "bad -S %s (ports 1~%u, nodes 1~%u)\n", spec, POLL_PORT_MAX, POLL_NODE_MAX);
+        return -1;
+    }
+    for (unsigned i = 0; i < ports; i++) {
+        poll_port_t *p = &poll_ports[i];
+        int m = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+        if (m < 0 || grantpt(m) != 0 || unlockpt(m) != 0) {
+            fprintf(stderr, "pty: %s\n", strerror(errno));
+            return -1;
+        }
+        snprintf(paths[i], sizeof(paths[i]), "%s", ptsname(m));
+        memset(&sims[i], 0, sizeof(sims[i]));
+        sims[i].fd = m;
+        sims[i].port = (uint8_t)i;
+        sims[i].node_count = (uint16_t)nodes;
+
+        memset(p, 0, sizeof(*p));
+        p->path = paths[i];
+        for (unsigned a = 1; a <= nodes; a++) {
+            p->addrs[p->addr_count++] = (uint8_t)a;
+        }
+        // 从端在仿真节点开始读之前设为原始模式
+        p->fd = port_open(p->path);
+        if (p->fd < 0) return -1;
+    }
+    poll_port_count = (uint8_t)ports;
+
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "fork: %s\n", strerror(errno));
+        return -1;
+    }
+    if (pid == 0) {
+        for (unsigned i = 0; i < ports; i++) {
+            close(poll_ports[i].fd);
+        }
+        sim_run(sims, (uint8_t)ports, turnaround_ns, loss_ppm);
+        _exit(0);
+    }
+    for (unsigned i = 0; i < ports; i++) {
+        close(sims[i].fd);
+    }
+    return pid;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    poll_stop = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: modbus_poll [-b baud] [-E] [-n positions] [-i interval_ms] [-w timeout_ms] [-t seconds]\n"
+            "                   [-q] [-o file] port:addr[,addr|a-b...] ...\n"
+            "       modbus_poll [options] [-r turnaround_us] [-l loss_ppm] -S PORTSxNODES\n");
+}
+
+int main(int argc, char **argv)
+{
+    struct epoll_event ev;
+    struct epoll_event events[2 * POLL_PORT_MAX];
+    const char *sim_spec = NULL;
+    const char *out_path = NULL;
+    uint64_t turnaround_ns = 1000000ULL;
+    uint32_t loss_ppm = 0;
+    double seconds = 10.0;
+    uint32_t bits;
+    uint64_t start;
+    uint64_t end;
+    pid_t sim_pid = 0;
+    uint32_t nodes = 0;
+    uint32_t ok = 0, timeouts = 0, bad = 0, exceptions = 0;
+    uint64_t rtt_sum = 0, rtt_max = 0;
+    double elapsed;
+    int ep;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:En:i:w:t:qo:S:r:l:")) != -1) {
+        switch (opt) {
+        case 'b': poll_baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'E': poll_even = 1; break;
+        case 'n': poll_positions = (uint8_t)atoi(optarg); break;
+        case 'i': poll_interval_ns = (uint64_t)strtoull(optarg, NULL, 10) * 1000000ULL; break;
+        case 'w': poll_timeout_ns = (uint64_t)strtoull(optarg, NULL, 10) * 1000000ULL; break;
+        case 't': seconds = atof(optarg); break;
+        case 'q': poll_sequential = 1; break;
+        case 'o': out_path = optarg; break;
+        case 'S': sim_spec = optarg; break;
+        case 'r': turnaround_ns = (uint64_t)strtoull(optarg, NULL, 10) * 1000ULL; break;
+        case 'l': loss_ppm = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default: usage(); return 2;
+        }
+    }
+    if (poll_positions == 0 || poll_positions > POLL_POSITION_MAX) {
+        fprintf(stderr, "positions 1~%u (one read of at most %u registers)\n", POLL_POSITION_MAX, POLL_REG_MAX);
+        return 2;
+    }
+    poll_regs = (uint16_t)(1 + PUBLISH_REG_PER_POSITION * poll_positions + 2);
+    // 起始位、8数据位、校验位或第二停止位按规范计11位；8N1按10位
+    bits = poll_even ? 11 : 10;
+    poll_char_ns = (uint64_t)bits * 1000000000ULL / (poll_baud ? poll_baud : 1);
+    poll_t35_ns = poll_baud > 19200 ? POLL_T35_FIXED_NS : poll_char_ns * 7 / 2;
+
+    if (sim_spec != NULL) {
+        if (optind != argc) {
+            usage();
+            return 2;
+        }
+        sim_pid = sim_start(sim_spec, turnaround_ns, loss_ppm);
+        if (sim_pid < 0) return 1;
+    } else {
+        if (optind == argc) {
+            usage();
+            return 2;
+        }
+        for (int i = optind; i < argc; i++) {
+            if (port_parse(argv[i]) != 0) {
+                fprintf(stderr, "bad port spec %s\n", argv[i]);
+                return 2;
+            }
+            poll_ports[poll_port_count - 1].fd = port_open(poll_ports[poll_port_count - 1].path);
+            if (poll_ports[poll_port_count - 1].fd < 0) return 1;
+        }
+    }
+
+    poll_out = stdout;
+    if (out_path != NULL) {
+        poll_out = fopen(out_path, "w");
+        if (poll_out == NULL) {
+            fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+            return 1;
+        }
+    }
+    setvbuf(poll_out, NULL, _IOFBF, POLL_OUT_BUF_SIZE);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    ep = epoll_create1(0);
+    start = now_ns();
+    for (uint8_t i = 0; i < poll_port_count; i++) {
+        poll_port_t *p = &poll_ports[i];
+
+        p->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)i << 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, p->fd, &ev);
+        ev.data.u32 = ((uint32_t)i << 1) | 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, p->timer_fd, &ev);
+        p->next_ns = start;
+        p->round_ns = start;
+        p->state = (poll_sequential && i != 0) ? POLL_HOLD : POLL_IDLE;
+        if (p->state == POLL_IDLE) timer_arm_at(p->timer_fd, start);
+        nodes += p->addr_count;
+    }
+
+    end = seconds > 0 ? start + (uint64_t)(seconds * 1e9) : 0;
+    while (!poll_stop) {
+        int wait_ms = -1;
+        int n;
+
+        if (end != 0) {
+            uint64_t now = now_ns();
+
+            if (now >= end) break;
+            wait_ms = (int)((end - now) / 1000000ULL) + 1;
+        }
+        n = epoll_wait(ep, events, 2 * POLL_PORT_MAX, wait_ms);
+        for (int e = 0; e < n; e++) {
+            poll_port_t *p = &poll_ports[events[e].data.u32 >> 1];
+
+            if (events[e].data.u32 & 1) {
+                poll_on_timer(p);
+            } else {
+                poll_on_rx(p);
+            }
+        }
+    }
+    elapsed = (double)(now_ns() - start) / 1e9;
+    fflush(poll_out);
+
+    if (sim_pid > 0) {
+        kill(sim_pid, SIGTERM);
+        waitpid(sim_pid, NULL, 0);
+    }
+
+    for (uint8_t i = 0; i < poll_port_count; i++) {
+        ok += poll_ports[i].ok;
+        timeouts += poll_ports[i].timeouts;
+        bad += poll_ports[i].bad_frames;
+        exceptions += poll_ports[i].exceptions;
+        rtt_sum += poll_ports[i].rtt_sum_ns;
+        if (poll_ports[i].rtt_max_ns > rtt_max) rtt_max = poll_ports[i].rtt_max_ns;
+    }
+    fprintf(stderr,
+            "{\"mode\":\"%s\",\"ports\":%u,\"nodes\":%lu,\"baud\":%u,\"registers\":%u,\"t35_us\":%.0f,"
+            "\"seconds\":%.2f,\"polls\":%lu,\"ok\":%lu,\"timeouts\":%lu,\"bad_frames\":%lu,\"exceptions\":%lu,"
+            "\"polls_per_s\":%.1f,\"node_hz\":%.3f,\"samples\":%llu,\"rtt_avg_us\":%.0f,\"rtt_max_us\":%.0f,"
+            "\"bus_util\":%.3f}\n",
+            poll_sequential ? "sequential" : "pipelined", poll_port_count, (unsigned long)nodes, poll_baud,
+            poll_regs, poll_t35_ns / 1e3, elapsed, (unsigned long)(ok + timeouts + bad + exceptions),
+            (unsigned long)ok, (unsigned long)timeouts, (unsigned long)bad, (unsigned long)exceptions,
+            ok / elapsed, nodes ? ok / elapsed / nodes : 0.0, (unsigned long long)poll_samples,
+            ok ? rtt_sum / 1e3 / ok : 0.0, rtt_max / 1e3,
+            poll_port_count ? poll_wire_ns / 1e9 / elapsed / poll_port_count : 0.0);
+    return 0;
+}
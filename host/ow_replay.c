@@ -0,0 +1,350 @@
+/**
+ * 1-Wire跟踪记录主机回放工具
+ *
+ * 构建 (在仓库根目录):
+ *   gcc -std=gnu99 -O2 -I. host/ow_replay.c ow_trace.c -o ow_replay
+ *
+ * 用法:
+ *   ow_replay [-v] [FILE]   解析配置口OWTRACE命令的输出 (默认stdin)，
+ *                           多次导出时只回放最后一次；没有BEGIN/END时读取全部8位十六进制数
+ *   -v                      打印出错事务的每个时隙
+ *
+ * 用驱动相同的字节拼装和CRC逻辑还原每个事务，对CRC错误给出判断:
+ *   时序  - 事务中有超出规范的时隙 (读采样晚于15us、写1低电平过长、写0低电平不足、存在脉冲采样过晚)
+ *   无应答 - 读到全1，器件未驱动总线
+ *   短路  - 读到全0，总线被拉低
+ *   噪声  - 时序都在规范内，与同一器件上次正确的暂存器相比有个别位翻转；
+ *           没有参考值时列出翻转后能通过CRC的单个位
+ */
+
+#include "ow_trace.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAX_ENTRIES  65536
+#define REPLAY_MAX_ROMS     64
+
+static const char *replay_cmd_name(uint8_t cmd)
+{
+    switch (cmd) {
+    case 0x55: return "MATCH";
+    case 0xCC: return "SKIP";
+    case 0x33: return "READ_ROM";
+    case 0xF0: return "SEARCH";
+    case 0x44: return "CONVERT";
+    case 0xBE: return "READ_SP";
+    case 0x4E: return "WRITE_SP";
+    case 0x48: return "COPY_SP";
+    case 0xB8: return "RECALL";
+    case 0xB4: return "READ_PWR";
+    default:   return NULL;
+    }
+}
+
+// 同一器件上次CRC正确的暂存器，用于判断翻转的位
+typedef struct {
+    uint8_t rom[8];
+    uint8_t sp[9];
+} replay_ref_t;
+
+typedef struct {
+    int verbose;
+    replay_ref_t refs[REPLAY_MAX_ROMS];
+    int ref_count;
+    unsigned txns, sp_reads, crc_bad, timing, no_response, shorted, noise, unknown, zero_pass, rom_bad;
+} replay_t;
+
+static replay_ref_t *replay_find_ref(replay_t *r, const uint8_t *rom, int create)
+{
+    for (int i = 0; i < r->ref_count; i++) {
+        if (memcmp(r->refs[i].rom, rom, 8) == 0) {
+            return &r->refs[i];
+        }
+    }
+    if (!create || r->ref_count >= REPLAY_MAX_ROMS) {
+        return NULL;
+    }
+    memcpy(r->refs[r->ref_count].rom, rom, 8);
+    return &r->refs[r->ref_count++];
+}
+
+static void replay_print_slot(const uint32_t *entries, uint16_t index)
+{
+    uint32_t e = entries[index];
+    uint16_t timing = OW_TRACE_TIMING(e);
+
+    switch (OW_TRACE_KIND(e)) {
+    case OW_TRACE_RESET:
+        printf("      #%-5u +%6luus RESET presence=%u sample@%uus%s\n", index,
+               (unsigned long)OW_TRACE_DELTA_US(e), OW_TRACE_VALUE(e), timing,
+               timing > OW_TRACE_PRESENCE_MAX_US ? "  <-- late" : "");
+        break;
+    case OW_TRACE_WRITE:
+        printf("      #%-5u +%6luus W%u low=%.2fus%s\n", index,
+               (unsigned long)OW_TRACE_DELTA_US(e), OW_TRACE_VALUE(e), timing / 4.0,
+               (OW_TRACE_VALUE(e) ? timing > OW_TRACE_WRITE1_LOW_MAX : timing < OW_TRACE_WRITE0_LOW_MIN) ?
+               "  <-- out of spec" : "");
+        break;
+    case OW_TRACE_READ:
+        printf("      #%-5u +%6luus R%u sample@%.2fus%s\n", index,
+               (unsigned long)OW_TRACE_DELTA_US(e), OW_TRACE_VALUE(e), timing / 4.0,
+               timing > OW_TRACE_READ_SAMPLE_MAX ? "  <-- late" : "");
+        break;
+    default:
+        printf("      #%-5u MARK code=%u arg=%u\n", index, OW_TRACE_MARK_CODE(e), OW_TRACE_MARK_ARG(e));
+        break;
+    }
+}
+
+// 第n个读时隙的记录序号
+static int replay_read_slot(const ow_trace_txn_t *txn, const uint32_t *entries, int n)
+{
+    for (uint16_t i = txn->first; i < txn->first + txn->count; i++) {
+        if (OW_TRACE_KIND(entries[i]) == OW_TRACE_READ && n-- == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int replay_all(const uint8_t *data, uint8_t len, uint8_t value)
+{
+    for (uint8_t i = 0; i < len; i++) {
+        if (data[i] != value) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 分析暂存器读取失败的原因
+static void replay_diagnose(replay_t *r, const ow_trace_txn_t *txn, const uint32_t *entries)
+{
+    replay_ref_t *ref = txn->rom_valid ? replay_find_ref(r, txn->rom, 0) : NULL;
+
+    if (txn->timing_faults > 0) {
+        r->timing++;
+        printf("    => timing: %u slot(s) out of spec, first at #%u\n", txn->timing_faults, txn->first_fault);
+        replay_print_slot(entries, txn->first_fault);
+    } else if (replay_all(txn->rd, 9, 0xFF)) {
+        r->no_response++;
+        printf("    => no response: device did not drive the bus (dropped or open line)\n");
+    } else if (replay_all(txn->rd, 9, 0x00)) {
+        r->shorted++;
+        printf("    => bus held low: all bits read 0 (short or stuck device)\n");
+    } else if (ref != NULL) {
+        int flipped = 0;
+
+        r->noise++;
+        printf("    => noise: timing in spec, bits differing from last good read of this device:\n");
+        for (int b = 0; b < 72; b++) {
+            uint8_t now = (txn->rd[b / 8] >> (b % 8)) & 1;
+            uint8_t was = (ref->sp[b / 8] >> (b % 8)) & 1;
+            if (now != was) {
+                int slot = replay_read_slot(txn, entries, b);
+                flipped++;
+                printf("       bit %2d (byte %d) %u->%u", b, b / 8, was, now);
+                if (slot >= 0) {
+                    printf("  slot #%d sample@%.2fus", slot, OW_TRACE_TIMING(entries[slot]) / 4.0);
+                }
+                printf("\n");
+            }
+        }
+        printf("       %d bit(s) differ (temperature bytes 0-1 may legitimately change)\n", flipped);
+    } else {
+        uint8_t sp[9];
+        int candidates = 0;
+
+        r->unknown++;
+        printf("    => CRC mismatch with timing in spec and no reference read: suspect noise\n");
+        // 单个位翻转即可通过CRC时给出该位 (CRC8可区分72位内的单比特错误)
+        for (int b = 0; b < 72; b++) {
+            memcpy(sp, txn->rd, 9);
+            sp[b / 8] ^= (uint8_t)(1 << (b % 8));
+            if (OW_Crc8(sp, 8) == sp[8]) {
+                int slot = replay_read_slot(txn, entries, b);
+                candidates++;
+                printf("       single-bit error candidate: bit %2d (byte %d)", b, b / 8);
+                if (slot >= 0) {
+                    printf("  slot #%d sample@%.2fus", slot, OW_TRACE_TIMING(entries[slot]) / 4.0);
+                }
+                printf("\n");
+            }
+        }
+        if (candidates == 0) {
+            printf("       more than one bit corrupted\n");
+        }
+    }
+}
+
+static void replay_txn(void *ctx, const ow_trace_txn_t *txn, const uint32_t *entries)
+{
+    replay_t *r = ctx;
+    const char *rom_name = replay_cmd_name(txn->rom_cmd);
+    const char *func_name = replay_cmd_name(txn->func_cmd);
+    int bad = 0;
+
+    r->txns++;
+    printf("%10.3f ms  RST p=%u@%uus", txn->start_us / 1000.0, txn->presence, txn->presence_us);
+    if (txn->rom_cmd != 0) {
+        if (rom_name != NULL) {
+            printf("  %s", rom_name);
+        } else {
+            printf("  ROM?%02X", txn->rom_cmd);
+        }
+    }
+    if (txn->rom_valid) {
+        printf(" ");
+        for (int i = 0; i < 8; i++) {
+            printf("%02X", txn->rom[i]);
+        }
+        if (!txn->rom_crc_ok) {
+            printf(" ROM-CRC-BAD");
+            r->rom_bad++;
+            bad = 1;
+        }
+    }
+    if (txn->func_cmd != 0) {
+        if (func_name != NULL) {
+            printf("  %s", func_name);
+        } else {
+            printf("  CMD?%02X", txn->func_cmd);
+        }
+    }
+    if (txn->rd_len > 0 && txn->rom_cmd != 0x33) {
+        printf("  rd=");
+        for (uint8_t i = 0; i < txn->rd_len; i++) {
+            printf("%02X", txn->rd[i]);
+        }
+    } else if (txn->rd_bits > 0 && txn->rom_cmd != 0x33) {
+        printf("  rd_bits=%u", txn->rd_bits);
+    }
+    if (txn->sp_valid) {
+        r->sp_reads++;
+        if (!txn->sp_crc_ok) {
+            printf("  CRC-BAD");
+            bad = 1;
+        } else if (replay_all(txn->rd, 9, 0x00)) {
+            printf("  CRC-ok-ALL-ZERO");
+            r->zero_pass++;
+            bad = 1;
+        } else {
+            printf("  CRC-ok");
+        }
+    }
+    if (txn->mark_code == OW_TRACE_MARK_CRC) {
+        printf("  [driver: CRC error pos %u]", txn->mark_arg);
+    } else if (txn->mark_code == OW_TRACE_MARK_ROM_CRC) {
+        printf("  [driver: ROM CRC error]");
+    }
+    if (txn->timing_faults > 0) {
+        printf("  timing_faults=%u", txn->timing_faults);
+        bad = 1;
+    }
+    printf("  read_sample_max=%.2fus\n", txn->read_sample_max / 4.0);
+
+    if (txn->sp_valid && !txn->sp_crc_ok) {
+        r->crc_bad++;
+        replay_diagnose(r, txn, entries);
+    } else if (txn->sp_valid && txn->rom_valid && !replay_all(txn->rd, 9, 0x00)) {
+        replay_ref_t *ref = replay_find_ref(r, txn->rom, 1);
+        if (ref != NULL) {
+            memcpy(ref->sp, txn->rd, 9);
+        }
+    }
+
+    if (bad && r->verbose) {
+        for (uint16_t i = txn->first; i < txn->first + txn->count; i++) {
+            replay_print_slot(entries, i);
+        }
+    }
+}
+
+static int replay_hex_word(const char *tok, uint32_t *value)
+{
+    char *end;
+
+    if (strlen(tok) != 8) {
+        return 0;
+    }
+    for (int i = 0; i < 8; i++) {
+        if (!isxdigit((unsigned char)tok[i])) {
+            return 0;
+        }
+    }
+    *value = (uint32_t)strtoul(tok, &end, 16);
+    return 1;
+}
+
+// 读取记录: 遇到BEGIN时重新开始，END之后的内容忽略直到下一个BEGIN
+static uint32_t replay_load(FILE *in, uint32_t *entries, uint32_t max)
+{
+    char line[512];
+    uint32_t count = 0;
+    int framed = 0, inside = 0;
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char *tok;
+
+        if (strstr(line, "OWTRACE BEGIN") != NULL) {
+            framed = 1;
+            inside = 1;
+            count = 0;
+            continue;
+        }
+        if (strstr(line, "OWTRACE END") != NULL) {
+            inside = 0;
+            continue;
+        }
+        if (framed && !inside) {
+            continue;
+        }
+        for (tok = strtok(line, " \t\r\n"); tok != NULL; tok = strtok(NULL, " \t\r\n")) {
+            uint32_t value;
+            if (count < max && replay_hex_word(tok, &value)) {
+                entries[count++] = value;
+            }
+        }
+    }
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    static uint32_t entries[REPLAY_MAX_ENTRIES];
+    static replay_t r;
+    FILE *in = stdin;
+    uint32_t count;
+    int argi = 1;
+
+    if (argi < argc && strcmp(argv[argi], "-v") == 0) {
+        r.verbose = 1;
+        argi++;
+    }
+    if (argi < argc) {
+        in = fopen(argv[argi], "r");
+        if (in == NULL) {
+            perror(argv[argi]);
+            return 2;
+        }
+    }
+    count = replay_load(in, entries, REPLAY_MAX_ENTRIES);
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (count == 0) {
+        fprintf(stderr, "no trace entries\n");
+        return 2;
+    }
+
+    OwTrace_Decode(entries, (uint16_t)(count > 0xFFFF ? 0xFFFF : count), replay_txn, &r);
+
+    printf("\n%lu entries, %u transactions, %u scratchpad reads, %u CRC errors "
+           "(timing %u, no response %u, bus low %u, noise %u, unknown %u), "
+           "%u all-zero scratchpads passing CRC, %u bad ROM CRCs\n",
+           (unsigned long)count, r.txns, r.sp_reads, r.crc_bad,
+           r.timing, r.no_response, r.shorted, r.noise, r.unknown, r.zero_pass, r.rom_bad);
+    return (r.crc_bad || r.zero_pass || r.rom_bad) ? 1 : 0;
+}
@@ -0,0 +1,712 @@
+/**
+ * 时序精确的1-Wire总线仿真 (主机构建)
+ *
+ * 主机端在GPIO_Init/SetBits/ResetBits中产生下降沿和释放沿，
+ * 器件在下降沿决定本时隙是否拉低总线(发送0)，在释放沿按采样点解码时隙:
+ *   低电平 >= 400us       -> 复位，随后器件回应存在脉冲
+ *   采样点处总线为低      -> 位0
+ *   否则                  -> 位1
+ * 主机读取引脚时，主机拉低、器件拉低窗口或线缆上升时间内均读为低电平
+ * 主机或器件释放后总线经上升时间才回到高电平，此前再次拉低时器件看不到下降沿，
+ * 该时隙被漏掉 (恢复时间不足)
+ */
+
+#include "ow_sim.h"
+#include "ds_log.h"
+#include "stm32f10x.h"
+#include "stm32f10x_gpio.h"
+#include "stm32f10x_flash.h"
+#include "delay.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+#define OW_SIM_PIN              GPIO_Pin_7
+#define OW_SIM_NOP_NS           125u        // 8 NOP = 1us
+#define OW_SIM_GLITCH_NS        500u        // 更短的低脉冲视为毛刺
+#define OW_SIM_RESET_NS         400000u     // 复位脉冲判定阈值
+#define OW_SIM_SAMPLE_NS        20000u      // 器件采样点 (下降沿后)
+#define OW_SIM_PRESENCE_WAIT_NS 30000u      // 释放后到存在脉冲开始
+#define OW_SIM_PRESENCE_NS      120000u     // 存在脉冲宽度
+#define OW_SIM_SLOT_NS          60000u      // 时隙长度，用于区分读时隙采样
+#define OW_SIM_COPY_NS          10000000u   // 复制暂存器到EEPROM耗时
+#define OW_SIM_FLASH_ERASE_NS   20000000u   // 页擦除耗时
+#define OW_SIM_FLASH_WORD_NS    105000u     // 字编程耗时
+
+// 器件状态
+enum {
+    DEV_IDLE = 0,       // 未选中，等待复位
+    DEV_ROM_CMD,        // 接收ROM命令
+    DEV_MATCH,          // 接收匹配ROM码
+    DEV_SEARCH,         // 搜索ROM
+    DEV_FUNC_CMD,       // 接收功能命令
+    DEV_TX,             // 发送数据
+    DEV_WRITE_SP,       // 接收写暂存器数据
+    DEV_POLL            // 转换/复制中，读时隙返回忙状态
+};
+
+GPIO_TypeDef OwSim_GPIOB;
+uint32_t SystemCoreClock = 72000000;
+
+static ow_sim_device_t sim_devices[OW_SIM_MAX_DEVICES];
+static int sim_device_count = 0;
+static uint64_t sim_now_ns = 0;
+static uint8_t sim_master_low = 0;
+static uint64_t sim_fall_ns = 0;
+static uint64_t sim_release_ns = 0;
+static uint8_t sim_fall_missed = 0;       // 本次下降沿时总线尚未回到高电平
+static uint32_t sim_rise_ns = 1000;
+static uint32_t sim_hold_ns = 30000;
+static uint8_t sim_flash[OW_SIM_FLASH_SIZE];
+static uint32_t sim_primask = 0;
+static uint32_t sim_irq_period_ns = 0;
+static uint32_t sim_irq_duration_ns = 0;
+static uint64_t sim_irq_next_ns = 0;
+static ow_sim_faults_t sim_faults;
+static ow_sim_fault_counts_t sim_fault_counts;
+static uint32_t sim_rand_state = 1;
+static uint64_t sim_stuck_until_ns = 0;
+
+uint8_t OwSim_Crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0;
+
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = (crc & 0x01) ? (uint8_t)((crc >> 1) ^ 0x8C) : (uint8_t)(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+void OwSim_Reset(void)
+{
+    memset(sim_devices, 0, sizeof(sim_devices));
+    sim_device_count = 0;
+    sim_now_ns = 0;
+    sim_master_low = 0;
+    sim_fall_ns = 0;
+    sim_release_ns = 0;
+    sim_fall_missed = 0;
+    memset(&OwSim_GPIOB, 0, sizeof(OwSim_GPIOB));
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    sim_primask = 0;
+    sim_irq_next_ns = sim_irq_period_ns;
+    memset(&sim_faults, 0, sizeof(sim_faults));
+    memset(&sim_fault_counts, 0, sizeof(sim_fault_counts));
+    sim_stuck_until_ns = 0;
+}
+
+// xorshift32，保证同一seed下故障序列可复现
+static uint32_t sim_rand(void)
+{
+    uint32_t x = sim_rand_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim_rand_state = x;
+    return x;
+}
+
+static uint8_t sim_chance(uint32_t ppm)
+{
+    return ppm != 0 && (sim_rand() % 1000000u) < ppm;
+}
+
+void OwSim_SetFaults(const ow_sim_faults_t *faults, uint32_t seed)
+{
+    if (faults != NULL) {
+        sim_faults = *faults;
+    } else {
+        memset(&sim_faults, 0, sizeof(sim_faults));
+    }
+    memset(&sim_fault_counts, 0, sizeof(sim_fault_counts));
+    sim_rand_state = seed ? seed : 1;
+}
+
+void OwSim_GetFaultCounts(ow_sim_fault_counts_t *counts)
+{
+    *counts = sim_fault_counts;
+}
+
+void OwSim_SetDeviceOffline(int index, uint64_t from_ns, uint64_t until_ns)
+{
+    if (index >= 0 && index < sim_device_count) {
+        sim_devices[index].offline_from_ns = from_ns;
+        sim_devices[index].offline_until_ns = until_ns;
+    }
+}
+
+static uint8_t dev_online(const ow_sim_device_t *dev)
+{
+    return sim_now_ns < dev->offline_from_ns || sim_now_ns >= dev->offline_until_ns;
+}
+
+// 总线是否被故障拉低
+static uint8_t sim_stuck(void)
+{
+    return sim_now_ns < sim_stuck_until_ns;
+}
+
+void OwSim_MakeRom(uint32_t serial, uint8_t *rom)
+{
+    rom[0] = 0x28;
+    rom[1] = (uint8_t)serial;
+    rom[2] = (uint8_t)(serial >> 8);
+    rom[3] = (uint8_t)(serial >> 16);
+    rom[4] = (uint8_t)(serial >> 24);
+    rom[5] = 0x00;
+    rom[6] = 0x00;
+    rom[7] = OwSim_Crc8(rom, 7);
+}
+
+int OwSim_AddDevice(const uint8_t *rom, int16_t temp_raw)
+{
+    ow_sim_device_t *dev;
+
+    if (sim_device_count >= OW_SIM_MAX_DEVICES) {
+        return -1;
+    }
+
+    dev = &sim_devices[sim_device_count];
+    memset(dev, 0, sizeof(*dev));
+    memcpy(dev->rom, rom, 8);
+    dev->temp_raw = temp_raw;
+    dev->eeprom[0] = 0x4B;
+    dev->eeprom[1] = 0x46;
+    dev->eeprom[2] = 0x7F;
+
+    // 上电默认值: 85°C
+    dev->scratchpad[0] = 0x50;
+    dev->scratchpad[1] = 0x05;
+    memcpy(&dev->scratchpad[2], dev->eeprom, 3);
+    dev->scratchpad[5] = 0xFF;
+    dev->scratchpad[6] = 0x0C;
+    dev->scratchpad[7] = 0x10;
+    dev->state = DEV_IDLE;
+
+    return sim_device_count++;
+}
+
+int OwSim_DeviceCount(void)
+{
+    return sim_device_count;
+}
+
+ow_sim_device_t *OwSim_Device(int index)
+{
+    if (index < 0 || index >= sim_device_count) {
+        return NULL;
+    }
+    return &sim_devices[index];
+}
+
+uint64_t OwSim_NowNs(void)
+{
+    return sim_now_ns;
+}
+
+void OwSim_AdvanceNs(uint64_t ns)
+{
+    sim_now_ns += ns;
+}
+
+void OwSim_SetTiming(uint32_t rise_ns, uint32_t hold_ns)
+{
+    sim_rise_ns = rise_ns;
+    sim_hold_ns = hold_ns;
+}
+
+// 执行已到期的仿真中断
+static void sim_irq_poll(void)
+{
+    if (sim_irq_period_ns == 0 || sim_primask) {
+        return;
+    }
+    while (sim_irq_next_ns <= sim_now_ns) {
+        sim_now_ns += sim_irq_duration_ns;
+        sim_irq_next_ns += sim_irq_period_ns;
+    }
+}
+
+void OwSim_SetIrqLoad(uint32_t period_ns, uint32_t duration_ns)
+{
+    sim_irq_period_ns = period_ns;
+    sim_irq_duration_ns = duration_ns;
+    sim_irq_next_ns = sim_now_ns + period_ns;
+}
+
+uint32_t OwSim_GetPrimask(void)
+{
+    return sim_primask;
+}
+
+void OwSim_SetPrimask(uint32_t primask)
+{
+    sim_primask = primask & 1u;
+    sim_irq_poll();
+}
+
+void OwSim_Nop(void)
+{
+    sim_now_ns += OW_SIM_NOP_NS;
+    sim_irq_poll();
+}
+
+uint32_t OwSim_CycleCount(void)
+{
+    return (uint32_t)(sim_now_ns * (SystemCoreClock / 1000000u) / 1000u);
+}
+
+void Delay_ms(uint32_t ms)
+{
+    sim_now_ns += (uint64_t)ms * 1000000u;
+    sim_irq_poll();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(sim_now_ns / 1000000u);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_now_ns += (uint64_t)ticks * 1000000u;
+    sim_irq_poll();
+}
+
+// 单线程仿真，printf不需要与日志DMA互斥
+void DS_Log_TxLock(void)
+{
+}
+
+void DS_Log_TxUnlock(void)
+{
+}
+
+// 转换完成后以转换开始时采样的温度更新暂存器 (按分辨率截断低位)
+static void dev_sync(ow_sim_device_t *dev)
+{
+    if (dev->conv_pending && sim_now_ns >= dev->busy_until_ns) {
+        uint8_t resolution = (dev->scratchpad[4] >> 5) & 0x03;
+        int16_t raw = (int16_t)(dev->conv_raw & ~((1 << (3 - resolution)) - 1));
+
+        dev->scratchpad[0] = (uint8_t)raw;
+        dev->scratchpad[1] = (uint8_t)((uint16_t)raw >> 8);
+        dev->conv_pending = 0;
+    }
+}
+
+// 准备发送缓冲区
+static void dev_start_tx(ow_sim_device_t *dev, const uint8_t *data, uint8_t bits, uint8_t next_state)
+{
+    memcpy(dev->tx_buf, data, (bits + 7) / 8);
+    dev->tx_bits = bits;
+    dev->tx_pos = 0;
+    dev->state = DEV_TX;
+    dev->next_state = next_state;
+}
+
+// 本时隙器件要发送的位，返回0xFF表示不发送
+static uint8_t dev_tx_bit(ow_sim_device_t *dev)
+{
+    uint8_t bit;
+
+    switch (dev->state) {
+    case DEV_TX:
+        return (dev->tx_buf[dev->tx_pos / 8] >> (dev->tx_pos % 8)) & 0x01;
+    case DEV_SEARCH:
+        if (dev->search_phase == 2) {
+            return 0xFF;
+        }
+        bit = (dev->rom[dev->search_bit / 8] >> (dev->search_bit % 8)) & 0x01;
+        return (dev->search_phase == 0) ? bit : (uint8_t)!bit;
+    case DEV_POLL:
+        return (sim_now_ns >= dev->busy_until_ns) ? 1 : 0;
+    default:
+        return 0xFF;
+    }
+}
+
+// 接收一个字节的一位，收满8位返回1
+static uint8_t dev_rx_bit(ow_sim_device_t *dev, uint8_t bit)
+{
+    dev->rx_byte = (uint8_t)((dev->rx_byte >> 1) | (bit ? 0x80 : 0x00));
+    if (++dev->rx_bits < 8) {
+        return 0;
+    }
+    dev->rx_bits = 0;
+    return 1;
+}
+
+// 执行功能命令
+static void dev_function(ow_sim_device_t *dev, uint8_t cmd)
+{
+    uint8_t data[9];
+    uint8_t resolution;
+
+    dev_sync(dev);
+
+    switch (cmd) {
+    case 0x44:  // CONVERT_T
+        resolution = (dev->scratchpad[4] >> 5) & 0x03;
+        dev->busy_until_ns = sim_now_ns + (93750000ull << resolution);
+        if (sim_chance(sim_faults.slow_conv_ppm)) {
+            dev->busy_until_ns += sim_faults.slow_conv_ns;
+            sim_fault_counts.slow_convs++;
+        }
+        dev->conv_raw = dev->temp_raw;
+        dev->conv_pending = 1;
+        dev->state = DEV_POLL;
+        break;
+    case 0xBE:  // READ_SCRATCHPAD
+        dev->scratchpad[8] = OwSim_Crc8(dev->scratchpad, 8);
+        dev_start_tx(dev, dev->scratchpad, 72, DEV_IDLE);
+        break;
+    case 0x4E:  // WRITE_SCRATCHPAD
+        dev->rx_count = 0;
+        dev->state = DEV_WRITE_SP;
+        break;
+    case 0x48:  // COPY_SCRATCHPAD
+        memcpy(dev->eeprom, &dev->scratchpad[2], 3);
+        dev->busy_until_ns = sim_now_ns + OW_SIM_COPY_NS;
+        dev->state = DEV_POLL;
+        break;
+    case 0xB8:  // RECALL_EEPROM
+        memcpy(&dev->scratchpad[2], dev->eeprom, 3);
+        dev->busy_until_ns = sim_now_ns;
+        dev->state = DEV_POLL;
+        break;
+    case 0xB4:  // READ_POWER_SUPPLY
+        data[0] = dev->parasite ? 0x00 : 0x01;
+        dev_start_tx(dev, data, 1, DEV_IDLE);
+        break;
+    default:
+        dev->state = DEV_IDLE;
+        break;
+    }
+}
+
+// 器件处理一个已完成的时隙
+static void dev_slot(ow_sim_device_t *dev, uint8_t bit)
+{
+    uint8_t rom_bit;
+
+    switch (dev->state) {
+    case DEV_ROM_CMD:
+        if (!dev_rx_bit(dev, bit)) {
+            break;
+        }
+        switch (dev->rx_byte) {
+        case 0x33:  // READ_ROM
+            dev_start_tx(dev, dev->rom, 64, DEV_FUNC_CMD);
+            break;
+        case 0x55:  // MATCH_ROM
+            dev->search_bit = 0;
+            dev->state = DEV_MATCH;
+            break;
+        case 0xCC:  // SKIP_ROM
+            dev->state = DEV_FUNC_CMD;
+            break;
+        case 0xF0:  // SEARCH_ROM
+            dev->search_bit = 0;
+            dev->search_phase = 0;
+            dev->state = DEV_SEARCH;
+            break;
+        default:
+            dev->state = DEV_IDLE;
+            break;
+        }
+        break;
+
+    case DEV_MATCH:
+        rom_bit = (dev->rom[dev->search_bit / 8] >> (dev->search_bit % 8)) & 0x01;
+        if (rom_bit != bit) {
+            dev->state = DEV_IDLE;
+        } else if (++dev->search_bit == 64) {
+            dev->state = DEV_FUNC_CMD;
+        }
+        break;
+
+    case DEV_SEARCH:
+        if (dev->search_phase < 2) {
+            dev->search_phase++;
+            break;
+        }
+        rom_bit = (dev->rom[dev->search_bit / 8] >> (dev->search_bit % 8)) & 0x01;
+        dev->search_phase = 0;
+        if (rom_bit != bit) {
+            dev->state = DEV_IDLE;
+        } else if (++dev->search_bit == 64) {
+            dev->state = DEV_FUNC_CMD;
+        }
+        break;
+
+    case DEV_FUNC_CMD:
+        if (dev_rx_bit(dev, bit)) {
+            dev_function(dev, dev->rx_byte);
+        }
+        break;
+
+    case DEV_TX:
+        if (++dev->tx_pos >= dev->tx_bits) {
+            dev->state = dev->next_state;
+        }
+        break;
+
+    case DEV_WRITE_SP:
+        if (!dev_rx_bit(dev, bit)) {
+            break;
+        }
+        if (dev->rx_count < 2) {
+            dev->scratchpad[2 + dev->rx_count] = dev->rx_byte;
+        } else {
+            dev->scratchpad[4] = (uint8_t)((dev->rx_byte & 0x60) | 0x1F);
+            dev->state = DEV_IDLE;
+        }
+        dev->rx_count++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// 总线回到高电平的时刻: 主机和已开始拉低的器件都释放后再经过上升时间
+static uint64_t sim_line_high_ns(void)
+{
+    uint64_t high_ns = sim_release_ns + sim_rise_ns;
+
+    for (int i = 0; i < sim_device_count; i++) {
+        const ow_sim_device_t *dev = &sim_devices[i];
+
+        if (dev->drive_from_ns <= sim_now_ns && dev->drive_until_ns != 0 &&
+            dev->drive_until_ns + sim_rise_ns > high_ns && dev_online(dev)) {
+            high_ns = dev->drive_until_ns + sim_rise_ns;
+        }
+    }
+    return high_ns;
+}
+
+// 主机拉低总线
+static void sim_fall(void)
+{
+    // 恢复时间不足: 总线还没回到高电平，器件不把这次拉低当作新时隙
+    sim_fall_missed = (sim_now_ns < sim_line_high_ns());
+    sim_fall_ns = sim_now_ns;
+    if (sim_fall_missed) {
+        return;
+    }
+
+    for (int i = 0; i < sim_device_count; i++) {
+        ow_sim_device_t *dev = &sim_devices[i];
+        uint8_t bit;
+
+        if (!dev_online(dev)) {
+            continue;
+        }
+        dev_sync(dev);
+        bit = dev_tx_bit(dev);
+        if (bit == 0) {
+            dev->drive_from_ns = sim_fall_ns;
+            dev->drive_until_ns = sim_fall_ns + sim_hold_ns;
+        }
+    }
+}
+
+// 主机释放总线
+static void sim_release(void)
+{
+    uint64_t low_ns = sim_now_ns - sim_fall_ns;
+    uint64_t sample_ns = sim_fall_ns + OW_SIM_SAMPLE_NS;
+    uint8_t bit = 1;
+
+    sim_release_ns = sim_now_ns;
+
+    if (low_ns < OW_SIM_GLITCH_NS) {
+        // 毛刺，撤销器件在下降沿做出的驱动决定
+        for (int i = 0; i < sim_device_count; i++) {
+            if (sim_devices[i].drive_from_ns == sim_fall_ns) {
+                sim_devices[i].drive_until_ns = 0;
+            }
+        }
+        return;
+    }
+
+    if (low_ns >= OW_SIM_RESET_NS) {
+        uint8_t miss = sim_chance(sim_faults.presence_miss_ppm);
+
+        if (miss) {
+            sim_fault_counts.presence_misses++;
+        }
+        for (int i = 0; i < sim_device_count; i++) {
+            ow_sim_device_t *dev = &sim_devices[i];
+
+            dev->drive_until_ns = 0;
+            if (!dev_online(dev)) {
+                dev->state = DEV_IDLE;
+                continue;
+            }
+            dev_sync(dev);
+            dev->state = DEV_ROM_CMD;
+            dev->rx_bits = 0;
+            if (!miss) {
+                dev->drive_from_ns = sim_now_ns + OW_SIM_PRESENCE_WAIT_NS;
+                dev->drive_until_ns = dev->drive_from_ns + OW_SIM_PRESENCE_NS;
+            }
+        }
+        // 复位后总线被拉低一段时间，器件把长低电平当作复位
+        if (sim_chance(sim_faults.stuck_low_ppm)) {
+            sim_stuck_until_ns = sim_now_ns + sim_faults.stuck_low_ns;
+            sim_fault_counts.stuck_lows++;
+            for (int i = 0; i < sim_device_count; i++) {
+                sim_devices[i].state = DEV_IDLE;
+                sim_devices[i].drive_until_ns = 0;
+            }
+        }
+        return;
+    }
+
+    if (sim_fall_missed) {
+        return;
+    }
+
+    // 器件在采样点看到的电平
+    if (sim_fall_ns + low_ns + sim_rise_ns > sample_ns) {
+        bit = 0;
+    }
+    for (int i = 0; i < sim_device_count; i++) {
+        if (sim_devices[i].drive_from_ns <= sample_ns && sim_devices[i].drive_until_ns > sample_ns) {
+            bit = 0;
+        }
+    }
+    if (sim_stuck()) {
+        bit = 0;
+    } else if (sim_chance(sim_faults.bit_flip_ppm)) {
+        bit ^= 1;
+        sim_fault_counts.bit_flips++;
+    }
+
+    for (int i = 0; i < sim_device_count; i++) {
+        ow_sim_device_t *dev = &sim_devices[i];
+
+        if (!dev_online(dev)) {
+            continue;
+        }
+        // 通信中的器件掉线，之后的时隙不再应答
+        if (dev->state != DEV_IDLE && sim_chance(sim_faults.drop_ppm)) {
+            dev->offline_from_ns = sim_now_ns;
+            dev->offline_until_ns = sim_faults.drop_ns ? sim_now_ns + sim_faults.drop_ns : UINT64_MAX;
+            dev->state = DEV_IDLE;
+            dev->drive_until_ns = 0;
+            sim_fault_counts.drops++;
+            continue;
+        }
+        dev_slot(dev, bit);
+    }
+}
+
+// 根据端口模式和输出寄存器更新主机驱动状态
+static void sim_update_line(GPIO_TypeDef *GPIOx)
+{
+    uint8_t low;
+
+    if (GPIOx != &OwSim_GPIOB) {
+        return;
+    }
+
+    low = (GPIOx->OUT_MASK & OW_SIM_PIN) && !(GPIOx->ODR & OW_SIM_PIN);
+    if (low && !sim_master_low) {
+        sim_master_low = 1;
+        sim_fall();
+    } else if (!low && sim_master_low) {
+        sim_master_low = 0;
+        sim_release();
+    }
+}
+
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    if (GPIO_InitStruct->GPIO_Mode & 0x10) {
+        GPIOx->OUT_MASK |= GPIO_InitStruct->GPIO_Pin;
+    } else {
+        GPIOx->OUT_MASK &= ~(uint32_t)GPIO_InitStruct->GPIO_Pin;
+    }
+    sim_update_line(GPIOx);
+}
+
+void GPIO_SetBits(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR |= GPIO_Pin;
+    sim_update_line(GPIOx);
+}
+
+void GPIO_ResetBits(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    sim_update_line(GPIOx);
+}
+
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    uint8_t level = 1;
+
+    if (GPIOx != &OwSim_GPIOB || GPIO_Pin != OW_SIM_PIN) {
+        return 1;  // 按键等其他引脚保持未按下
+    }
+
+    if (sim_master_low || sim_stuck()) {
+        return 0;
+    }
+    if (sim_now_ns < sim_release_ns + sim_rise_ns) {
+        return 0;
+    }
+    for (int i = 0; i < sim_device_count; i++) {
+        if (sim_devices[i].drive_from_ns <= sim_now_ns && sim_devices[i].drive_until_ns != 0 &&
+            sim_devices[i].drive_until_ns + sim_rise_ns > sim_now_ns && dev_online(&sim_devices[i])) {
+            level = 0;
+            break;
+        }
+    }
+    // 读时隙采样时的噪声 (复位后的存在脉冲采样不在此列)
+    if (sim_now_ns - sim_fall_ns < OW_SIM_SLOT_NS && sim_chance(sim_faults.bit_flip_ppm)) {
+        level ^= 1;
+        sim_fault_counts.bit_flips++;
+    }
+    return level;
+}
+
+void FLASH_Unlock(void)
+{
+}
+
+void FLASH_Lock(void)
+{
+}
+
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address)
+{
+    if (Page_Address != OW_SIM_FLASH_BASE) {
+        return FLASH_ERROR_PG;
+    }
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    sim_now_ns += OW_SIM_FLASH_ERASE_NS;
+    return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+    if (Address < OW_SIM_FLASH_BASE || Address + 4 > OW_SIM_FLASH_BASE + OW_SIM_FLASH_SIZE) {
+        return FLASH_ERROR_PG;
+    }
+    memcpy(&sim_flash[Address - OW_SIM_FLASH_BASE], &Data, 4);
+    sim_now_ns += OW_SIM_FLASH_WORD_NS;
+    return FLASH_COMPLETE;
+}
+
+const void *OwSim_FlashPtr(uint32_t address)
+{
+    return &sim_flash[address - OW_SIM_FLASH_BASE];
+}
@@ -0,0 +1,95 @@
+#ifndef __OW_SIM_H
+#define __OW_SIM_H
+
+/**
+ * 时序精确的1-Wire总线仿真 (主机构建)
+ * 替代GPIO/Flash/延时HAL，按驱动实际的电平翻转和延时推进仿真时间，
+ * 总线上挂接的每个仿真DS18B20按时隙解码ROM/功能命令并应答
+ */
+
+#include <stdint.h>
+
+#define OW_SIM_MAX_DEVICES      64
+
+#define OW_SIM_FLASH_BASE       0x0803F000u
+#define OW_SIM_FLASH_SIZE       2048u
+
+// 仿真DS18B20
+typedef struct {
+    uint8_t rom[8];              // ROM码
+    int16_t temp_raw;            // 实际温度 (1/16°C)
+    uint8_t parasite;            // 寄生供电
+    uint8_t eeprom[3];           // TH, TL, 配置寄存器
+
+    // 以下为内部状态
+    uint8_t scratchpad[9];
+    int16_t conv_raw;            // 转换开始时采样的温度
+    uint8_t state;
+    uint8_t next_state;
+    uint8_t rx_byte;
+    uint8_t rx_bits;
+    uint8_t rx_count;
+    uint8_t tx_buf[9];
+    uint8_t tx_bits;
+    uint8_t tx_pos;
+    uint8_t search_bit;
+    uint8_t search_phase;
+    uint8_t conv_pending;
+    uint64_t busy_until_ns;      // 转换/复制EEPROM完成时间
+    uint64_t drive_from_ns;      // 本器件拉低总线的时间窗口
+    uint64_t drive_until_ns;
+    uint64_t offline_from_ns;    // 掉线时间窗口，窗口内不响应复位和时隙
+    uint64_t offline_until_ns;
+} ow_sim_device_t;
+
+// 故障注入配置，概率单位为百万分之一 (ppm)，0表示关闭
+typedef struct {
+    uint32_t bit_flip_ppm;       // 每个时隙接收方(主机读或器件采样)看到的位翻转
+    uint32_t presence_miss_ppm;  // 每次复位存在脉冲被干扰，主机看不到任何器件
+    uint32_t stuck_low_ppm;      // 每次复位后总线被拉低stuck_low_ns
+    uint32_t stuck_low_ns;
+    uint32_t drop_ppm;           // 每个时隙正在通信的器件掉线drop_ns (0为永久)
+    uint32_t drop_ns;
+    uint32_t slow_conv_ppm;      // 每次温度转换额外耗时slow_conv_ns
+    uint32_t slow_conv_ns;
+} ow_sim_faults_t;
+
+// 已注入的故障次数
+typedef struct {
+    uint32_t bit_flips;
+    uint32_t presence_misses;
+    uint32_t stuck_lows;
+    uint32_t drops;
+    uint32_t slow_convs;
+} ow_sim_fault_counts_t;
+
+// 清空总线、Flash和故障注入配置，仿真时间归零
+void OwSim_Reset(void);
+// 生成家族码0x28、序列号和CRC正确的ROM码
+void OwSim_MakeRom(uint32_t serial, uint8_t *rom);
+// 挂接一个器件，返回器件序号，失败返回-1
+int OwSim_AddDevice(const uint8_t *rom, int16_t temp_raw);
+int OwSim_DeviceCount(void);
+ow_sim_device_t *OwSim_Device(int index);
+
+// 仿真时间
+uint64_t OwSim_NowNs(void);
+void OwSim_AdvanceNs(uint64_t ns);
+
+// 总线电气参数
+void OwSim_SetTiming(uint32_t rise_ns, uint32_t hold_ns);
+
+// 周期性中断负载: 每period_ns触发一次、占用duration_ns的CPU (period为0时关闭)
+// 未屏蔽时在中断到期处拉长驱动的延时，屏蔽期间挂起到解除屏蔽
+void OwSim_SetIrqLoad(uint32_t period_ns, uint32_t duration_ns);
+
+// 故障注入: 配置按seed确定性地产生故障 (faults为NULL时关闭)，OwSim_Reset同时清除配置和计数
+void OwSim_SetFaults(const ow_sim_faults_t *faults, uint32_t seed);
+void OwSim_GetFaultCounts(ow_sim_fault_counts_t *counts);
+// 器件在[from_ns, until_ns)内掉线 (until_ns为UINT64_MAX时永久)
+void OwSim_SetDeviceOffline(int index, uint64_t from_ns, uint64_t until_ns);
+
+// 1-Wire CRC8 (与驱动算法相同)
+uint8_t OwSim_Crc8(const uint8_t *data, uint8_t length);
+
+#endif
@@ -0,0 +1,269 @@
+/**
+ * 按变化上报基准
+ * 用合成温度曲线驱动TempFilter和Publish (与RS485_task相同的调用顺序，每秒一个周期)，
+ * 比较每周期全量上报与按变化上报的上行字节数和链路唤醒次数，并在接收端解码上报帧，检查:
+ *   - 序号逐次加1
+ *   - 接收端持有的值与设备端当前发布值之差不超过死区
+ *   - 阶跃后接收端跟上新值的延迟
+ * 同时按RS485_task的方式在历史队列满时调用Publish_EncodeHistory，解码发出的批量帧，
+ * 与各周期实际发布的样本逐行比较 (行数、节拍、位置、温度)，并检查没有行被覆盖。
+ *
+ * 构建 (在仓库根目录):
+ *   gcc -std=gnu99 -O2 -Ihost/include -I. host/report_bench.c publish.c batch_frame.c temp_filter.c \
+ *       -o report_bench
+ *
+ * 用法:
+ *   report_bench [-t 秒] [-d 死区(1/16°C)] [-s 最长静默秒]
+ *
+ * 输出: 每个场景一行JSON (JSON Lines)
+ *   steady   温度恒定，读数在相邻两个LSB间抖动
+ *   diurnal  24小时周期±3°C的缓慢变化，叠加抖动
+ *   steps    diurnal上每10分钟轮流有一个位置阶跃+2°C并保持5分钟
+ */
+
+#include "publish.h"
+#include "temp_filter.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_PERIOD_MS     1000
+#define BENCH_STEP_EVERY_S  600
+#define BENCH_STEP_HOLD_S   300
+#define BENCH_STEP_RAW      32
+
+static TickType_t bench_tick = 0;
+
+TickType_t xTaskGetTickCount(void)
+{
+    return bench_tick;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    bench_tick += ticks;
+}
+
+// 接收端状态
+typedef struct {
+    int16_t raw[MAX_DS18B20_SENSORS];
+    uint8_t valid[MAX_DS18B20_SENSORS];
+    uint32_t last_seq;
+    uint32_t seq_errors;
+} bench_receiver_t;
+
+// 历史上传检查: 设备端各周期发布的样本 (按快照顺序)，与接收端解码出的行比较
+#define BENCH_HISTORY_ROWS  (PUBLISH_HISTORY_LEN + 1)
+
+typedef struct {
+    uint32_t tick[BENCH_HISTORY_ROWS];
+    uint32_t mask[BENCH_HISTORY_ROWS];
+    int16_t raw[BENCH_HISTORY_ROWS][MAX_DS18B20_SENSORS];
+    uint32_t head;                // 下一个待比较的行
+    uint32_t tail;                // 下一个写入的行
+    unsigned long frames;
+    unsigned long bytes;
+    unsigned long rows;
+    unsigned long errors;
+} bench_history_t;
+
+static void bench_on_history_row(void *ctx, uint32_t tick, uint32_t mask, const int16_t *raw)
+{
+    bench_history_t *h = ctx;
+    uint32_t r = h->head % BENCH_HISTORY_ROWS;
+
+    h->rows++;
+    if (h->head == h->tail || h->tick[r] != tick || h->mask[r] != mask) {
+        h->errors++;
+        return;
+    }
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if ((mask & (1UL << i)) && raw[i] != h->raw[r][i]) {
+            h->errors++;
+            break;
+        }
+    }
+    h->head++;
+}
+
+// 与RS485_task相同: 队列满时在本周期快照之前把全部行编码发出，接收端逐帧解码
+static void bench_drain_history(bench_history_t *h)
+{
+    uint8_t frame[PUBLISH_HISTORY_FRAME_MAX];
+    uint16_t len;
+
+    if (Publish_GetHistoryCount() < PUBLISH_HISTORY_LEN) return;
+    while ((len = Publish_EncodeHistory(frame, sizeof(frame))) > 0) {
+        h->frames++;
+        h->bytes += len;
+        if (BatchFrame_Decode(frame, len, bench_on_history_row, h) < 0) {
+            h->errors++;
+        }
+    }
+    if (h->head != h->tail) {
+        h->errors++;          // 队列中的行没有全部发出
+        h->head = h->tail;
+    }
+}
+
+static void bench_on_entry(void *ctx, uint32_t seq, uint32_t tick, uint8_t position, uint8_t flags, int16_t raw)
+{
+    bench_receiver_t *rx = ctx;
+
+    (void)tick;
+    (void)flags;
+    if (seq != rx->last_seq) {
+        if (seq != rx->last_seq + 1) {
+            rx->seq_errors++;
+        }
+        rx->last_seq = seq;
+    }
+    rx->raw[position] = raw;
+    rx->valid[position] = 1;
+}
+
+// 场景在第t秒、位置i的真实温度 (1/16°C)，不含抖动
+static int16_t bench_truth(int scenario, uint32_t t, uint8_t i)
+{
+    double base = 22.0 * 16 + i * 8;
+
+    if (scenario >= 1) {
+        base += 3.0 * 16 * sin(2.0 * M_PI * t / 86400.0 + i);
+    }
+    if (scenario == 2 && (t / BENCH_STEP_EVERY_S) % MAX_DS18B20_SENSORS == i &&
+        t % BENCH_STEP_EVERY_S < BENCH_STEP_HOLD_S) {
+        base += BENCH_STEP_RAW;
+    }
+    return (int16_t)lround(base);
+}
+
+static void run_scenario(int scenario, const char *name, uint32_t seconds, uint16_t deadband, uint32_t silence_s)
+{
+    static const ds18b20_stamp_t zero_stamp;
+    bench_receiver_t rx;
+    static bench_history_t hist;
+    uint8_t frame[PUBLISH_REPORT_FRAME_MAX];
+    int16_t published[MAX_DS18B20_SENSORS];
+    int16_t step_target[MAX_DS18B20_SENSORS];
+    uint32_t step_start[MAX_DS18B20_SENSORS];
+    unsigned long report_bytes = 0, full_bytes = 0, wakeups = 0, step_latency_max = 0, steps = 0;
+    int32_t max_err = 0;
+    publish_report_stats_t stats;
+
+    srand(1);
+    bench_tick = 0;
+    memset(&rx, 0, sizeof(rx));
+    memset(&hist, 0, sizeof(hist));
+    memset(step_start, 0, sizeof(step_start));
+    memset(published, 0, sizeof(published));
+    TempFilter_Init();
+    Publish_Init();
+    Publish_SetMaxSilence(silence_s * 1000);
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        Publish_SetDeadband(i, deadband);
+        step_target[i] = -32768;
+    }
+
+    for (uint32_t t = 0; t < seconds; t++) {
+        ds18b20_stamp_t stamp = zero_stamp;
+        uint32_t report;
+        uint32_t fresh = 0;
+        uint32_t row = hist.tail % BENCH_HISTORY_ROWS;
+
+        bench_tick = t * BENCH_PERIOD_MS;
+        bench_drain_history(&hist);
+        stamp.conv_start = bench_tick;
+        stamp.conv_done = bench_tick;
+        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+            int16_t truth = bench_truth(scenario, t, i);
+            int16_t filtered;
+
+            if (TempFilter_Update(i, (int16_t)(truth + rand() % 2), &filtered) == TEMP_FILTER_OK) {
+                Publish_Update(i, filtered, &stamp);
+                published[i] = filtered;
+                hist.raw[row][i] = filtered;
+                fresh |= 1UL << i;
+            }
+            // 阶跃开始: 记录目标值，接收端进入目标值的死区内时计为跟上
+            if (scenario == 2 && t > 0 && truth - bench_truth(scenario, t - 1, i) >= BENCH_STEP_RAW / 2) {
+                step_start[i] = t;
+                step_target[i] = truth;
+            }
+        }
+
+        report = Publish_Snapshot();
+        if (fresh != 0) {
+            hist.tick[row] = stamp.conv_done;
+            hist.mask[row] = fresh;
+            hist.tail++;
+        }
+        // 全量上报: 每个周期包含全部位置的同格式上报帧
+        full_bytes += BATCH_REPORT_HEADER_SIZE + BATCH_REPORT_ENTRY_SIZE * MAX_DS18B20_SENSORS + BATCH_FRAME_CRC_SIZE;
+        if (report != 0) {
+            uint16_t len = Publish_EncodeReport(frame, sizeof(frame));
+
+            if (BatchFrame_DecodeReport(frame, len, bench_on_entry, &rx) < 0) {
+                rx.seq_errors++;
+            }
+            report_bytes += len;
+            wakeups++;
+        }
+
+        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+            int32_t err = rx.valid[i] ? abs(published[i] - rx.raw[i]) : 0;
+
+            if (err > max_err) {
+                max_err = err;
+            }
+            if (step_target[i] != -32768 && rx.valid[i] && abs(rx.raw[i] - step_target[i]) <= deadband + 1) {
+                if (t - step_start[i] > step_latency_max) {
+                    step_latency_max = t - step_start[i];
+                }
+                step_target[i] = -32768;
+                steps++;
+            }
+        }
+    }
+
+    Publish_GetReportStats(&stats);
+    printf("{\"scenario\":\"%s\",\"positions\":%u,\"seconds\":%lu,\"deadband\":%u,\"silence_s\":%lu,"
+           "\"full_bytes\":%lu,\"full_wakeups\":%lu,\"report_bytes\":%lu,\"report_wakeups\":%lu,"
+           "\"bytes_ratio\":%.3f,\"entries\":%lu,\"candidates\":%lu,\"max_err_raw\":%ld,"
+           "\"steps\":%lu,\"step_latency_max_s\":%lu,\"seq\":%lu,\"seq_errors\":%lu,"
+           "\"history_frames\":%lu,\"history_bytes\":%lu,\"history_rows\":%lu,\"history_dropped\":%lu,"
+           "\"history_errors\":%lu}\n",
+           name, MAX_DS18B20_SENSORS, (unsigned long)seconds, deadband, (unsigned long)silence_s,
+           full_bytes, (unsigned long)seconds, report_bytes, wakeups,
+           (double)report_bytes / full_bytes, (unsigned long)stats.entries, (unsigned long)stats.candidates,
+           (long)max_err, steps, step_latency_max, (unsigned long)Publish_GetReportSeq(),
+           (unsigned long)rx.seq_errors, hist.frames, hist.bytes, hist.rows,
+           (unsigned long)Publish_GetHistoryDropped(), hist.errors);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = 86400;
+    uint16_t deadband = PUBLISH_DEADBAND_DEFAULT;
+    uint32_t silence_s = PUBLISH_MAX_SILENCE_MS / 1000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:d:s:")) != -1) {
+        switch (opt) {
+        case 't': seconds = (uint32_t)atol(optarg); break;
+        case 'd': deadband = (uint16_t)atoi(optarg); break;
+        case 's': silence_s = (uint32_t)atol(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-d deadband] [-s silence_s]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    run_scenario(0, "steady", seconds, deadband, silence_s);
+    run_scenario(1, "diurnal", seconds, deadband, silence_s);
+    run_scenario(2, "steps", seconds, deadband, silence_s);
+    return 0;
+}
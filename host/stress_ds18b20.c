@@ -0,0 +1,322 @@
+/**
+ * DS18B20驱动故障注入压力测试
+ * 在注入位翻转、存在脉冲丢失、总线拉低、器件掉线和转换变慢的仿真总线上运行ds18b20.c，
+ * 对两种读取策略测量有效吞吐量、浪费的总线时间和检测到传感器失效的时间，
+ * 用于按数据而不是凭经验调整重试和退避策略:
+ *   legacy - DS18B20_ReadAllTemperatures (逐个转换，DS18B20_ReadTemperature内重试3次，失败后标记不存在)
+ *   task   - RS485_task的周期读取: DS18B20_ReadPositions一次广播转换，读取成功即在线 (阻塞方式)
+ *   pipelined - 同task，但读取后立即发出下一次转换，读数为上一轮末发出的转换结果
+ *
+ * 构建 (在仓库根目录):
+ *   gcc -std=gnu99 -O2 -Ihost/include -Ihost -I. -DDS_LOG_LEVEL=0 \
+ *       host/stress_ds18b20.c host/ow_sim.c ds18b20.c ow_trace.c -o stress_ds18b20
+ *
+ * 用法:
+ *   stress_ds18b20 [-t 秒] [-n 传感器数]            运行内置的故障场景矩阵
+ *   stress_ds18b20 [-t 秒] [-n 传感器数] [-f 翻转ppm] [-p 存在丢失ppm] [-s 拉低ppm] [-d 掉线ppm]
+ *                  [-c 慢转换ppm] [-k 失效时刻秒]    运行单个自定义场景
+ *   -e 上升ns:保持ns    线缆电气参数 (默认1000:30000)，长线缆上初始化先校准时序
+ *
+ * 输出: 每个场景和策略一行JSON (JSON Lines)，字段:
+ *   good          值正确且为本轮转换结果的样本数 (pipelined为该读数所属转换发出时的温度)
+ *   stale         值为之前某一轮温度的样本数 (转换被跳过或未完成就读取)
+ *   corrupt       通过校验但值错误的样本数
+ *   missed        器件在线但未返回有效值的次数
+ *   goodput_sps   good / 仿真秒数
+ *   wasted_bus_pct 总线占用中超出无故障运行每样本开销的比例
+ *   detect_ms     -k指定的器件永久失效后，策略首次报告该位置无效的延迟 (-1为未检测到)
+ */
+
+#include "ow_sim.h"
+#include "ds18b20.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define STRESS_PERIOD_MS    1000    // RS485_task的读取周期
+#define STRESS_SEED         12345
+#define STRESS_STALE_CYCLES 16      // 与之前多少轮的温度相同时判为过期
+
+enum {
+    STRESS_POLICY_LEGACY = 0,
+    STRESS_POLICY_TASK,
+    STRESS_POLICY_PIPELINED,
+    STRESS_POLICY_COUNT
+};
+
+static const char *stress_policy_names[STRESS_POLICY_COUNT] = { "legacy", "task", "pipelined" };
+
+// 一个故障场景
+typedef struct {
+    const char *name;
+    ow_sim_faults_t faults;
+    int32_t kill_s;               // 器件0永久失效的时刻 (<0为不失效)
+} stress_scenario_t;
+
+// 一次运行的结果
+typedef struct {
+    uint32_t cycles;
+    uint32_t good, stale, corrupt, missed;
+    uint64_t sim_ns;
+    uint32_t busy_us;
+    int64_t detect_ms;
+    ow_sim_fault_counts_t injected;
+} stress_result_t;
+
+static const stress_scenario_t stress_scenarios[] = {
+    { "none",            { 0 },                                              -1 },
+    { "flip_100ppm",     { .bit_flip_ppm = 100 },                            -1 },
+    { "flip_1000ppm",    { .bit_flip_ppm = 1000 },                           -1 },
+    { "flip_10000ppm",   { .bit_flip_ppm = 10000 },                          -1 },
+    { "presence_1pct",   { .presence_miss_ppm = 10000 },                     -1 },
+    { "presence_10pct",  { .presence_miss_ppm = 100000 },                    -1 },
+    { "stuck_low_1pct",  { .stuck_low_ppm = 10000, .stuck_low_ns = 20000000 }, -1 },
+    { "drop_100ppm",     { .drop_ppm = 100, .drop_ns = 2000000000u },        -1 },
+    { "slow_conv_5pct",  { .slow_conv_ppm = 50000, .slow_conv_ns = 500000000u }, -1 },
+    { "slow_conv_20pct", { .slow_conv_ppm = 200000, .slow_conv_ns = 500000000u }, -1 },
+    { "kill",            { 0 },                                              30 },
+    { "kill_flip_1000ppm", { .bit_flip_ppm = 1000 },                         30 },
+};
+
+static FILE *stress_out;
+static uint32_t stress_rise_ns = 1000;    // 线缆电气参数
+static uint32_t stress_hold_ns = 30000;
+
+// 每轮开始前改变所有器件的温度，使上一轮的值可被识别为过期
+static int16_t stress_temp(uint32_t cycle, uint8_t i)
+{
+    return (int16_t)(20 * 16 + (int16_t)((cycle * 7 + i * 3) % 200));
+}
+
+// 保存配置后走一遍初始化 (检测供电方式并发出启动转换)，器件温度已是第0轮的值
+static void stress_setup(uint8_t sensors, uint8_t policy)
+{
+    uint8_t rom[8];
+
+    OwSim_Reset();
+    OwSim_SetTiming(stress_rise_ns, stress_hold_ns);
+    memset(ds18b20_devices, 0, sizeof(ds18b20_devices));
+    for (uint8_t i = 0; i < sensors; i++) {
+        OwSim_MakeRom(0x2000u + i * 0x51u, rom);
+        OwSim_AddDevice(rom, stress_temp(0, i));
+        memcpy(ds18b20_devices[i].rom_code, rom, 8);
+        ds18b20_devices[i].present = 1;
+    }
+    DS18B20_SaveConfig();
+    DS18B20_SetPipelined(policy == STRESS_POLICY_PIPELINED);
+    DS18B20_Init();
+    DS18B20_ResetStats();
+}
+
+// 按策略给出的结果分类一个样本
+static void stress_classify(stress_result_t *res, uint32_t cycle, uint8_t i, uint8_t ok, int16_t raw,
+                            uint8_t dead)
+{
+    if (dead) {
+        return;
+    }
+    if (!ok) {
+        res->missed++;
+    } else if (raw == stress_temp(cycle, i)) {
+        res->good++;
+    } else {
+        // 转换被跳过或未完成时读到的是之前某一轮的温度
+        for (uint32_t back = 1; back <= STRESS_STALE_CYCLES && back <= cycle; back++) {
+            if (raw == stress_temp(cycle - back, i)) {
+                res->stale++;
+                return;
+            }
+        }
+        res->corrupt++;
+    }
+}
+
+static void stress_run(const stress_scenario_t *sc, uint8_t policy, uint8_t sensors, uint32_t duration_s,
+                       stress_result_t *res)
+{
+    uint64_t end_ns = (uint64_t)duration_s * 1000000000ull;
+    uint64_t kill_ns = (sc->kill_s >= 0) ? (uint64_t)sc->kill_s * 1000000000ull : UINT64_MAX;
+    ow_stats_t stats;
+
+    memset(res, 0, sizeof(*res));
+    res->detect_ms = -1;
+    stress_setup(sensors, policy);
+    OwSim_SetFaults(&sc->faults, STRESS_SEED);
+    if (sc->kill_s >= 0) {
+        OwSim_SetDeviceOffline(0, kill_ns, UINT64_MAX);
+    }
+
+    while (OwSim_NowNs() < end_ns) {
+        uint64_t start_ns = OwSim_NowNs();
+        uint32_t cycle = res->cycles;
+        uint32_t expect = cycle;
+        uint8_t ok[MAX_DS18B20_SENSORS];
+        int16_t raw[MAX_DS18B20_SENSORS];
+
+        for (uint8_t i = 0; i < sensors; i++) {
+            OwSim_Device(i)->temp_raw = stress_temp(cycle, i);
+        }
+
+        if (policy == STRESS_POLICY_LEGACY) {
+            float temperatures[MAX_DS18B20_SENSORS];
+
+            DS18B20_ReadAllTemperatures(temperatures);
+            for (uint8_t i = 0; i < sensors; i++) {
+                ok[i] = temperatures[i] > -999.0f;
+                raw[i] = (int16_t)(temperatures[i] * 16.0f);
+            }
+        } else {
+            ds18b20_stamp_t stamp;
+            ds18b20_mask_t valid = DS18B20_ReadPositions(DS18B20_MASK_ALL, raw, &stamp);
+            for (uint8_t i = 0; i < sensors; i++) {
+                ok[i] = (valid & DS18B20_MASK_BIT(i)) != 0;
+            }
+            // 转换在本轮开始前发出 (上一轮末预发) 时，读数应为上一轮的温度
+            if (cycle > 0 && (int32_t)(stamp.conv_start - (uint32_t)(start_ns / 1000000u)) < 0) {
+                expect = cycle - 1;
+            }
+            // 总线任务在两次读取之间推进时序维护 (复核、重新检测、分步校准)
+            while (DS18B20_TimingStep()) {
+            }
+        }
+
+        for (uint8_t i = 0; i < sensors; i++) {
+            stress_classify(res, expect, i, ok[i], raw[i], i == 0 && start_ns >= kill_ns);
+        }
+        // 失效后首次报告无效的时刻
+        if (res->detect_ms < 0 && OwSim_NowNs() > kill_ns && !ok[0]) {
+            res->detect_ms = (int64_t)((OwSim_NowNs() - kill_ns) / 1000000u);
+        }
+        res->cycles++;
+
+        // 按周期等待下一轮 (读取本身超过周期时立即开始)
+        if (OwSim_NowNs() - start_ns < STRESS_PERIOD_MS * 1000000ull) {
+            OwSim_AdvanceNs(start_ns + STRESS_PERIOD_MS * 1000000ull - OwSim_NowNs());
+        }
+    }
+
+    DS18B20_GetStats(&stats);
+    res->busy_us = stats.busy_us;
+    res->sim_ns = OwSim_NowNs();
+    OwSim_GetFaultCounts(&res->injected);
+}
+
+static void stress_report(const stress_scenario_t *sc, uint8_t policy, uint8_t sensors,
+                          const stress_result_t *res, double clean_us_per_good)
+{
+    double sim_s = res->sim_ns / 1e9;
+    double wasted_pct = 0.0;
+
+    if (res->busy_us > 0) {
+        wasted_pct = 100.0 * (res->busy_us - res->good * clean_us_per_good) / res->busy_us;
+        if (wasted_pct < 0.0) {
+            wasted_pct = 0.0;
+        }
+    }
+
+    fprintf(stress_out,
+            "{\"scenario\":\"%s\",\"policy\":\"%s\",\"sensors\":%u,\"sim_s\":%.1f,\"cycles\":%lu,"
+            "\"good\":%lu,\"stale\":%lu,\"corrupt\":%lu,\"missed\":%lu,\"goodput_sps\":%.3f,"
+            "\"bus_busy_ms\":%lu,\"wasted_bus_pct\":%.1f,\"detect_ms\":%lld,"
+            "\"injected\":{\"bit_flips\":%lu,\"presence_misses\":%lu,\"stuck_lows\":%lu,\"drops\":%lu,"
+            "\"slow_convs\":%lu}}\n",
+            sc->name, stress_policy_names[policy], sensors, sim_s, (unsigned long)res->cycles,
+            (unsigned long)res->good, (unsigned long)res->stale, (unsigned long)res->corrupt,
+            (unsigned long)res->missed, res->good / sim_s,
+            (unsigned long)(res->busy_us / 1000), wasted_pct, (long long)res->detect_ms,
+            (unsigned long)res->injected.bit_flips, (unsigned long)res->injected.presence_misses,
+            (unsigned long)res->injected.stuck_lows, (unsigned long)res->injected.drops,
+            (unsigned long)res->injected.slow_convs);
+    fflush(stress_out);
+}
+
+static void stress_scenario(const stress_scenario_t *sc, uint8_t sensors, uint32_t duration_s,
+                            const double *clean_us_per_good)
+{
+    for (uint8_t policy = 0; policy < STRESS_POLICY_COUNT; policy++) {
+        stress_result_t res;
+
+        stress_run(sc, policy, sensors, duration_s, &res);
+        stress_report(sc, policy, sensors, &res, clean_us_per_good[policy]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    stress_scenario_t custom = { "custom", { 0 }, -1 };
+    static const stress_scenario_t clean = { "none", { 0 }, -1 };
+    double clean_us_per_good[STRESS_POLICY_COUNT];
+    uint32_t duration_s = 300;
+    int sensors = MAX_DS18B20_SENSORS;
+    int use_custom = 0;
+    int out_fd;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:f:p:s:d:c:k:e:")) != -1) {
+        switch (opt) {
+        case 't': duration_s = (uint32_t)atoi(optarg); break;
+        case 'n': sensors = atoi(optarg); break;
+        case 'f': custom.faults.bit_flip_ppm = (uint32_t)atoi(optarg); use_custom = 1; break;
+        case 'p': custom.faults.presence_miss_ppm = (uint32_t)atoi(optarg); use_custom = 1; break;
+        case 's':
+            custom.faults.stuck_low_ppm = (uint32_t)atoi(optarg);
+            custom.faults.stuck_low_ns = 20000000u;
+            use_custom = 1;
+            break;
+        case 'd':
+            custom.faults.drop_ppm = (uint32_t)atoi(optarg);
+            custom.faults.drop_ns = 2000000000u;
+            use_custom = 1;
+            break;
+        case 'c':
+            custom.faults.slow_conv_ppm = (uint32_t)atoi(optarg);
+            custom.faults.slow_conv_ns = 500000000u;
+            use_custom = 1;
+            break;
+        case 'k': custom.kill_s = atoi(optarg); use_custom = 1; break;
+        case 'e':
+            if (sscanf(optarg, "%u:%u", &stress_rise_ns, &stress_hold_ns) != 2) {
+                fprintf(stderr, "bad -e, expected rise_ns:hold_ns\n");
+                return 2;
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-t seconds] [-n sensors] [-f ppm] [-p ppm] [-s ppm] [-d ppm] [-c ppm] [-k seconds] [-e rise_ns:hold_ns]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (sensors < 1 || sensors > MAX_DS18B20_SENSORS || duration_s == 0) {
+        fprintf(stderr, "bad arguments\n");
+        return 2;
+    }
+
+    // 驱动的printf输出丢弃，结果写到原stdout
+    out_fd = dup(STDOUT_FILENO);
+    stress_out = fdopen(out_fd, "w");
+    if (stress_out == NULL || !freopen("/dev/null", "w", stdout)) {
+        perror("stdout");
+        return 1;
+    }
+
+    // 无故障运行的每样本总线开销，作为浪费时间的基准
+    for (uint8_t policy = 0; policy < STRESS_POLICY_COUNT; policy++) {
+        stress_result_t res;
+
+        stress_run(&clean, policy, (uint8_t)sensors, duration_s < 60 ? duration_s : 60, &res);
+        clean_us_per_good[policy] = res.good ? (double)res.busy_us / res.good : 0.0;
+    }
+
+    if (use_custom) {
+        stress_scenario(&custom, (uint8_t)sensors, duration_s, clean_us_per_good);
+    } else {
+        for (size_t i = 0; i < sizeof(stress_scenarios) / sizeof(stress_scenarios[0]); i++) {
+            stress_scenario(&stress_scenarios[i], (uint8_t)sensors, duration_s, clean_us_per_good);
+        }
+    }
+
+    fclose(stress_out);
+    return 0;
+}
@@ -2,17 +2,34 @@
 #include "..\\main.h"
 #include "mycommon.h"
 #include "ds18b20.h"
+#include "ds_log.h"
+#include "diag.h"
+#include "temp_filter.h"
+#include "ds18b20_bus.h"
+#include "publish.h"
+#include "cfg_rx.h"
+#include "rtos_alloc.h"
+
+#define RS485_BUS_TIMEOUT   3000    // 等待总线任务完成一次读取或一轮调试的最长时间
+#define RS485_BUS_INIT_TIMEOUT 20000 // 等待初始化的最长时间 (首次启动含时序校准)
+// USART2(RS485)发送方向切换，由板级定义 (自动收发切换的转换器不需要)
+#ifndef RS485_TX_BEGIN
+#define RS485_TX_BEGIN()
+#endif
+#ifndef RS485_TX_END
+#define RS485_TX_END()
+#endif
 // Main function
 int main(void) {
     HardWare_Init();
     SoftWare_Init();
     // Create start task
-    xTaskCreate((TaskFunction_t)start_task,
-                "start_task",
-                START_STK_SIZE,
-                NULL,
-                START_TASK_PRIO,
-                &StartTask_Handler);
+    RtosAlloc_TaskCreate((TaskFunction_t)start_task,
+                         "start_task",
+                         START_STK_SIZE,
+                         NULL,
+                         START_TASK_PRIO,
+                         &StartTask_Handler);
     
     vTaskStartScheduler();
     
@@ -21,46 +38,66 @@ int main(void) {
 
 void start_task(void* pvParameters) {
     taskENTER_CRITICAL();
-    // 创建信号量（动态分配，使用 xSemaphoreCreateBinary）
-    RS485_RECEIVE_DATA = xSemaphoreCreateBinary();
+    // 创建信号量（RTOS_STATIC_ALLOC时静态分配）
+    RS485_RECEIVE_DATA = RtosAlloc_SemaphoreCreateBinary();
     if (RS485_RECEIVE_DATA == NULL)
         printf("RS485_RECEIVE_DATA create Err!\r\n");
 
-    // 创建任务（使用 xTaskCreate）
-    xTaskCreate((TaskFunction_t)USART1_Config_task,
-                (const char*)"USART1_Config_task",
-                (uint16_t)USART1_Receive_STK_SIZE,
-                (void*)NULL,
-                (UBaseType_t)USART1_Receive_TASK_PRIO,
-                (TaskHandle_t*)&USART1_Receive_Handler);
-			
-		xTaskCreate((TaskFunction_t)watchdog_task,
-								(const char*)"watchdog_task",
-								(uint16_t)64,
-								(void*)NULL,
-								(UBaseType_t)1,
-								(TaskHandle_t*)NULL);
-
-    xTaskCreate((TaskFunction_t)LED_task,
-                (const char*)"LED_task",
-                (uint16_t)LED_STK_SIZE,
-                (void*)NULL,
-                (UBaseType_t)LED_TASK_PRIO,
-                (TaskHandle_t*)&LED_Handler);
-
-    xTaskCreate((TaskFunction_t)RS485_task,
-                (const char*)"RS485_task",
-                (uint16_t)RS485_STK_SIZE,
-                (void*)NULL,
-                (UBaseType_t)RS485_TASK_PRIO,
-                (TaskHandle_t*)&RS485_Handler);
+    // 初始化延迟日志的DMA输出和配置口DMA接收
+    DS_Log_Init();
+    CfgRx_Init(USART1_RECEIVE_DATA);
+    // 创建1-Wire总线请求队列
+    DS18B20_Bus_Init();
+
+    // 创建任务（登记后可用STACKS命令查看栈水位）
+    RtosAlloc_TaskCreate((TaskFunction_t)USART1_Config_task,
+                         (const char*)"USART1_Config_task",
+                         (uint16_t)USART1_Receive_STK_SIZE,
+                         (void*)NULL,
+                         (UBaseType_t)USART1_Receive_TASK_PRIO,
+                         (TaskHandle_t*)&USART1_Receive_Handler);
+
+    RtosAlloc_TaskCreate((TaskFunction_t)watchdog_task,
+                         (const char*)"watchdog_task",
+                         (uint16_t)WATCHDOG_STK_SIZE,
+                         (void*)NULL,
+                         (UBaseType_t)1,
+                         (TaskHandle_t*)NULL);
+
+    RtosAlloc_TaskCreate((TaskFunction_t)LED_task,
+                         (const char*)"LED_task",
+                         (uint16_t)LED_STK_SIZE,
+                         (void*)NULL,
+                         (UBaseType_t)LED_TASK_PRIO,
+                         (TaskHandle_t*)&LED_Handler);
+
+    RtosAlloc_TaskCreate((TaskFunction_t)RS485_task,
+                         (const char*)"RS485_task",
+                         (uint16_t)RS485_STK_SIZE,
+                         (void*)NULL,
+                         (UBaseType_t)RS485_TASK_PRIO,
+                         (TaskHandle_t*)&RS485_Handler);
+
+    RtosAlloc_TaskCreate((TaskFunction_t)DS18B20_Bus_Task,
+                         (const char*)"ow_bus_task",
+                         (uint16_t)DS18B20_BUS_STK_SIZE,
+                         (void*)NULL,
+                         (UBaseType_t)DS18B20_BUS_TASK_PRIO,
+                         (TaskHandle_t*)NULL);
+
+    RtosAlloc_TaskCreate((TaskFunction_t)DS_Log_Task,
+                         (const char*)"log_task",
+                         (uint16_t)DS_LOG_STK_SIZE,
+                         (void*)NULL,
+                         (UBaseType_t)DS_LOG_TASK_PRIO,
+                         (TaskHandle_t*)NULL);
 
     // 启用 UART 中断
     USART_ITConfig(USART1, USART_IT_IDLE, ENABLE);
     taskEXIT_CRITICAL();
 
-    // 删除自身任务
-    vTaskDelete(StartTask_Handler);
+    // 删除自身任务 (静态分配时其栈不回收)
+    RtosAlloc_TaskDelete(StartTask_Handler);
 }
 
 // 在 FreeRTOS 中创建一个低优先级任务专门喂狗
@@ -72,7 +109,9 @@ void watchdog_task(void* pvParameters) {
 }
 
 void LED_task(void* pvParameters) {
+    DS_Log_TxLock();
     printf("LED_task Start......\r\n");
+    DS_Log_TxUnlock();
     uint8_t led_state = 0;
     if (Communication_mode_Switch) {
         LAN_LED_set(1);
@@ -93,130 +132,267 @@ void LED_task(void* pvParameters) {
     }
 }
 
+// 以下函数由总线任务执行，RS485_task只提交请求并等待完成通知
+static volatile uint8_t rs485_learning = 0;    // 加热刺激调试进行中 (总线任务写入)
+static volatile uint8_t rs485_remapped = 0;    // 位置映射已改变，需要丢弃滤波历史 (总线任务写入)
+static void (*volatile rs485_call_fn)(void) = NULL; // 已提交、尚未执行完的调用 (同时只有一个)
+
+static void rs485_log_sensor_count(void) {
+    uint8_t sensor_count = 0;
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (ds18b20_devices[i].present) {
+            sensor_count++;
+        }
+    }
+    DS_LOG_INFO(LOG_EVT_SENSOR_COUNT, sensor_count, 0, 0);
+}
+
+static void rs485_bus_init(void) {
+    DS18B20_Init();
+    rs485_log_sensor_count();
+}
+
+// 学习结束: 切换回正常模式，为了安全起见重新初始化
+static void rs485_learning_finish(void) {
+    DS_LOG_INFO(LOG_EVT_LEARN_COMPLETE, 0, 0, 0);
+    DS18B20_SetConfigMode(CONFIG_MODE_NORMAL);
+    DS18B20_Init();
+    rs485_learning = 0;
+    rs485_remapped = 1;
+    DS_LOG_INFO(LOG_EVT_NORMAL_MODE, 0, 0, 0);
+    rs485_log_sensor_count();
+}
+
+// 批量调试开始: 一次搜索并建立基线，之后每个周期提交一轮检测
+static void rs485_bus_learning_begin(void) {
+    if (DS18B20_StimulusBegin() > 0) {
+        rs485_learning = 1;
+        rs485_remapped = 1;
+    } else {
+        rs485_learning_finish();
+    }
+}
+
+// 一轮加热刺激检测 (一次转换)，轮与轮之间总线任务照常处理读取请求
+static void rs485_bus_learning_step(void) {
+    uint8_t status;
+
+    if (!rs485_learning) {
+        return;
+    }
+    status = DS18B20_StimulusStep();
+    if (status == DS18B20_STIMULUS_MAPPED) {
+        rs485_remapped = 1;
+    } else if (status == DS18B20_STIMULUS_DONE) {
+        rs485_learning_finish();
+    }
+}
+
+static void rs485_bus_commission(void) {
+    DS18B20_CommissionFromTable();
+    rs485_remapped = 1;
+}
+
+static void rs485_bus_call(void *ctx) {
+    rs485_call_fn();
+    rs485_call_fn = NULL;
+}
+
+// 在总线任务中执行fn并等待完成，等待有上限: 超时记录日志后继续，请求稍后仍会执行，
+// 执行结果由上面的标志传回。上一次的调用尚未执行完时不提交，返回0
+static uint8_t rs485_bus_run(void (*fn)(void), TickType_t timeout) {
+    uint32_t tag;
+
+    if (rs485_call_fn != NULL) {
+        return 0;
+    }
+    rs485_call_fn = fn;
+    tag = DS18B20_Bus_Call(rs485_bus_call, NULL, DS18B20_PRIO_NORMAL, xTaskGetCurrentTaskHandle());
+    if (tag == 0) {
+        rs485_call_fn = NULL;
+        return 0;
+    }
+    if (!DS18B20_Bus_Wait(tag, timeout)) {
+        DS_LOG_WARN(LOG_EVT_BUS_TIMEOUT, timeout, 0, 0);
+    }
+    return 1;
+}
+
+// 从USART2发出一帧 (轮询发送): 先等上一帧发完，最后一个字节移出后才切回接收
+static void rs485_send_frame(const uint8_t *frame, uint16_t len) {
+    while (USART_GetFlagStatus(USART2, USART_FLAG_TC) == RESET);
+    RS485_TX_BEGIN();
+    for (uint16_t i = 0; i < len; i++) {
+        while (USART_GetFlagStatus(USART2, USART_FLAG_TXE) == RESET);
+        USART_SendData(USART2, frame[i]);
+    }
+    while (USART_GetFlagStatus(USART2, USART_FLAG_TC) == RESET);
+    RS485_TX_END();
+}
+
+// 最近一次上报 (上一周期快照选出的位置) 编码为上报帧从USART2发出
+static void rs485_send_report(void) {
+    static uint8_t frame[PUBLISH_REPORT_FRAME_MAX];
+    uint16_t len = Publish_EncodeReport(frame, sizeof(frame));
+
+    if (len > 0) {
+        rs485_send_frame(frame, len);
+    }
+}
+
+// 历史队列已满: 全部行编码为批量帧从USART2发出 (一帧放不下时分多帧)
+static void rs485_send_history(void) {
+    static uint8_t frame[PUBLISH_HISTORY_FRAME_MAX];
+    uint16_t len;
+
+    while ((len = Publish_EncodeHistory(frame, sizeof(frame))) > 0) {
+        rs485_send_frame(frame, len);
+    }
+}
+
 void RS485_task(void* pvParameters) {
     BaseType_t err = pdFALSE;
     uint8_t button_pressed = 0;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    static ds18b20_bus_result_t bus_result; // 总线任务写入的读取结果
+    ds18b20_mask_t valid;                   // 本轮读取成功的位置
+    float uploaded_points[MAX_DS18B20_SENSORS]; // 上次上传的温度点
+    uint8_t learn_start;                    // 学习模式下尚未提交调试开始
+    DS_Log_TxLock();
     printf("RS485_task Start......\r\n");
-    float temperatures[MAX_DS18B20_SENSORS] = {0}; // 存储5个温度点的数据
+    DS_Log_TxUnlock();
+    int16_t filtered;
+    uint32_t report;
+    uint8_t upload_pending = 0;         // 上一周期有位置需要上报
   
+    TempFilter_Init();
+    Publish_Init();
     // 初始化DS18B20系统
-    DS18B20_Init();
+    rs485_bus_run(rs485_bus_init, RS485_BUS_INIT_TIMEOUT);
     
     // 检查是否处于学习模式（可以通过按键触发）
     if (GPIO_ReadInputDataBit(BUTTON_GPIO, BUTTON_PIN) == 0) { //PB6连接了按键
         button_pressed = 1;
-        printf("Button pressed at startup, entering learning mode...\r\n");
+        DS_LOG_INFO(LOG_EVT_LEARN_BUTTON_BOOT, 0, 0, 0);
         DS18B20_SetConfigMode(CONFIG_MODE_LEARNING);
     }
     
-    // 如果在学习模式，引导用户进行传感器学习
-    if (DS18B20_GetConfigMode() == CONFIG_MODE_LEARNING) {
-        printf("*** DS18B20 LEARNING MODE ***\r\n");
-        printf("Please connect sensors one by one when prompted\r\n");
-        
-        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-            printf("\r\nConnect ONLY the sensor for position %d, then press button\r\n", i+1);
-            
-            // 等待用户按下按键
-            while (GPIO_ReadInputDataBit(BUTTON_GPIO, BUTTON_PIN) != 0) {
-                vTaskDelay(100);
-            }
-            
-            // 等待按键释放
-            while (GPIO_ReadInputDataBit(BUTTON_GPIO, BUTTON_PIN) == 0) {
-                vTaskDelay(100);
-            }
-            
-            // 学习当前位置的传感器
-            DS18B20_LearnSensor(i);
-            
-            printf("Please disconnect the sensor before continuing\r\n");
-            vTaskDelay(2000);
-        }
-        
-        // 学习完成，保存配置
-        DS18B20_SaveConfig();
-        printf("Learning complete! System will now restart in normal mode\r\n");
-        
-        // 切换回正常模式
-        DS18B20_SetConfigMode(CONFIG_MODE_NORMAL);
-        
-        // 为了安全起见，重新初始化
-        DS18B20_Init();
-    }
-    
-    // 正常运行模式下，检查传感器状态并打印配置
-    printf("Running in normal mode\r\n");
-    uint8_t sensor_count = 0;
-    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-        if (ds18b20_devices[i].present) {
-            sensor_count++;
-        }
+    // 如果在学习模式，所有传感器同时接入，一次搜索后按加热刺激依次映射位置；
+    // 之后每个周期提交一轮检测，已映射的位置照常读取和上报
+    learn_start = (DS18B20_GetConfigMode() == CONFIG_MODE_LEARNING);
+    if (learn_start) {
+        DS_LOG_INFO(LOG_EVT_LEARN_MODE, 0, 0, 0);
+    } else {
+        DS_LOG_INFO(LOG_EVT_NORMAL_MODE, 0, 0, 0);
     }
-    printf("Found %d configured DS18B20 sensors\r\n", sensor_count);
     
-    // 设置所有存在的传感器为最高精度(12位)
-    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-        if (ds18b20_devices[i].present) {
-            DS18B20_SetResolution(i, 3);
-        }
-    }
+    // 分辨率已保存在传感器EEPROM中，由DS18B20_Init校验，不一致时才重写
     
     while (1) {
+        // 学习模式: 每个周期一轮加热刺激检测 (初始化超时未完成时等其完成后再开始)
+        if (learn_start) {
+            learn_start = !rs485_bus_run(rs485_bus_learning_begin, RS485_BUS_TIMEOUT);
+        } else if (rs485_learning) {
+            rs485_bus_run(rs485_bus_learning_step, RS485_BUS_TIMEOUT);
+        }
+        
         if (RS485_SEND_DATA != NULL) {
             err = xSemaphoreTake(RS485_SEND_DATA, (TickType_t)1000);
             if (err == pdTRUE) {
-                USART2_Send_Read_sensor();//modbus-rtu
+                // 按变化上报: 只有上一周期有位置超出死区或静默超时才唤醒上行链路
+                if (upload_pending) {
+                    USART2_Send_Read_sensor();//modbus-rtu
+                    rs485_send_report();     // 紧随其后发出带序号和变化/静默标志的上报帧
+                    Publish_RecordUpload();  // 按上传时刻统计样本年龄
+                    upload_pending = 0;
+                }
+                // 历史队列已满，在本周期快照覆盖最旧的行之前批量上传
+                if (Publish_GetHistoryCount() >= PUBLISH_HISTORY_LEN) {
+                    rs485_send_history();
+                }
                 
-                // 周期性检查所有传感器状态
-                for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-                    if (DS18B20_CheckSensorPresent(i)) {
-                        ds18b20_devices[i].present = 1;
-                    }
+                // 配置口下发了位置-ROM映射表，执行批量调试
+                if (DS18B20_CommissionPending()) {
+                    rs485_bus_run(rs485_bus_commission, RS485_BUS_TIMEOUT);
                 }
                 
-                // 读取所有当前连接的传感器温度
-                DS18B20_ReadAllTemperatures(temperatures);
+                // 读取所有已配置位置 (一次广播转换，读取成功即视为在线)
+                // 提交失败或超时时本轮不更新任何位置，保持之前的有效值
+                // 超时的请求仍会在稍后写入bus_result，本轮不再访问它
+                valid = 0;
+                if (DS18B20_Bus_Wait(DS18B20_Bus_Read(DS18B20_MASK_ALL, &bus_result, self), RS485_BUS_TIMEOUT)) {
+                    valid = bus_result.valid;
+                }
+                // 调试改变了位置映射 (在本次读取之前执行)，位置可能对应了新的传感器，丢弃滤波历史
+                if (rs485_remapped) {
+                    rs485_remapped = 0;
+                    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+                        TempFilter_Reset(i);
+                    }
+                }
                 
-                // 定义一个函数指针数组，指向所有温度点变量的地址
-                float* temp_points[MAX_DS18B20_SENSORS] = {
+                // 指向所有温度点变量的地址 (静态表，不占任务栈)
+                static float* const temp_points[MAX_DS18B20_SENSORS] = {
                     &current_data.data_temp_point1,
                     &current_data.data_temp_point2,
                     &current_data.data_temp_point3,
                     &current_data.data_temp_point4,
                     &current_data.data_temp_point5
                 };
-                printf("\n");
-                // 循环赋值，并添加温度范围检查
+                static float* const upload_points[MAX_DS18B20_SENSORS] = {
+                    &upload_server_data.data_temp_point1,
+                    &upload_server_data.data_temp_point2,
+                    &upload_server_data.data_temp_point3,
+                    &upload_server_data.data_temp_point4,
+                    &upload_server_data.data_temp_point5
+                };
+                // 原始值经过滤波(范围检查、85°C剔除、中值、斜率限制、EMA)后再赋值
                 for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
-                    if (ds18b20_devices[i].present && temperatures[i] > -999.0f) {
-                        // 判断温度是否在有效范围内
-                        if (temperatures[i] >= DS18B20_TEMP_MIN && temperatures[i] <= DS18B20_TEMP_MAX) {
-                            // 只有在传感器连接且温度在有效范围内时才更新数据
-                            *temp_points[i] = temperatures[i];
-                            printf("Position %d Temp: %.2f°C (Valid)\n", i+1, temperatures[i]);
+                    if (valid & DS18B20_MASK_BIT(i)) {
+                        int16_t raw = bus_result.raw[i];
+                        uint8_t status = TempFilter_Update(i, raw, &filtered);
+                        if (status == TEMP_FILTER_OK) {
+                            // 只有在传感器连接且滤波接受样本时才更新数据
+                            *temp_points[i] = filtered * 0.0625f;
+                            Publish_Update(i, filtered, &bus_result.stamp);
+                            DS_LOG_INFO(LOG_EVT_POS_VALID, i + 1, filtered * 100 / 16, 0);
+                        } else if (status == TEMP_FILTER_REJECT_POR) {
+                            // 传感器刚上电或掉电复位，保持之前的有效值
+                            DS_LOG_WARN(LOG_EVT_POS_POR, i + 1, 0, 0);
                         } else {
-                            // 温度超出范围，可能是传感器故障或噪声干扰
-                            printf("Position %d Temp: %.2f°C (Out of range, not updated)\n", i+1, temperatures[i]);
-                            // 可以选择在这里设置一个错误标志，或保持之前的有效值
+                            // 温度超出范围，可能是传感器故障或噪声干扰，保持之前的有效值
+                            DS_LOG_WARN(LOG_EVT_POS_RANGE, i + 1, raw * 100 / 16, 0);
                         }
                     } else {
-                        printf("Position %d: Not connected or invalid reading\n", i+1);
+                        DS_LOG_INFO(LOG_EVT_POS_INVALID, i + 1, 0, 0);
                     }
                 }
                 
                 upload_sensor_state = current_sensor_state;
-                memset(&upload_server_data, 0, sizeof(collector_data));
-                upload_server_data = current_data;
                 memset(&lcd_data, 0, sizeof(collector_data));
                 lcd_data = current_data;
+                // 冻结各位置值对应的转换时间戳，下一周期发送后调用Publish_RecordUpload
+                // upload_server_data的其他字段照常取当前值，温度点只更新需要上报的位置，
+                // 其余位置保持上次上传的值 (接收方已有的值)
+                report = Publish_Snapshot();
+                for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+                    uploaded_points[i] = *upload_points[i];
+                }
+                memset(&upload_server_data, 0, sizeof(collector_data));
+                upload_server_data = current_data;
+                for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+                    if (!(report & (1UL << i))) {
+                        *upload_points[i] = uploaded_points[i];
+                    }
+                }
+                upload_pending = (report != 0);
             }
         }
         
         // 检查按键，是否进入学习模式
         if (!button_pressed && GPIO_ReadInputDataBit(BUTTON_GPIO, BUTTON_PIN) == 0) {
             button_pressed = 1;
-            printf("Button pressed! Hold for 3 seconds to enter learning mode...\r\n");
+            DS_LOG_INFO(LOG_EVT_BUTTON_HOLD, 0, 0, 0);
             
             // 等待3秒确认长按
             uint8_t count = 0;
@@ -226,7 +402,7 @@ void RS485_task(void* pvParameters) {
             }
             
             if (count >= 30) {
-                printf("Entering learning mode...\r\n");
+                DS_LOG_INFO(LOG_EVT_BUTTON_LEARN, 0, 0, 0);
                 
                 // 等待按键释放
                 while (GPIO_ReadInputDataBit(BUTTON_GPIO, BUTTON_PIN) == 0) {
@@ -236,7 +412,7 @@ void RS485_task(void* pvParameters) {
                 // 重启系统进入学习模式
                 NVIC_SystemReset();
             } else {
-                printf("Button released too early, continuing normal operation\r\n");
+                DS_LOG_INFO(LOG_EVT_BUTTON_SHORT, 0, 0, 0);
             }
         } else if (GPIO_ReadInputDataBit(BUTTON_GPIO, BUTTON_PIN) != 0) {
             button_pressed = 0;
@@ -246,21 +422,37 @@ void RS485_task(void* pvParameters) {
     }
 }
 
+// 配置口的一帧: 先尝试作为诊断命令处理，其余复制到原有协议的接收缓冲区解析
+// 两者的应答都用printf输出，处理期间持有USART1发送权
+static void usart1_config_frame(const char *data, uint16_t len) {
+    DS_Log_TxLock();
+    if (!Diag_HandleCommand(data, len)) {
+        if (len >= sizeof(Usart1.uart_buf)) {
+            len = sizeof(Usart1.uart_buf) - 1;
+        }
+        memcpy(Usart1.uart_buf, data, len);
+        Usart1.uart_buf[len] = 0;
+        Usart1_receive_process_event();
+    }
+    DS_Log_TxUnlock();
+}
+
 void USART1_Config_task(void* pvParameters) {
-    BaseType_t err = pdFALSE;
+    DS_Log_TxLock();
     printf("USART1_Config_task Start......\r\n");
+    DS_Log_TxUnlock();
 
     while (1) {
+        // 空闲中断或DMA半满/全满时被唤醒，收到的多条命令逐条处理，无固定延时；
+        // 有未结束的帧时按CFG_RX_IDLE_TICKS查询空闲线 (USART1_IRQHandler未调用CfgRx_IdleISR时的后备)
         if (USART1_RECEIVE_DATA != NULL) {
-            err = xSemaphoreTake(USART1_RECEIVE_DATA, (TickType_t)1000);
-
-            if (err == pdTRUE) {
-                Usart1_receive_process_event();
-                memset(Usart1.uart_buf, 0, sizeof(Usart1.uart_buf));
-                SysMng.USART1_RECEIVETIME = 0;
-            }
+            xSemaphoreTake(USART1_RECEIVE_DATA, CfgRx_Pending() ? CFG_RX_IDLE_TICKS : CFG_RX_POLL_TICKS);
+        } else {
+            vTaskDelay(CFG_RX_IDLE_TICKS);
+        }
+        if (CfgRx_Poll(usart1_config_frame, Diag_IsCommand) > 0) {
+            SysMng.USART1_RECEIVETIME = 0;
         }
-        vTaskDelay(150);
     }
 }
 
@@ -0,0 +1,322 @@
+/**
+ * 1-Wire位级跟踪记录与事务解码
+ * 每个时隙只写一个32位记录，与60us以上的时隙相比开销可忽略，可在现场常开
+ */
+
+#include "ow_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+#define OW_CMD_MATCH_ROM            0x55
+#define OW_CMD_SKIP_ROM             0xCC
+#define OW_CMD_READ_ROM             0x33
+#define OW_CMD_SEARCH_ROM           0xF0
+#define OW_CMD_READ_SCRATCHPAD      0xBE
+
+#if OW_TRACE_ENABLE
+static uint32_t trace_buf[OW_TRACE_LEN];
+static uint16_t trace_head = 0;           // 下一条写入位置
+static uint16_t trace_count = 0;
+static uint8_t trace_mode = OW_TRACE_MODE_TRIGGER;
+static uint8_t trace_frozen = 0;
+static uint16_t trace_post = 0;           // 触发后剩余记录条数 (0表示未触发)
+#endif
+
+// 1-Wire CRC8
+uint8_t OW_Crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0;
+    uint8_t i, j;
+
+    for (i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (j = 0; j < 8; j++) {
+            if (crc & 0x01) {
+                crc = (crc >> 1) ^ 0x8C;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+#if OW_TRACE_ENABLE
+uint8_t OwTrace_Active(void)
+{
+    return trace_mode != OW_TRACE_MODE_OFF && !trace_frozen;
+}
+
+static void trace_put(uint32_t entry)
+{
+    if (!OwTrace_Active()) {
+        return;
+    }
+    trace_buf[trace_head] = entry;
+    trace_head = (uint16_t)((trace_head + 1) % OW_TRACE_LEN);
+    if (trace_count < OW_TRACE_LEN) {
+        trace_count++;
+    }
+    if (trace_post > 0 && --trace_post == 0) {
+        trace_frozen = 1;
+    }
+}
+
+// 记录一个时隙，timing和delta_us超出字段范围时饱和
+void OwTrace_Slot(uint8_t kind, uint8_t value, uint32_t timing, uint32_t delta_us)
+{
+    if (timing > 0x1FF) {
+        timing = 0x1FF;
+    }
+    if (delta_us > 0xFFFFF) {
+        delta_us = 0xFFFFF;
+    }
+    trace_put(((uint32_t)(kind & 0x03) << 30) | ((uint32_t)(value & 0x01) << 29) |
+              (timing << 20) | delta_us);
+}
+
+// 记录标记，触发模式下错误标记启动冻结倒计数
+void OwTrace_Mark(uint8_t code, uint8_t arg)
+{
+    if (!OwTrace_Active()) {
+        return;
+    }
+    if (trace_mode == OW_TRACE_MODE_TRIGGER && trace_post == 0) {
+        trace_post = OW_TRACE_POST_TRIGGER + 1;
+    }
+    trace_put(((uint32_t)OW_TRACE_MARK << 30) | ((uint32_t)(code & 0x3F) << 24) | ((uint32_t)arg << 16));
+}
+
+// 切换模式并解除冻结
+void OwTrace_SetMode(uint8_t mode)
+{
+    trace_mode = mode;
+    trace_frozen = 0;
+    trace_post = 0;
+}
+
+uint8_t OwTrace_GetMode(void)
+{
+    return trace_mode;
+}
+
+void OwTrace_Clear(void)
+{
+    trace_head = 0;
+    trace_count = 0;
+    trace_frozen = 0;
+    trace_post = 0;
+}
+
+// 按时间顺序复制记录，返回条数
+uint16_t OwTrace_Copy(uint32_t *out, uint16_t max)
+{
+    uint16_t start = (uint16_t)((trace_head + OW_TRACE_LEN - trace_count) % OW_TRACE_LEN);
+    uint16_t n = (trace_count < max) ? trace_count : max;
+
+    // 缓冲区不够时保留最新的记录
+    start = (uint16_t)((start + trace_count - n) % OW_TRACE_LEN);
+    for (uint16_t i = 0; i < n; i++) {
+        out[i] = trace_buf[(start + i) % OW_TRACE_LEN];
+    }
+    return n;
+}
+
+// 以十六进制打印全部记录 (每行8条)，供host/ow_replay解析
+void OwTrace_Dump(void)
+{
+    uint16_t start = (uint16_t)((trace_head + OW_TRACE_LEN - trace_count) % OW_TRACE_LEN);
+
+    printf("OWTRACE BEGIN n=%u mode=%u frozen=%u\r\n", trace_count, trace_mode, trace_frozen);
+    for (uint16_t i = 0; i < trace_count; i++) {
+        printf("%08lX%s", (unsigned long)trace_buf[(start + i) % OW_TRACE_LEN],
+               ((i % 8) == 7 || i + 1 == trace_count) ? "\r\n" : " ");
+    }
+    printf("OWTRACE END\r\n");
+}
+#else
+uint8_t OwTrace_Active(void) { return 0; }
+void OwTrace_Slot(uint8_t kind, uint8_t value, uint32_t timing, uint32_t delta_us) {}
+void OwTrace_Mark(uint8_t code, uint8_t arg) {}
+void OwTrace_SetMode(uint8_t mode) {}
+uint8_t OwTrace_GetMode(void) { return OW_TRACE_MODE_OFF; }
+void OwTrace_Clear(void) {}
+uint16_t OwTrace_Copy(uint32_t *out, uint16_t max) { return 0; }
+void OwTrace_Dump(void) { printf("OWTRACE disabled\r\n"); }
+#endif
+
+// 解码状态: 当前事务及按方向拼装的字节流
+typedef struct {
+    ow_trace_txn_t txn;
+    uint8_t open;
+    uint8_t wr_acc, wr_bits;
+    uint8_t rd_acc, rd_bits;
+    uint8_t search;               // 搜索ROM阶段: 每个ROM位为读、读、写三个时隙
+    uint8_t search_phase;
+    uint8_t search_bit;
+} trace_decoder_t;
+
+// 事务结束: 按ROM命令和功能命令解释字节流
+static void trace_txn_finish(trace_decoder_t *d, const uint32_t *entries, ow_trace_txn_cb_t cb, void *ctx)
+{
+    ow_trace_txn_t *t = &d->txn;
+    uint8_t func_idx = 0xFF;
+
+    if (t->wr_len > 0) {
+        t->rom_cmd = t->wr[0];
+    }
+    switch (t->rom_cmd) {
+    case OW_CMD_MATCH_ROM:
+        if (t->wr_len >= 9) {
+            memcpy(t->rom, &t->wr[1], 8);
+            t->rom_valid = 1;
+            func_idx = 9;
+        }
+        break;
+    case OW_CMD_SKIP_ROM:
+        func_idx = 1;
+        break;
+    case OW_CMD_READ_ROM:
+        if (t->rd_len >= 8) {
+            memcpy(t->rom, t->rd, 8);
+            t->rom_valid = 1;
+        }
+        break;
+    case OW_CMD_SEARCH_ROM:
+        t->rom_valid = (d->search_bit == 64);
+        break;
+    default:
+        break;
+    }
+    if (t->rom_valid) {
+        t->rom_crc_ok = (OW_Crc8(t->rom, 7) == t->rom[7]);
+    }
+    if (func_idx < t->wr_len) {
+        t->func_cmd = t->wr[func_idx];
+    }
+    if (t->func_cmd == OW_CMD_READ_SCRATCHPAD && t->rd_len >= 9) {
+        t->sp_valid = 1;
+        t->sp_crc_ok = (OW_Crc8(t->rd, 8) == t->rd[8]);
+    }
+
+    if (cb != NULL) {
+        cb(ctx, t, entries);
+    }
+    d->open = 0;
+}
+
+static void trace_fault(ow_trace_txn_t *t, uint16_t index)
+{
+    if (t->timing_faults++ == 0) {
+        t->first_fault = index;
+    }
+}
+
+// 把一个写/读时隙拼入对应方向的字节流
+static void trace_push_bit(trace_decoder_t *d, uint8_t is_read, uint8_t bit)
+{
+    ow_trace_txn_t *t = &d->txn;
+
+    if (d->search) {
+        if (d->search_phase == 2 && !is_read && d->search_bit < 64) {
+            if (bit) {
+                t->rom[d->search_bit / 8] |= (uint8_t)(1 << (d->search_bit % 8));
+            }
+            d->search_bit++;
+        }
+        d->search_phase = (uint8_t)((d->search_phase + 1) % 3);
+        return;
+    }
+
+    if (is_read) {
+        t->rd_bits++;
+        d->rd_acc = (uint8_t)((d->rd_acc >> 1) | (bit ? 0x80 : 0));
+        if (++d->rd_bits == 8) {
+            if (t->rd_len < OW_TRACE_TXN_BYTES) {
+                t->rd[t->rd_len++] = d->rd_acc;
+            }
+            d->rd_bits = 0;
+        }
+    } else {
+        d->wr_acc = (uint8_t)((d->wr_acc >> 1) | (bit ? 0x80 : 0));
+        if (++d->wr_bits == 8) {
+            if (t->wr_len < OW_TRACE_TXN_BYTES) {
+                t->wr[t->wr_len++] = d->wr_acc;
+            }
+            d->wr_bits = 0;
+            // 搜索命令之后进入三时隙模式
+            if (t->wr_len == 1 && t->wr[0] == OW_CMD_SEARCH_ROM) {
+                d->search = 1;
+            }
+        }
+    }
+}
+
+// 解码记录序列: 以复位划分事务，缓冲区开头不完整的事务被跳过
+uint16_t OwTrace_Decode(const uint32_t *entries, uint16_t count, ow_trace_txn_cb_t cb, void *ctx)
+{
+    trace_decoder_t d;
+    uint32_t now_us = 0;
+    uint16_t txns = 0;
+
+    memset(&d, 0, sizeof(d));
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t e = entries[i];
+        uint8_t kind = OW_TRACE_KIND(e);
+        uint16_t timing = OW_TRACE_TIMING(e);
+
+        if (kind == OW_TRACE_MARK) {
+            if (d.open) {
+                d.txn.mark_code = OW_TRACE_MARK_CODE(e);
+                d.txn.mark_arg = OW_TRACE_MARK_ARG(e);
+                d.txn.count = (uint16_t)(i - d.txn.first + 1);
+            }
+            continue;
+        }
+        if (i > 0) {
+            now_us += OW_TRACE_DELTA_US(e);
+        }
+
+        if (kind == OW_TRACE_RESET) {
+            if (d.open) {
+                trace_txn_finish(&d, entries, cb, ctx);
+                txns++;
+            }
+            memset(&d, 0, sizeof(d));
+            d.open = 1;
+            d.txn.start_us = now_us;
+            d.txn.first = i;
+            d.txn.count = 1;
+            d.txn.presence = OW_TRACE_VALUE(e);
+            d.txn.presence_us = timing;
+            if (timing > OW_TRACE_PRESENCE_MAX_US) {
+                trace_fault(&d.txn, i);
+            }
+            continue;
+        }
+        if (!d.open) {
+            continue;
+        }
+
+        d.txn.count = (uint16_t)(i - d.txn.first + 1);
+        if (kind == OW_TRACE_READ) {
+            if (timing > d.txn.read_sample_max) {
+                d.txn.read_sample_max = timing;
+            }
+            if (timing > OW_TRACE_READ_SAMPLE_MAX) {
+                trace_fault(&d.txn, i);
+            }
+        } else if (OW_TRACE_VALUE(e) ? (timing > OW_TRACE_WRITE1_LOW_MAX) : (timing < OW_TRACE_WRITE0_LOW_MIN)) {
+            trace_fault(&d.txn, i);
+        }
+        trace_push_bit(&d, kind == OW_TRACE_READ, OW_TRACE_VALUE(e));
+    }
+
+    if (d.open) {
+        trace_txn_finish(&d, entries, cb, ctx);
+        txns++;
+    }
+    return txns;
+}
@@ -0,0 +1,104 @@
+#ifndef __OW_TRACE_H
+#define __OW_TRACE_H
+#include <stdint.h>
+
+/**
+ * 1-Wire位级跟踪记录
+ * 驱动每个复位/时隙写入一个32位记录到RAM环形缓冲区，配置口OWTRACE命令以十六进制导出，
+ * 主机工具host/ow_replay用同一套解码和CRC逻辑还原事务，定位时序或噪声故障。
+ * 不依赖HAL，解码器同时可在Linux主机上编译
+ *
+ * 记录格式:
+ *   [31:30] 类型 OW_TRACE_RESET/WRITE/READ/MARK
+ *   时隙 (复位/写/读):
+ *     [29]    值 (写入位/读到的位/是否检测到存在脉冲)
+ *     [28:20] 时序 (读: 下降沿到采样点；写: 低电平宽度；单位0.25us。复位: 释放到存在脉冲采样点，单位1us)
+ *     [19:0]  距上一条时隙记录开始的时间 (us，饱和)
+ *   标记:
+ *     [29:24] 标记码 OW_TRACE_MARK_*
+ *     [23:16] 参数 (位置1起，0表示无)
+ */
+
+#ifndef OW_TRACE_ENABLE
+#define OW_TRACE_ENABLE             1       // 0时驱动不调用跟踪，可省去缓冲区RAM
+#endif
+#ifndef OW_TRACE_LEN
+#define OW_TRACE_LEN                512     // 环形缓冲区记录数 (2KB，约3次匹配ROM读暂存器，每次约153条)
+#endif
+#define OW_TRACE_POST_TRIGGER       32      // 触发模式下错误标记后继续记录的条数
+
+// 记录类型
+#define OW_TRACE_RESET              0
+#define OW_TRACE_WRITE              1
+#define OW_TRACE_READ               2
+#define OW_TRACE_MARK               3
+
+// 标记码
+#define OW_TRACE_MARK_CRC           1       // 暂存器CRC错误 (参数为位置)
+#define OW_TRACE_MARK_ROM_CRC       2       // 搜索/读ROM时CRC错误
+
+// 记录模式
+#define OW_TRACE_MODE_OFF           0
+#define OW_TRACE_MODE_ON            1       // 连续记录，覆盖最旧的记录
+#define OW_TRACE_MODE_TRIGGER       2       // 连续记录，CRC错误后再记录OW_TRACE_POST_TRIGGER条即冻结
+
+// 字段提取
+#define OW_TRACE_KIND(e)            ((uint8_t)((e) >> 30))
+#define OW_TRACE_VALUE(e)           ((uint8_t)(((e) >> 29) & 0x01))
+#define OW_TRACE_TIMING(e)          ((uint16_t)(((e) >> 20) & 0x1FF))
+#define OW_TRACE_DELTA_US(e)        ((e) & 0xFFFFF)
+#define OW_TRACE_MARK_CODE(e)       ((uint8_t)(((e) >> 24) & 0x3F))
+#define OW_TRACE_MARK_ARG(e)        ((uint8_t)(((e) >> 16) & 0xFF))
+
+// 时序规范 (时隙单位0.25us，复位单位1us)，超出即判为时序故障
+#define OW_TRACE_READ_SAMPLE_MAX    60      // 读时隙必须在下降沿后15us内采样
+#define OW_TRACE_WRITE1_LOW_MAX     60      // 写1低电平不超过15us
+#define OW_TRACE_WRITE0_LOW_MIN     240     // 写0低电平至少60us
+#define OW_TRACE_PRESENCE_MAX_US    75      // 存在脉冲保证持续到释放后75us
+
+// 解码出的一个事务 (从一次复位到下一次复位)
+#define OW_TRACE_TXN_BYTES          16
+typedef struct {
+    uint32_t start_us;            // 相对第一条记录的开始时间
+    uint16_t first;               // 第一条记录序号 (复位)
+    uint16_t count;               // 记录条数
+    uint8_t presence;             // 存在脉冲
+    uint16_t presence_us;         // 存在脉冲采样点
+    uint8_t rom_cmd;              // ROM命令 (0表示未发送)
+    uint8_t rom[8];               // 匹配/读出/搜索到的ROM码
+    uint8_t rom_valid;            // rom中有完整ROM码
+    uint8_t rom_crc_ok;
+    uint8_t func_cmd;             // 功能命令 (0表示未发送)
+    uint8_t wr[OW_TRACE_TXN_BYTES]; // 写入的字节 (LSB先)
+    uint8_t wr_len;
+    uint8_t rd[OW_TRACE_TXN_BYTES]; // 读出的字节
+    uint8_t rd_len;
+    uint16_t rd_bits;             // 读时隙总数 (含不足一字节的部分)
+    uint8_t sp_valid;             // rd中有完整暂存器 (读暂存器命令)
+    uint8_t sp_crc_ok;
+    uint8_t mark_code;            // 事务内最后一个标记
+    uint8_t mark_arg;
+    uint16_t timing_faults;       // 超出时序规范的记录数
+    uint16_t first_fault;         // 第一条时序故障记录序号
+    uint16_t read_sample_max;     // 最晚的读采样点 (0.25us)
+} ow_trace_txn_t;
+
+typedef void (*ow_trace_txn_cb_t)(void *ctx, const ow_trace_txn_t *txn, const uint32_t *entries);
+
+// 1-Wire CRC8 (多项式X^8+X^5+X^4+1)，驱动与回放共用
+uint8_t OW_Crc8(const uint8_t *data, uint8_t length);
+
+// 记录 (设备端，由总线任务调用)
+uint8_t OwTrace_Active(void);
+void OwTrace_Slot(uint8_t kind, uint8_t value, uint32_t timing, uint32_t delta_us);
+void OwTrace_Mark(uint8_t code, uint8_t arg);
+void OwTrace_SetMode(uint8_t mode);
+uint8_t OwTrace_GetMode(void);
+void OwTrace_Clear(void);
+uint16_t OwTrace_Copy(uint32_t *out, uint16_t max);
+void OwTrace_Dump(void);
+
+// 解码记录序列，每个事务回调一次，返回事务数
+uint16_t OwTrace_Decode(const uint32_t *entries, uint16_t count, ow_trace_txn_cb_t cb, void *ctx);
+
+#endif
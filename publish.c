@@ -0,0 +1,490 @@
+/**
+ * 发布数据的时间戳与新鲜度统计
+ * 直方图统计中位数只需常数内存，精度为一格宽度 (PUBLISH_AGE_BUCKET_MS)
+ */
+
+#include "publish.h"
+#include "batch_frame.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+// 单个位置的发布值
+typedef struct {
+    uint8_t valid;                // 是否有有效值
+    int16_t raw;                  // 滤波后的温度 (1/16°C)
+    ds18b20_stamp_t stamp;        // 对应转换的时间戳
+} publish_entry_t;
+
+static publish_entry_t current[MAX_DS18B20_SENSORS];   // 最新值
+static publish_entry_t snapshot[MAX_DS18B20_SENSORS];  // 最近一次快照
+static publish_age_stats_t snapshot_stats;             // 快照时的样本年龄
+static publish_age_stats_t upload_stats;               // 上传时的样本年龄
+
+#if MAX_DS18B20_SENSORS > BATCH_FRAME_MAX_POSITIONS
+#error "MAX_DS18B20_SENSORS exceeds batch frame positions"
+#endif
+
+// 历史队列中的一行: 一次快照中新采到的样本
+typedef struct {
+    uint32_t tick;                // 本行最新一次转换完成节拍
+    uint32_t mask;                // 本行包含的位置
+    int16_t raw[MAX_DS18B20_SENSORS];
+} publish_row_t;
+
+static publish_row_t history[PUBLISH_HISTORY_LEN];
+static uint8_t history_head = 0;                       // 最旧的行
+static uint8_t history_count = 0;
+static uint32_t history_dropped = 0;                   // 队列满时覆盖的行数
+static uint32_t fresh_mask = 0;                        // 上次快照后更新过的位置
+
+// 按变化上报: 各位置上次上报的值和时刻，以及最近一次上报的内容
+static uint16_t deadband[MAX_DS18B20_SENSORS];
+static uint32_t max_silence_ms = PUBLISH_MAX_SILENCE_MS;
+static int16_t reported_raw[MAX_DS18B20_SENSORS];
+static TickType_t reported_tick[MAX_DS18B20_SENSORS];
+static uint32_t reported_mask = 0;                     // 已上报过的位置
+static uint32_t report_seq = 0;                        // 最近一次上报的序号 (0表示尚未上报)
+static uint32_t report_mask = 0;                       // 最近一次上报包含的位置
+static TickType_t report_tick = 0;                     // 最近一次上报时刻
+static uint8_t report_flags[MAX_DS18B20_SENSORS];      // 最近一次上报中各位置的原因 (BATCH_REPORT_FLAG_*)
+static publish_report_stats_t report_stats;
+
+static void publish_age_add(publish_age_stats_t *stats, uint32_t age_ms)
+{
+    uint32_t bucket = age_ms / PUBLISH_AGE_BUCKET_MS;
+
+    if (bucket >= PUBLISH_AGE_BUCKETS) {
+        bucket = PUBLISH_AGE_BUCKETS - 1;
+    }
+    stats->hist[bucket]++;
+    stats->count++;
+    if (age_ms > stats->max_ms) {
+        stats->max_ms = age_ms;
+    }
+}
+
+// 中位数 (所在格的上界)
+static uint32_t publish_age_p50(const publish_age_stats_t *stats)
+{
+    uint32_t seen = 0;
+
+    if (stats->count == 0) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < PUBLISH_AGE_BUCKETS; i++) {
+        seen += stats->hist[i];
+        if (seen * 2 >= stats->count) {
+            return (i + 1) * PUBLISH_AGE_BUCKET_MS;
+        }
+    }
+    return stats->max_ms;
+}
+
+// 记录一组发布值相对当前节拍的年龄 (与AGESTAT清零互斥)
+static void publish_age_record(publish_age_stats_t *stats, const publish_entry_t *entries)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (entries[i].valid) {
+            publish_age_add(stats, (uint32_t)(now - entries[i].stamp.conv_done) * portTICK_PERIOD_MS);
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void Publish_Init(void)
+{
+    memset(current, 0, sizeof(current));
+    memset(snapshot, 0, sizeof(snapshot));
+    memset(&snapshot_stats, 0, sizeof(snapshot_stats));
+    memset(&upload_stats, 0, sizeof(upload_stats));
+    history_head = 0;
+    history_count = 0;
+    history_dropped = 0;
+    fresh_mask = 0;
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        deadband[i] = PUBLISH_DEADBAND_DEFAULT;
+    }
+    reported_mask = 0;
+    report_seq = 0;
+    report_mask = 0;
+    memset(report_flags, 0, sizeof(report_flags));
+    memset(&report_stats, 0, sizeof(report_stats));
+}
+
+// 选出需要上报的位置并记录为最近一次上报，返回上报的位置掩码 (在临界区内调用)
+static uint32_t publish_select_report(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    uint32_t mask = 0;
+    uint8_t flags[MAX_DS18B20_SENSORS];
+
+    report_stats.snapshots++;
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        uint32_t silent_ms = (uint32_t)(now - reported_tick[i]) * portTICK_PERIOD_MS;
+        int32_t diff = (int32_t)current[i].raw - reported_raw[i];
+
+        flags[i] = 0;
+        if (!current[i].valid) {
+            continue;
+        }
+        report_stats.candidates++;
+        if (!(reported_mask & (1UL << i)) || diff > deadband[i] || -diff > deadband[i]) {
+            flags[i] = BATCH_REPORT_FLAG_CHANGED;
+        } else if (silent_ms >= max_silence_ms) {
+            flags[i] = BATCH_REPORT_FLAG_SILENCE;
+        }
+        if (flags[i]) {
+            mask |= 1UL << i;
+        }
+    }
+    if (mask == 0) {
+        return 0;
+    }
+
+    // 已经要唤醒链路，静默过半的位置一起上报，避免各自到期时分别唤醒
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        if (current[i].valid && !(mask & (1UL << i)) &&
+            (uint32_t)(now - reported_tick[i]) * portTICK_PERIOD_MS >= max_silence_ms / 2) {
+            flags[i] = BATCH_REPORT_FLAG_SILENCE;
+            mask |= 1UL << i;
+        }
+    }
+
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        report_flags[i] = flags[i];
+        if (mask & (1UL << i)) {
+            reported_raw[i] = current[i].raw;
+            reported_tick[i] = now;
+            report_stats.entries++;
+        }
+    }
+    reported_mask |= mask;
+    report_mask = mask;
+    report_tick = now;
+    report_seq++;
+    report_stats.reports++;
+    return mask;
+}
+
+// 更新位置的发布值及其转换时间戳
+void Publish_Update(uint8_t position, int16_t raw, const ds18b20_stamp_t *stamp)
+{
+    if (position >= MAX_DS18B20_SENSORS) return;
+
+    taskENTER_CRITICAL();
+    current[position].valid = 1;
+    current[position].raw = raw;
+    current[position].stamp = *stamp;
+    fresh_mask |= 1UL << position;
+    taskEXIT_CRITICAL();
+}
+
+// 冻结快照 (与lcd_data赋值同时调用)，并统计采集链路的样本年龄
+// 返回需要上报的位置掩码，为0时本周期无需唤醒上行链路
+uint32_t Publish_Snapshot(void)
+{
+    uint32_t report;
+
+    taskENTER_CRITICAL();
+    memcpy(snapshot, current, sizeof(snapshot));
+
+    // 本轮新样本追加到历史队列
+    if (fresh_mask != 0) {
+        publish_row_t *row;
+        uint8_t first = 1;
+
+        if (history_count == PUBLISH_HISTORY_LEN) {
+            history_head = (uint8_t)((history_head + 1) % PUBLISH_HISTORY_LEN);
+            history_count--;
+            history_dropped++;
+        }
+        row = &history[(history_head + history_count) % PUBLISH_HISTORY_LEN];
+        row->mask = fresh_mask;
+        for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+            if (fresh_mask & (1UL << i)) {
+                row->raw[i] = current[i].raw;
+                if (first || (int32_t)(current[i].stamp.conv_done - row->tick) > 0) {
+                    row->tick = current[i].stamp.conv_done;
+                    first = 0;
+                }
+            }
+        }
+        history_count++;
+        fresh_mask = 0;
+    }
+    report = publish_select_report();
+    taskEXIT_CRITICAL();
+
+    publish_age_record(&snapshot_stats, snapshot);
+    return report;
+}
+
+// 网络模块实际发送upload_server_data后调用，统计端到端样本年龄
+void Publish_RecordUpload(void)
+{
+    publish_entry_t entries[MAX_DS18B20_SENSORS];
+
+    taskENTER_CRITICAL();
+    memcpy(entries, snapshot, sizeof(entries));
+    taskEXIT_CRITICAL();
+
+    publish_age_record(&upload_stats, entries);
+}
+
+// 快照中位置的样本年龄 (ms)，无数据返回0xFFFFFFFF
+uint32_t Publish_GetAgeMs(uint8_t position)
+{
+    uint32_t age;
+
+    if (position >= MAX_DS18B20_SENSORS) return 0xFFFFFFFF;
+
+    taskENTER_CRITICAL();
+    age = snapshot[position].valid ?
+          (uint32_t)(xTaskGetTickCount() - snapshot[position].stamp.conv_done) * portTICK_PERIOD_MS :
+          0xFFFFFFFF;
+    taskEXIT_CRITICAL();
+    return age;
+}
+
+// 按寄存器映射填充快照数据，返回填充的寄存器数
+uint8_t Publish_FillRegisters(uint16_t *regs, uint8_t max_regs)
+{
+    publish_entry_t entries[MAX_DS18B20_SENSORS];
+    uint8_t flags[MAX_DS18B20_SENSORS];
+    uint32_t seq;
+    TickType_t now;
+    uint8_t count = 0;
+
+    if (max_regs == 0) return 0;
+
+    taskENTER_CRITICAL();
+    memcpy(entries, snapshot, sizeof(entries));
+    memcpy(flags, report_flags, sizeof(flags));
+    seq = report_seq;
+    now = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+
+    regs[count++] = MAX_DS18B20_SENSORS;
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS && count + PUBLISH_REG_PER_POSITION <= max_regs; i++) {
+        uint32_t age = 0xFFFF;
+
+        if (entries[i].valid) {
+            age = (uint32_t)(now - entries[i].stamp.conv_done) * portTICK_PERIOD_MS / PUBLISH_REG_AGE_UNIT_MS;
+        }
+        regs[count++] = entries[i].valid ? (uint16_t)(int16_t)(entries[i].raw * 100 / 16) : 0;
+        regs[count++] = (age > 0xFFFF) ? 0xFFFF : (uint16_t)age;
+        regs[count++] = (entries[i].valid ? PUBLISH_FLAG_VALID : 0) |
+                        ((flags[i] & BATCH_REPORT_FLAG_CHANGED) ? PUBLISH_FLAG_CHANGED : 0) |
+                        ((flags[i] & BATCH_REPORT_FLAG_SILENCE) ? PUBLISH_FLAG_SILENCE : 0);
+    }
+    if (count == PUBLISH_REG_COUNT - 2 && count + 2 <= max_regs) {
+        regs[count++] = (uint16_t)seq;
+        regs[count++] = (uint16_t)(seq >> 16);
+    }
+    return count;
+}
+
+// Modbus RTU从站: 处理一帧请求 (地址、功能码、起始寄存器、数量、CRC)，按寄存器映射生成应答
+// 返回应答长度，不是发给本站的完整请求或CRC错误时返回0 (不应答)
+uint16_t Publish_HandleModbus(uint8_t addr, const uint8_t *req, uint16_t len, uint8_t *resp, uint16_t cap)
+{
+    uint16_t regs[PUBLISH_REG_COUNT];
+    uint16_t start, count, crc;
+    uint16_t n = 0;
+    uint8_t filled;
+
+    if (len != PUBLISH_MODBUS_REQ_SIZE || req[0] != addr || cap < PUBLISH_MODBUS_EXC_SIZE) return 0;
+    crc = BatchFrame_Crc16(req, len - 2);
+    if (req[len - 2] != (uint8_t)crc || req[len - 1] != (uint8_t)(crc >> 8)) return 0;
+
+    resp[n++] = addr;
+    if (req[1] != PUBLISH_MODBUS_FC_READ_HOLDING) {
+        resp[n++] = (uint8_t)(req[1] | 0x80);
+        resp[n++] = PUBLISH_MODBUS_EXC_FUNCTION;
+    } else {
+        start = (uint16_t)((req[2] << 8) | req[3]);
+        count = (uint16_t)((req[4] << 8) | req[5]);
+        filled = Publish_FillRegisters(regs, PUBLISH_REG_COUNT);
+        if (count == 0 || (uint32_t)start + count > filled || 5 + 2 * (uint32_t)count > cap) {
+            resp[n++] = PUBLISH_MODBUS_FC_READ_HOLDING | 0x80;
+            resp[n++] = PUBLISH_MODBUS_EXC_ADDRESS;
+        } else {
+            resp[n++] = PUBLISH_MODBUS_FC_READ_HOLDING;
+            resp[n++] = (uint8_t)(2 * count);
+            for (uint16_t i = 0; i < count; i++) {
+                resp[n++] = (uint8_t)(regs[start + i] >> 8);
+                resp[n++] = (uint8_t)regs[start + i];
+            }
+        }
+    }
+    crc = BatchFrame_Crc16(resp, n);
+    resp[n++] = (uint8_t)crc;
+    resp[n++] = (uint8_t)(crc >> 8);
+    return n;
+}
+
+// 打印并清零样本年龄统计
+void Publish_PrintStats(void)
+{
+    publish_age_stats_t snap, upload;
+
+    taskENTER_CRITICAL();
+    memcpy(&snap, &snapshot_stats, sizeof(snap));
+    memcpy(&upload, &upload_stats, sizeof(upload));
+    memset(&snapshot_stats, 0, sizeof(snapshot_stats));
+    memset(&upload_stats, 0, sizeof(upload_stats));
+    taskEXIT_CRITICAL();
+
+    printf("\r\n--- Sample Age ---\r\n");
+    printf("At snapshot: n=%lu p50<=%lu ms max=%lu ms\r\n",
+           (unsigned long)snap.count, (unsigned long)publish_age_p50(&snap), (unsigned long)snap.max_ms);
+    printf("At upload:   n=%lu p50<=%lu ms max=%lu ms\r\n",
+           (unsigned long)upload.count, (unsigned long)publish_age_p50(&upload), (unsigned long)upload.max_ms);
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        uint32_t age = Publish_GetAgeMs(i);
+        if (age == 0xFFFFFFFF) {
+            printf("Position %d: no data\r\n", i + 1);
+        } else {
+            printf("Position %d: age %lu ms\r\n", i + 1, (unsigned long)age);
+        }
+    }
+    printf("------------------\r\n\n");
+}
+
+// 把历史队列编码为批量帧，已编码的行出队，返回帧长度 (无数据返回0)
+uint16_t Publish_EncodeHistory(uint8_t *buf, uint16_t cap)
+{
+    batch_encoder_t enc;
+    publish_row_t row;
+    uint16_t period = 0;
+    uint8_t started = 0;
+
+    // 以最旧两行的间隔作为标称行间隔，行间抖动只占行头的几位
+    taskENTER_CRITICAL();
+    if (history_count >= 2) {
+        uint32_t interval = history[(history_head + 1) % PUBLISH_HISTORY_LEN].tick - history[history_head].tick;
+        period = (interval > 0xFFFF) ? 0 : (uint16_t)interval;
+    }
+    taskEXIT_CRITICAL();
+
+    while (1) {
+        taskENTER_CRITICAL();
+        if (history_count == 0) {
+            taskEXIT_CRITICAL();
+            break;
+        }
+        row = history[history_head];
+        taskEXIT_CRITICAL();
+
+        if (!started) {
+            if (!BatchFrame_Begin(&enc, buf, cap, MAX_DS18B20_SENSORS, row.tick, period)) {
+                return 0;
+            }
+            started = 1;
+        }
+        if (!BatchFrame_AddRow(&enc, row.tick, row.mask, row.raw)) {
+            break;  // 帧已满，剩余的行留到下一帧
+        }
+
+        taskENTER_CRITICAL();
+        history_head = (uint8_t)((history_head + 1) % PUBLISH_HISTORY_LEN);
+        history_count--;
+        taskEXIT_CRITICAL();
+    }
+
+    return started ? BatchFrame_Finish(&enc) : 0;
+}
+
+// 历史队列中待上传的行数，达到PUBLISH_HISTORY_LEN时下一次快照将覆盖最旧的行
+uint8_t Publish_GetHistoryCount(void)
+{
+    return history_count;
+}
+
+uint32_t Publish_GetHistoryDropped(void)
+{
+    return history_dropped;
+}
+
+// 设置位置的死区 (1/16°C)，变化不超过死区且未到最长静默时间时不上报
+uint8_t Publish_SetDeadband(uint8_t position, uint16_t value)
+{
+    if (position >= MAX_DS18B20_SENSORS) return 0;
+
+    // 与Publish_Snapshot的选择在同一临界区内互斥，一次快照只看到一组参数
+    taskENTER_CRITICAL();
+    deadband[position] = value;
+    taskEXIT_CRITICAL();
+    return 1;
+}
+
+// 设置最长静默时间 (ms)，为0时每个周期上报全部位置
+void Publish_SetMaxSilence(uint32_t ms)
+{
+    taskENTER_CRITICAL();
+    max_silence_ms = ms;
+    taskEXIT_CRITICAL();
+}
+
+uint32_t Publish_GetReportSeq(void)
+{
+    return report_seq;
+}
+
+// 把最近一次上报编码为上报帧，返回帧长度 (尚未上报或空间不足返回0)
+uint16_t Publish_EncodeReport(uint8_t *buf, uint16_t cap)
+{
+    int16_t raw[MAX_DS18B20_SENSORS];
+    uint8_t flags[MAX_DS18B20_SENSORS];
+    uint32_t seq, mask, tick;
+
+    taskENTER_CRITICAL();
+    seq = report_seq;
+    mask = report_mask;
+    tick = report_tick;
+    memcpy(raw, reported_raw, sizeof(raw));
+    memcpy(flags, report_flags, sizeof(flags));
+    taskEXIT_CRITICAL();
+
+    if (seq == 0) {
+        return 0;
+    }
+    return BatchFrame_EncodeReport(buf, cap, MAX_DS18B20_SENSORS, seq, tick, mask, flags, raw);
+}
+
+void Publish_GetReportStats(publish_report_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = report_stats;
+    taskEXIT_CRITICAL();
+}
+
+// 打印按变化上报的参数和统计 (统计不清零)
+void Publish_PrintReportStatus(void)
+{
+    publish_report_stats_t stats;
+    uint16_t bands[MAX_DS18B20_SENSORS];
+    uint32_t seq, silence;
+
+    taskENTER_CRITICAL();
+    stats = report_stats;
+    memcpy(bands, deadband, sizeof(bands));
+    seq = report_seq;
+    silence = max_silence_ms;
+    taskEXIT_CRITICAL();
+
+    printf("\r\n--- Report By Exception ---\r\n");
+    printf("Seq %lu, max silence %lu ms\r\n", (unsigned long)seq, (unsigned long)silence);
+    printf("Snapshots %lu, reports %lu, entries %lu of %lu\r\n",
+           (unsigned long)stats.snapshots, (unsigned long)stats.reports,
+           (unsigned long)stats.entries, (unsigned long)stats.candidates);
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        printf("Position %d: deadband %u/16 C\r\n", i + 1, bands[i]);
+    }
+    printf("---------------------------\r\n\n");
+}
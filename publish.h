@@ -0,0 +1,88 @@
+#ifndef __PUBLISH_H
+#define __PUBLISH_H
+#include "sys.h"
+#include "ds18b20.h"
+#include "batch_frame.h"
+
+/**
+ * 发布数据的时间戳与新鲜度统计
+ * 每个位置记录当前发布值对应的转换开始/完成节拍，快照(upload_server_data/lcd_data)时一并冻结，
+ * 样本年龄 = 当前节拍 - 转换完成节拍。
+ * 分别统计快照时(采集链路)和实际上传时(网络链路)的样本年龄，区分延迟回退来自总线还是网络。
+ *
+ * 每次快照把本轮新采到的样本追加到历史队列，由Publish_EncodeHistory编码为批量帧 (见batch_frame.h)，
+ * 队列满时RS485_task在下一次快照之前把全部行编码后从USART2发出
+ *
+ * 按变化上报 (Publish_Snapshot的返回值):
+ *   位置的新值相对上次上报的值变化超过该位置的死区，或距上次上报已达最长静默时间时才上报，
+ *   有上报时顺带上报静默已过半的位置，使各位置的静默上报对齐到同一次唤醒；每次上报序号加1。
+ *   没有位置需要上报时本周期不唤醒上行链路。Publish_EncodeReport把最近一次上报编码为上报帧 (见batch_frame.h)
+ *
+ * Modbus寄存器映射 (Publish_FillRegisters):
+ *   0              位置数量N
+ *   1+3*i          位置i温度 (0.01°C，有符号)
+ *   2+3*i          位置i样本年龄 (100ms，0xFFFF表示无数据或超过量程)
+ *   3+3*i          位置i标志 (bit0=有有效值，bit1/bit2=最近一次上报中因变化/静默超时包含该位置)
+ *   1+3*N, 2+3*N   最近一次上报的序号 (低16位, 高16位)
+ * USART2的Modbus从站收到一帧后调用Publish_HandleModbus (功能码0x03)，把返回的应答帧原样发回总线
+ */
+
+#define PUBLISH_AGE_BUCKET_MS       100     // 年龄直方图每格宽度
+#define PUBLISH_AGE_BUCKETS         64      // 直方图格数，最后一格包含更老的样本
+#define PUBLISH_REG_AGE_UNIT_MS     100     // 寄存器中年龄的单位
+#define PUBLISH_REG_PER_POSITION    3
+#define PUBLISH_REG_COUNT           (1 + PUBLISH_REG_PER_POSITION * MAX_DS18B20_SENSORS + 2)
+
+#define PUBLISH_MODBUS_REQ_SIZE     8       // 地址、功能码、起始寄存器、数量、CRC
+#define PUBLISH_MODBUS_EXC_SIZE     5       // 异常应答
+#define PUBLISH_MODBUS_RESP_MAX     (5 + 2 * PUBLISH_REG_COUNT)
+#define PUBLISH_MODBUS_FC_READ_HOLDING 0x03
+#define PUBLISH_MODBUS_EXC_FUNCTION 0x01    // 不支持的功能码
+#define PUBLISH_MODBUS_EXC_ADDRESS  0x02    // 寄存器范围超出映射
+
+#define PUBLISH_FLAG_VALID          0x0001
+#define PUBLISH_FLAG_CHANGED        0x0002
+#define PUBLISH_FLAG_SILENCE        0x0004
+
+#define PUBLISH_DEADBAND_DEFAULT    2       // 默认死区 (1/16°C，即0.125°C)
+#define PUBLISH_MAX_SILENCE_MS      60000   // 最长静默时间，到期后即使未变化也上报一次
+#define PUBLISH_REPORT_FRAME_MAX    (BATCH_REPORT_HEADER_SIZE + BATCH_REPORT_ENTRY_SIZE * MAX_DS18B20_SENSORS + \
+                                     BATCH_FRAME_CRC_SIZE)
+
+#define PUBLISH_HISTORY_LEN         32      // 待批量上传的历史行数，满时覆盖最旧的行
+#define PUBLISH_HISTORY_FRAME_MAX   256     // 一个批量帧的缓冲区，放不下的行留到下一帧
+
+// 样本年龄统计
+typedef struct {
+    uint32_t count;               // 样本数
+    uint32_t max_ms;              // 最大年龄
+    uint32_t hist[PUBLISH_AGE_BUCKETS]; // 年龄直方图
+} publish_age_stats_t;
+
+// 按变化上报统计
+typedef struct {
+    uint32_t snapshots;           // 快照次数 (采集周期)
+    uint32_t reports;             // 上报次数 (上行链路唤醒)
+    uint32_t entries;             // 上报的位置数
+    uint32_t candidates;          // 快照时有有效值的位置数 (全量上传时的条目数)
+} publish_report_stats_t;
+
+void Publish_Init(void);
+void Publish_Update(uint8_t position, int16_t raw, const ds18b20_stamp_t *stamp);
+uint32_t Publish_Snapshot(void);
+void Publish_RecordUpload(void);
+uint32_t Publish_GetAgeMs(uint8_t position);
+uint8_t Publish_FillRegisters(uint16_t *regs, uint8_t max_regs);
+uint16_t Publish_HandleModbus(uint8_t addr, const uint8_t *req, uint16_t len, uint8_t *resp, uint16_t cap);
+void Publish_PrintStats(void);
+uint16_t Publish_EncodeHistory(uint8_t *buf, uint16_t cap);
+uint8_t Publish_GetHistoryCount(void);
+uint32_t Publish_GetHistoryDropped(void);
+uint8_t Publish_SetDeadband(uint8_t position, uint16_t deadband);
+void Publish_SetMaxSilence(uint32_t ms);
+uint32_t Publish_GetReportSeq(void);
+uint16_t Publish_EncodeReport(uint8_t *buf, uint16_t cap);
+void Publish_GetReportStats(publish_report_stats_t *stats);
+void Publish_PrintReportStatus(void);
+
+#endif
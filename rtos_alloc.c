@@ -0,0 +1,178 @@
+/**
+ * 任务、队列和信号量的静态/动态分配与栈水位报告
+ * 静态池只向前分配不回收，适合启动时一次性创建的对象
+ */
+
+#include "rtos_alloc.h"
+#include <stdio.h>
+
+#if RTOS_STATIC_ALLOC && !configSUPPORT_STATIC_ALLOCATION
+#error "RTOS_STATIC_ALLOC requires configSUPPORT_STATIC_ALLOCATION"
+#endif
+
+// 已登记的任务
+typedef struct {
+    TaskHandle_t handle;
+    const char *name;
+    uint16_t stack_words;
+} rtos_alloc_task_t;
+
+static rtos_alloc_task_t alloc_tasks[RTOS_ALLOC_TASK_MAX];
+static uint8_t alloc_task_count = 0;
+
+#if RTOS_STATIC_ALLOC
+static StackType_t alloc_stack_pool[RTOS_ALLOC_STACK_WORDS];
+static uint16_t alloc_stack_used = 0;
+static StaticTask_t alloc_tcb[RTOS_ALLOC_TASK_MAX];
+static uint8_t alloc_queue_pool[RTOS_ALLOC_QUEUE_BYTES];
+static uint16_t alloc_queue_used = 0;
+static StaticQueue_t alloc_queue_cb[RTOS_ALLOC_QUEUE_MAX];
+static uint8_t alloc_queue_count = 0;
+
+// 空闲任务 (和定时器任务) 的内存也由应用提供
+static StaticTask_t idle_tcb;
+static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_words)
+{
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *stack_words = configMINIMAL_STACK_SIZE;
+}
+
+#if configUSE_TIMERS
+static StaticTask_t timer_tcb;
+static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **tcb, StackType_t **stack, uint32_t *stack_words)
+{
+    *tcb = &timer_tcb;
+    *stack = timer_stack;
+    *stack_words = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+#endif
+
+// 创建任务并登记，返回pdPASS表示成功
+BaseType_t RtosAlloc_TaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_words,
+                                void *param, UBaseType_t prio, TaskHandle_t *handle)
+{
+    TaskHandle_t created = NULL;
+
+    if (alloc_task_count >= RTOS_ALLOC_TASK_MAX) {
+        printf("%s create Err! (task table full)\r\n", name);
+        return pdFAIL;
+    }
+
+#if RTOS_STATIC_ALLOC
+    if (alloc_stack_used + stack_words > RTOS_ALLOC_STACK_WORDS) {
+        printf("%s create Err! (stack pool %u/%u words)\r\n", name,
+               alloc_stack_used + stack_words, RTOS_ALLOC_STACK_WORDS);
+        return pdFAIL;
+    }
+    created = xTaskCreateStatic(fn, name, stack_words, param, prio,
+                                &alloc_stack_pool[alloc_stack_used], &alloc_tcb[alloc_task_count]);
+    alloc_stack_used += stack_words;
+#else
+    if (xTaskCreate(fn, name, stack_words, param, prio, &created) != pdPASS) {
+        created = NULL;
+    }
+#endif
+    if (created == NULL) {
+        printf("%s create Err!\r\n", name);
+        return pdFAIL;
+    }
+
+    alloc_tasks[alloc_task_count].handle = created;
+    alloc_tasks[alloc_task_count].name = name;
+    alloc_tasks[alloc_task_count].stack_words = stack_words;
+    alloc_task_count++;
+    if (handle != NULL) {
+        *handle = created;
+    }
+    return pdPASS;
+}
+
+// 删除任务 (可删除自身)，先取消登记，报告时不再访问已删除的任务
+void RtosAlloc_TaskDelete(TaskHandle_t handle)
+{
+    TaskHandle_t target = (handle != NULL) ? handle : xTaskGetCurrentTaskHandle();
+
+    for (uint8_t i = 0; i < alloc_task_count; i++) {
+        if (alloc_tasks[i].handle == target) {
+            alloc_tasks[i].handle = NULL;
+            break;
+        }
+    }
+    vTaskDelete(handle);
+}
+
+QueueHandle_t RtosAlloc_QueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+#if RTOS_STATIC_ALLOC
+    uint32_t bytes = (uint32_t)length * item_size;
+    QueueHandle_t queue;
+
+    if (alloc_queue_count >= RTOS_ALLOC_QUEUE_MAX || alloc_queue_used + bytes > RTOS_ALLOC_QUEUE_BYTES) {
+        printf("queue create Err! (pool %lu/%u bytes)\r\n",
+               (unsigned long)(alloc_queue_used + bytes), RTOS_ALLOC_QUEUE_BYTES);
+        return NULL;
+    }
+    queue = xQueueCreateStatic(length, item_size, &alloc_queue_pool[alloc_queue_used],
+                               &alloc_queue_cb[alloc_queue_count++]);
+    // 下一个存储区按4字节对齐
+    alloc_queue_used = (uint16_t)((alloc_queue_used + bytes + 3u) & ~3u);
+    return queue;
+#else
+    return xQueueCreate(length, item_size);
+#endif
+}
+
+SemaphoreHandle_t RtosAlloc_SemaphoreCreateBinary(void)
+{
+#if RTOS_STATIC_ALLOC
+    if (alloc_queue_count >= RTOS_ALLOC_QUEUE_MAX) {
+        printf("semaphore create Err! (pool full)\r\n");
+        return NULL;
+    }
+    return xSemaphoreCreateBinaryStatic(&alloc_queue_cb[alloc_queue_count++]);
+#else
+    return xSemaphoreCreateBinary();
+#endif
+}
+
+SemaphoreHandle_t RtosAlloc_MutexCreate(void)
+{
+#if RTOS_STATIC_ALLOC
+    if (alloc_queue_count >= RTOS_ALLOC_QUEUE_MAX) {
+        printf("mutex create Err! (pool full)\r\n");
+        return NULL;
+    }
+    return xSemaphoreCreateMutexStatic(&alloc_queue_cb[alloc_queue_count++]);
+#else
+    return xSemaphoreCreateMutex();
+#endif
+}
+
+// 打印各任务栈大小与最高水位 (剩余的最小字数)，以及堆和静态池的使用情况
+void RtosAlloc_PrintStacks(void)
+{
+    printf("STACKS tasks=%u\r\n", alloc_task_count);
+    for (uint8_t i = 0; i < alloc_task_count; i++) {
+        uint16_t free_words;
+
+        if (alloc_tasks[i].handle == NULL) {
+            continue;
+        }
+        free_words = (uint16_t)uxTaskGetStackHighWaterMark(alloc_tasks[i].handle);
+        printf("  %-20s stack=%u used_max=%u free_min=%u%s\r\n", alloc_tasks[i].name,
+               alloc_tasks[i].stack_words, alloc_tasks[i].stack_words - free_words, free_words,
+               (free_words < alloc_tasks[i].stack_words / 8) ? " LOW" : "");
+    }
+    printf("  heap free=%u min_ever=%u\r\n",
+           (unsigned)xPortGetFreeHeapSize(), (unsigned)xPortGetMinimumEverFreeHeapSize());
+#if RTOS_STATIC_ALLOC
+    printf("  static stack=%u/%u words queue=%u/%u bytes\r\n",
+           alloc_stack_used, RTOS_ALLOC_STACK_WORDS, alloc_queue_used, RTOS_ALLOC_QUEUE_BYTES);
+#endif
+}
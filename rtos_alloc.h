@@ -0,0 +1,36 @@
+#ifndef __RTOS_ALLOC_H
+#define __RTOS_ALLOC_H
+#include "sys.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+/**
+ * 任务、队列、信号量和互斥量的统一创建入口
+ * RTOS_STATIC_ALLOC为1时全部从下面的静态池分配 (xTaskCreateStatic等)，不占用FreeRTOS堆，
+ * 链接后的RAM占用即全部开销；为0时沿用动态分配。两种方式都登记任务，STACKS命令据此报告
+ * 各任务栈的最高水位和堆的历史最小剩余，用于按实测值调整栈大小
+ * (需要INCLUDE_uxTaskGetStackHighWaterMark为1，堆统计需要heap_4/heap_5)
+ */
+
+#ifndef RTOS_STATIC_ALLOC
+#define RTOS_STATIC_ALLOC           0       // 1需要FreeRTOSConfig.h中configSUPPORT_STATIC_ALLOCATION为1
+#endif
+
+#define RTOS_ALLOC_TASK_MAX         10      // 登记的任务数上限
+#define RTOS_ALLOC_STACK_WORDS      2688    // 静态模式: 全部任务栈 (字，含start_task)
+#define RTOS_ALLOC_QUEUE_BYTES      768     // 静态模式: 全部队列存储区 (总线请求队列2x8项)
+#define RTOS_ALLOC_QUEUE_MAX        5       // 静态模式: 队列、信号量和互斥量控制块数
+
+#define WATCHDOG_STK_SIZE           64      // 喂狗任务栈 (字)
+
+BaseType_t RtosAlloc_TaskCreate(TaskFunction_t fn, const char *name, uint16_t stack_words,
+                                void *param, UBaseType_t prio, TaskHandle_t *handle);
+void RtosAlloc_TaskDelete(TaskHandle_t handle);
+QueueHandle_t RtosAlloc_QueueCreate(UBaseType_t length, UBaseType_t item_size);
+SemaphoreHandle_t RtosAlloc_SemaphoreCreateBinary(void);
+SemaphoreHandle_t RtosAlloc_MutexCreate(void);
+void RtosAlloc_PrintStacks(void);
+
+#endif
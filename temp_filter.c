@@ -0,0 +1,158 @@
+/**
+ * 每个位置的定点温度滤波
+ * 中值窗口最多5点，排序使用固定次数的比较交换，单个样本的处理时间有上界，
+ * 因此RS485_task中的滤波整个在临界区内执行，配置任务中的OWFILT修改参数时不会与之交错
+ */
+
+#include "temp_filter.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+static temp_filter_cfg_t filter_cfg[MAX_DS18B20_SENSORS];
+static temp_filter_state_t filter_state[MAX_DS18B20_SENSORS];
+
+// 求窗口中值 (n<=5，插入排序)
+static int16_t temp_filter_median(const temp_filter_state_t *st)
+{
+    int16_t sorted[TEMP_FILTER_MEDIAN_MAX];
+
+    for (uint8_t i = 0; i < st->count; i++) {
+        int16_t v = st->window[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[st->count / 2];
+}
+
+void TempFilter_Init(void)
+{
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        filter_cfg[i].median_n = TEMP_FILTER_DEFAULT_MEDIAN;
+        filter_cfg[i].ema_shift = TEMP_FILTER_DEFAULT_EMA;
+        filter_cfg[i].max_slew = TEMP_FILTER_DEFAULT_SLEW;
+    }
+    memset(filter_state, 0, sizeof(filter_state));
+}
+
+// 清除位置的滤波历史 (传感器更换或重新映射后调用)
+void TempFilter_Reset(uint8_t position)
+{
+    if (position >= MAX_DS18B20_SENSORS) return;
+    taskENTER_CRITICAL();
+    memset(&filter_state[position], 0, sizeof(temp_filter_state_t));
+    taskEXIT_CRITICAL();
+}
+
+uint8_t TempFilter_SetConfig(uint8_t position, const temp_filter_cfg_t *cfg)
+{
+    if (position >= MAX_DS18B20_SENSORS || cfg->median_n == 0 ||
+        cfg->median_n > TEMP_FILTER_MEDIAN_MAX || (cfg->median_n & 1) == 0 ||
+        cfg->ema_shift > 8) {
+        return 0;
+    }
+    taskENTER_CRITICAL();
+    filter_cfg[position] = *cfg;
+    memset(&filter_state[position], 0, sizeof(temp_filter_state_t));
+    taskEXIT_CRITICAL();
+    return 1;
+}
+
+void TempFilter_GetConfig(uint8_t position, temp_filter_cfg_t *cfg)
+{
+    if (position >= MAX_DS18B20_SENSORS) return;
+    taskENTER_CRITICAL();
+    *cfg = filter_cfg[position];
+    taskEXIT_CRITICAL();
+}
+
+// 按参数处理一个原始样本 (在临界区内调用)
+static uint8_t temp_filter_process(const temp_filter_cfg_t *cfg, temp_filter_state_t *st, int16_t raw,
+                                   int16_t *output)
+{
+    int16_t value;
+
+    if (raw < TEMP_FILTER_RAW_MIN || raw > TEMP_FILTER_RAW_MAX) {
+        st->rejected_range++;
+        return TEMP_FILTER_REJECT_RANGE;
+    }
+
+    // 85°C是上电后未转换的暂存器值: 与当前输出相差较大时需连续确认
+    if (raw == TEMP_FILTER_POR_RAW) {
+        int16_t diff = st->valid ? (int16_t)(raw - st->output) : TEMP_FILTER_RAW_MAX;
+        if ((diff > 16 || diff < -16) && ++st->por_count < TEMP_FILTER_POR_CONFIRM) {
+            st->rejected_por++;
+            return TEMP_FILTER_REJECT_POR;
+        }
+    } else {
+        st->por_count = 0;
+    }
+
+    // 中值去尖峰
+    st->window[st->head] = raw;
+    st->head = (uint8_t)((st->head + 1) % cfg->median_n);
+    if (st->count < cfg->median_n) {
+        st->count++;
+    }
+    value = temp_filter_median(st);
+
+    if (!st->valid) {
+        st->valid = 1;
+        st->slewed = value;
+        st->ema = (int32_t)value << TEMP_FILTER_EMA_FRAC;
+    } else {
+        // 斜率限制
+        int32_t step = (int32_t)value - st->slewed;
+        if (cfg->max_slew != 0 && (step > cfg->max_slew || step < -(int32_t)cfg->max_slew)) {
+            step = (step > 0) ? cfg->max_slew : -(int32_t)cfg->max_slew;
+            st->slew_limited++;
+        }
+        st->slewed = (int16_t)(st->slewed + step);
+
+        // EMA: ema += (x - ema) / 2^shift
+        st->ema += (((int32_t)st->slewed << TEMP_FILTER_EMA_FRAC) - st->ema) >> cfg->ema_shift;
+    }
+
+    // 四舍五入去掉小数位
+    st->output = (int16_t)((st->ema + (1 << (TEMP_FILTER_EMA_FRAC - 1))) >> TEMP_FILTER_EMA_FRAC);
+    *output = st->output;
+    return TEMP_FILTER_OK;
+}
+
+// 处理一个原始样本，返回TEMP_FILTER_OK时output为新的滤波值
+uint8_t TempFilter_Update(uint8_t position, int16_t raw, int16_t *output)
+{
+    uint8_t status;
+
+    if (position >= MAX_DS18B20_SENSORS) return TEMP_FILTER_REJECT_RANGE;
+
+    taskENTER_CRITICAL();
+    status = temp_filter_process(&filter_cfg[position], &filter_state[position], raw, output);
+    taskEXIT_CRITICAL();
+    return status;
+}
+
+// 打印各位置的滤波参数和剔除统计
+void TempFilter_PrintStatus(void)
+{
+    for (uint8_t i = 0; i < MAX_DS18B20_SENSORS; i++) {
+        temp_filter_cfg_t cfg;
+        temp_filter_state_t st;
+
+        taskENTER_CRITICAL();
+        cfg = filter_cfg[i];
+        st = filter_state[i];
+        taskEXIT_CRITICAL();
+        printf("Position %d: median %d, slew %d/16C, ema 1/%d, out %d/16C%s, range %lu, por %lu, slew %lu\r\n",
+               i + 1, cfg.median_n, cfg.max_slew, 1 << cfg.ema_shift,
+               st.output, st.valid ? "" : " (none)",
+               (unsigned long)st.rejected_range,
+               (unsigned long)st.rejected_por,
+               (unsigned long)st.slew_limited);
+    }
+}
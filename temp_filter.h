@@ -0,0 +1,58 @@
+#ifndef __TEMP_FILTER_H
+#define __TEMP_FILTER_H
+#include "sys.h"
+#include "ds18b20.h"
+
+/**
+ * 每个位置的温度滤波 (定点，单位1/16°C)
+ * 采集结果依次经过: 范围检查 -> 上电85°C剔除 -> 中值去尖峰 -> 斜率限制 -> EMA平滑
+ * 每个样本O(1)处理，只使用整数运算
+ */
+
+#define TEMP_FILTER_MEDIAN_MAX      5       // 中值窗口最大长度
+#define TEMP_FILTER_EMA_FRAC        4       // EMA累加器小数位数
+#define TEMP_FILTER_POR_RAW         0x0550  // 上电复位值85°C
+#define TEMP_FILTER_POR_CONFIRM     3       // 连续读到85°C多少次后才接受
+#define TEMP_FILTER_RAW_MIN         (-55 * 16)
+#define TEMP_FILTER_RAW_MAX         (125 * 16)
+
+// 默认参数: 3点中值，每个样本最多变化2°C，EMA系数1/2
+#define TEMP_FILTER_DEFAULT_MEDIAN  3
+#define TEMP_FILTER_DEFAULT_SLEW    32
+#define TEMP_FILTER_DEFAULT_EMA     1
+
+// 样本处理结果
+#define TEMP_FILTER_OK              0       // 已更新输出
+#define TEMP_FILTER_REJECT_RANGE    1       // 超出-55~125°C
+#define TEMP_FILTER_REJECT_POR      2       // 疑似上电复位值85°C
+
+// 单个位置的滤波参数
+typedef struct {
+    uint8_t median_n;             // 中值窗口长度 (1/3/5，1为关闭)
+    uint8_t ema_shift;            // EMA系数为2^-ema_shift (0为关闭)
+    uint16_t max_slew;            // 每个样本最大变化量 (1/16°C，0为关闭)
+} temp_filter_cfg_t;
+
+// 单个位置的滤波状态
+typedef struct {
+    int16_t window[TEMP_FILTER_MEDIAN_MAX]; // 最近的原始样本
+    uint8_t head;                 // 下一个写入位置
+    uint8_t count;                // 窗口中有效样本数
+    uint8_t valid;                // 输出是否有效
+    uint8_t por_count;            // 连续读到85°C的次数
+    int32_t ema;                  // EMA累加器 (1/16°C << TEMP_FILTER_EMA_FRAC)
+    int16_t slewed;               // 斜率限制后的值
+    int16_t output;               // 滤波输出 (1/16°C)
+    uint32_t rejected_range;      // 超范围剔除次数
+    uint32_t rejected_por;        // 85°C剔除次数
+    uint32_t slew_limited;        // 斜率限制次数
+} temp_filter_state_t;
+
+void TempFilter_Init(void);
+void TempFilter_Reset(uint8_t position);
+uint8_t TempFilter_SetConfig(uint8_t position, const temp_filter_cfg_t *cfg);
+void TempFilter_GetConfig(uint8_t position, temp_filter_cfg_t *cfg);
+uint8_t TempFilter_Update(uint8_t position, int16_t raw, int16_t *output);
+void TempFilter_PrintStatus(void);
+
+#endif